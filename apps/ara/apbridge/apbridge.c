@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <arch/irq.h>
 #include <nuttx/usb/apb_es1.h>
 #include <apps/greybus-utils/utils.h>
 #include <apps/ara/service_mgr.h>
@@ -55,6 +56,7 @@
 static struct apbridge_dev_s *g_usbdev = NULL;
 static pthread_t g_svc_thread;
 static struct apbridge_backend apbridge_backend;
+static struct apbridge_stats g_stats;
 
 static int release_buffer(int status, const void *buf, void *priv)
 {
@@ -65,6 +67,7 @@ static int usb_to_unipro(struct apbridge_dev_s *dev, void *buf, size_t len)
 {
     struct gb_operation_hdr *hdr = buf;
     unsigned int cportid;
+    int ret;
 
     gb_dump(buf, len);
 
@@ -78,8 +81,21 @@ static int usb_to_unipro(struct apbridge_dev_s *dev, void *buf, size_t len)
     hdr->pad[0] = 0;
     hdr->pad[1] = 0;
 
-    return apbridge_backend.usb_to_unipro(cportid, buf, len,
-                                          release_buffer, dev);
+    ret = apbridge_backend.usb_to_unipro(cportid, buf, len,
+                                         release_buffer, dev);
+    if (ret == -EAGAIN) {
+        /* The USB driver keeps the message, so that it can be sent again */
+        hdr->pad[0] = cportid & 0xff;
+        hdr->pad[1] = (cportid >> 8) & 0xff;
+        g_stats.out_throttled++;
+    } else if (ret < 0) {
+        g_stats.out_errors++;
+    } else {
+        g_stats.out_messages++;
+        g_stats.out_bytes += len;
+    }
+
+    return ret;
 }
 
 static int usb_to_svc(struct apbridge_dev_s *dev, void *buf, size_t len)
@@ -99,6 +115,7 @@ static int recv_from_svc(void *buf, size_t len)
 int recv_from_unipro(unsigned int cportid, void *buf, size_t len)
 {
     struct gb_operation_hdr *hdr = (void *)buf;
+    int ret;
 
     /*
      * FIXME: Remove when UniPro driver provides the actual buffer length.
@@ -113,7 +130,38 @@ int recv_from_unipro(unsigned int cportid, void *buf, size_t len)
         hdr->pad[1] = (cportid >> 8) & 0xff;
     }
 
-    return unipro_to_usb(g_usbdev, buf, len);
+    ret = unipro_to_usb(g_usbdev, buf, len);
+    if (ret < 0) {
+        g_stats.in_errors++;
+    } else {
+        g_stats.in_messages++;
+        g_stats.in_bytes += len;
+    }
+
+    return ret;
+}
+
+void apbridge_get_stats(struct apbridge_stats *stats)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    *stats = g_stats;
+    irqrestore(flags);
+}
+
+void apbridge_reset_stats(void)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    memset(&g_stats, 0, sizeof(g_stats));
+    irqrestore(flags);
+}
+
+void unipro_writable(unsigned int cportid)
+{
+    usb_unthrottle(g_usbdev, cportid);
 }
 
 static void manifest_event(unsigned char *manifest_file,
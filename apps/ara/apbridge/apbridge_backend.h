@@ -29,6 +29,7 @@
 #ifndef APBRIDGE_BACKEND_H
 #define APBRIDGE_BACKEND_H
 
+#include <stdint.h>
 #include <arch/tsb/unipro.h>
 
 struct apbridge_backend {
@@ -39,7 +40,24 @@ struct apbridge_backend {
     void (*init)(void);
 };
 
+struct apbridge_stats {
+    /* USB to UniPro, throttled counts the messages the backend refused */
+    uint32_t out_messages;
+    uint32_t out_bytes;
+    uint32_t out_throttled;
+    uint32_t out_errors;
+
+    /* UniPro to USB */
+    uint32_t in_messages;
+    uint32_t in_bytes;
+    uint32_t in_errors;
+};
+
+void apbridge_get_stats(struct apbridge_stats *stats);
+void apbridge_reset_stats(void);
+
 int recv_from_unipro(unsigned int cportid, void *buf, size_t len);
+void unipro_writable(unsigned int cportid);
 void apbridge_backend_register(struct apbridge_backend *apbridge_backend);
 
 #endif /* APBRIDGE_BACKEND_H */
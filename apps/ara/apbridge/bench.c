@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Forwarding throughput monitor: samples the bridge counters while the host
+ * pushes traffic through it (e.g. gb_loopback on the AP), and reports the
+ * rate of each direction.
+ */
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arch/tsb/unipro.h>
+
+#include "apbridge_backend.h"
+
+#define DEFAULT_INTERVAL_MS     1000
+#define DEFAULT_SAMPLES         10
+
+static void show_usage(const char *appname)
+{
+    printf("%s [-i interval_ms] [-n samples] [-r]\n", appname);
+    printf("\treport the USB to UniPro (out) and UniPro to USB (in)\n");
+    printf("\tthroughput every 'interval_ms', 'samples' times,\n");
+    printf("\t-r to reset the counters first\n");
+}
+
+static uint64_t now_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t per_sec(uint32_t count, uint64_t usec)
+{
+    return usec ? (uint64_t) count * 1000000 / usec : 0;
+}
+
+#ifdef CONFIG_APBRIDGEA_UNIPRO
+static void print_cport_stats(void)
+{
+    struct unipro_tx_stats stats;
+    unsigned int i;
+
+    printf("%5s %8s %10s %8s %6s %8s %9s\n", "cport", "messages", "bytes",
+           "rejected", "max_q", "max_qb", "avg_delay");
+
+    for (i = 0; i < CPORT_MAX; i++) {
+        if (unipro_get_tx_stats(i, &stats) || !stats.messages)
+            continue;
+
+        printf("%5u %8u %10u %8u %6u %8u %9llu\n", i, stats.messages,
+               stats.bytes, stats.rejected, stats.max_queued_msgs,
+               stats.max_queued_bytes, stats.total_delay / stats.messages);
+    }
+}
+#endif
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int apbridge_bench_main(int argc, char *argv[])
+#endif
+{
+    struct apbridge_stats prev, cur;
+    unsigned int interval = DEFAULT_INTERVAL_MS;
+    unsigned int samples = DEFAULT_SAMPLES;
+    uint64_t start, last, now;
+    uint32_t out_bytes = 0;
+    uint32_t in_bytes = 0;
+    unsigned int i;
+    int opt;
+
+    optind = -1;
+    while ((opt = getopt(argc, argv, "i:n:r")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval = strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            samples = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            apbridge_reset_stats();
+#ifdef CONFIG_APBRIDGEA_UNIPRO
+            for (i = 0; i < CPORT_MAX; i++)
+                unipro_reset_tx_stats(i);
+#endif
+            break;
+        default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!interval || !samples) {
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%8s %10s %10s %9s %10s %10s\n", "", "out msg/s", "out B/s",
+           "throttled", "in msg/s", "in B/s");
+
+    apbridge_get_stats(&prev);
+    start = last = now_usec();
+
+    for (i = 0; i < samples; i++) {
+        usleep(interval * 1000);
+
+        apbridge_get_stats(&cur);
+        now = now_usec();
+
+        printf("%8u %10u %10u %9u %10u %10u\n", i + 1,
+               per_sec(cur.out_messages - prev.out_messages, now - last),
+               per_sec(cur.out_bytes - prev.out_bytes, now - last),
+               cur.out_throttled - prev.out_throttled,
+               per_sec(cur.in_messages - prev.in_messages, now - last),
+               per_sec(cur.in_bytes - prev.in_bytes, now - last));
+
+        out_bytes += cur.out_bytes - prev.out_bytes;
+        in_bytes += cur.in_bytes - prev.in_bytes;
+        prev = cur;
+        last = now;
+    }
+
+    printf("average: out %u B/s, in %u B/s, %u errors\n",
+           per_sec(out_bytes, last - start), per_sec(in_bytes, last - start),
+           cur.out_errors + cur.in_errors);
+
+#ifdef CONFIG_APBRIDGEA_UNIPRO
+    print_cport_stats();
+#endif
+
+    return EXIT_SUCCESS;
+}
@@ -59,6 +59,7 @@ static int unipro_usb_to_svc(void *buf, size_t len)
 static struct unipro_driver unipro_driver = {
     .name = "APBridge",
     .rx_handler = recv_from_unipro,
+    .tx_writable = unipro_writable,
 };
 
 static void unipro_backend_init(void)
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arch/byteorder.h>
+#include <arch/tsb/unipro.h>
+#include <nuttx/greybus/greybus.h>
+#include <nuttx/greybus/fabric.h>
+
+#define GB_FABRIC_RESPONSE_FLAG     0x80
+#define GB_FABRIC_TIMEOUT_SEC       5
+#define GB_FABRIC_MAX_PAYLOAD       (CPORT_BUF_SIZE - \
+                                     sizeof(struct gb_operation_hdr))
+
+struct gb_fabric_bench {
+    uint8_t type;
+    unsigned int window;
+    sem_t window_sem;
+
+    /* send time of the outstanding requests, indexed by id % window */
+    uint64_t *sent;
+    uint32_t *samples;
+    unsigned int nsamples;
+    unsigned int errors;
+    size_t rx_bytes;
+};
+
+static uint64_t gb_fabric_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void show_usage(const char *appname)
+{
+    printf("%s link [-b bytes_per_sec] [-l latency_usec]\n", appname);
+    printf("\tshow or change the link parameters, 0 for no limit\n");
+    printf("%s stats [-r]\n", appname);
+    printf("\tshow the link counters, -r to reset them\n");
+    printf("%s bench -c cport -t type [-p hex] [-n count] [-W window]\n",
+           appname);
+    printf("\tsend 'count' requests of 'type' with payload 'hex' to the\n");
+    printf("\tdriver on 'cport', at most 'window' at a time, and report\n");
+    printf("\tthe request rate and the latency\n");
+}
+
+static void gb_fabric_bench_rx(unsigned int cport, const void *buf,
+                               size_t len, void *priv)
+{
+    struct gb_fabric_bench *bench = priv;
+    const struct gb_operation_hdr *hdr = buf;
+    uint16_t id;
+
+    if (len < sizeof(*hdr) ||
+        hdr->type != (bench->type | GB_FABRIC_RESPONSE_FLAG)) {
+        return;
+    }
+
+    id = le16_to_cpu(hdr->id);
+    if (hdr->result) {
+        bench->errors++;
+    } else {
+        bench->samples[bench->nsamples++] =
+            gb_fabric_now() - bench->sent[id % bench->window];
+    }
+    bench->rx_bytes += len;
+
+    sem_post(&bench->window_sem);
+}
+
+static int gb_fabric_bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* nearest-rank percentile of a sorted sample array */
+static uint32_t gb_fabric_bench_pct(uint32_t *samples, unsigned n,
+                                    unsigned pct)
+{
+    unsigned rank = (n * pct + 99) / 100;
+
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+static int gb_fabric_bench_run(unsigned int cport, uint8_t type,
+                               const uint8_t *payload, size_t payload_size,
+                               unsigned int count, unsigned int window)
+{
+    uint8_t msg[sizeof(struct gb_operation_hdr) + GB_FABRIC_MAX_PAYLOAD];
+    struct gb_operation_hdr *hdr = (struct gb_operation_hdr *) msg;
+    size_t len = sizeof(*hdr) + payload_size;
+    struct gb_fabric_bench bench;
+    struct timespec timeout;
+    uint64_t start, elapsed;
+    uint64_t total = 0;
+    unsigned int lost = 0;
+    unsigned int i, n;
+    uint16_t id = 0;
+    int retval;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.type = type;
+    bench.window = window;
+    bench.sent = calloc(window, sizeof(bench.sent[0]));
+    bench.samples = calloc(count, sizeof(bench.samples[0]));
+    if (!bench.sent || !bench.samples) {
+        retval = -ENOMEM;
+        goto out;
+    }
+    sem_init(&bench.window_sem, 0, window);
+
+    retval = gb_fabric_attach_peer(cport, gb_fabric_bench_rx, &bench);
+    if (retval) {
+        fprintf(stderr, "can't attach to CPort %u: %d\n", cport, retval);
+        goto out_sem;
+    }
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->size = cpu_to_le16(len);
+    hdr->type = type;
+    memcpy(msg + sizeof(*hdr), payload, payload_size);
+
+    start = gb_fabric_now();
+    for (i = 0; i < count; i++) {
+        sem_wait(&bench.window_sem);
+
+        /* id 0 is for unidirectional operations */
+        if (++id == 0)
+            id = 1;
+        hdr->id = cpu_to_le16(id);
+        bench.sent[id % window] = gb_fabric_now();
+
+        retval = gb_fabric_peer_send(cport, msg, len);
+        if (retval) {
+            fprintf(stderr, "send failed: %d\n", retval);
+            sem_post(&bench.window_sem);
+            break;
+        }
+    }
+
+    /* wait for the outstanding responses */
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += GB_FABRIC_TIMEOUT_SEC;
+    for (n = 0; n < window; n++) {
+        if (sem_timedwait(&bench.window_sem, &timeout)) {
+            lost = window - n;
+            break;
+        }
+    }
+    elapsed = gb_fabric_now() - start;
+
+    gb_fabric_detach_peer(cport);
+
+    n = bench.nsamples;
+    printf("%u requests, %u errors, %u lost in %llu us\n", i, bench.errors,
+           lost, elapsed);
+    if (n) {
+        qsort(bench.samples, n, sizeof(bench.samples[0]),
+              gb_fabric_bench_cmp);
+        for (i = 0; i < n; i++)
+            total += bench.samples[i];
+
+        printf("latency (us): min %u avg %u p50 %u p99 %u max %u\n",
+               bench.samples[0], (uint32_t) (total / n),
+               gb_fabric_bench_pct(bench.samples, n, 50),
+               gb_fabric_bench_pct(bench.samples, n, 99),
+               bench.samples[n - 1]);
+        printf("%llu requests/s, %llu bytes/s sent, %llu bytes/s received\n",
+               elapsed ? (uint64_t) n * 1000000 / elapsed : 0,
+               elapsed ? (uint64_t) n * len * 1000000 / elapsed : 0,
+               elapsed ? (uint64_t) bench.rx_bytes * 1000000 / elapsed : 0);
+    }
+
+    retval = lost ? -ETIMEDOUT : 0;
+
+out_sem:
+    sem_destroy(&bench.window_sem);
+out:
+    free(bench.sent);
+    free(bench.samples);
+    return retval;
+}
+
+static int gb_fabric_parse_hex(const char *hex, uint8_t *buf, size_t *size)
+{
+    size_t len = strlen(hex);
+    char byte[3] = { 0 };
+    size_t i;
+
+    if (len % 2 || len / 2 > GB_FABRIC_MAX_PAYLOAD)
+        return -EINVAL;
+
+    for (i = 0; i < len / 2; i++) {
+        byte[0] = hex[2 * i];
+        byte[1] = hex[2 * i + 1];
+        buf[i] = strtoul(byte, NULL, 16);
+    }
+    *size = len / 2;
+
+    return 0;
+}
+
+static int gb_fabric_link(int argc, char *argv[])
+{
+    struct gb_fabric_link_cfg cfg;
+    bool set = false;
+    int c;
+
+    gb_fabric_get_link(&cfg);
+
+    while ((c = getopt(argc, argv, "b:l:")) != -1) {
+        switch (c) {
+        case 'b':
+            cfg.bandwidth = strtoul(optarg, NULL, 10);
+            set = true;
+            break;
+        case 'l':
+            cfg.latency = strtoul(optarg, NULL, 10);
+            set = true;
+            break;
+        default:
+            return -EINVAL;
+        }
+    }
+
+    if (set)
+        gb_fabric_set_link(&cfg);
+
+    printf("bandwidth: %u bytes/s, latency: %u us\n", cfg.bandwidth,
+           cfg.latency);
+    return 0;
+}
+
+static void gb_fabric_print_dir(const char *name,
+                                const struct gb_fabric_dir_stats *stats)
+{
+    printf("%-8s %8u %10u %7u %8u %9u\n", name, stats->messages,
+           stats->bytes, stats->dropped, stats->unrouted, stats->max_delay);
+}
+
+static int gb_fabric_stats(int argc, char *argv[])
+{
+    struct gb_fabric_stats stats;
+    int c;
+
+    while ((c = getopt(argc, argv, "r")) != -1) {
+        switch (c) {
+        case 'r':
+            gb_fabric_reset_stats();
+            return 0;
+        default:
+            return -EINVAL;
+        }
+    }
+
+    gb_fabric_get_stats(&stats);
+    printf("%-8s %8s %10s %7s %8s %9s\n", "", "messages", "bytes",
+           "dropped", "unrouted", "max delay");
+    gb_fabric_print_dir("to local", &stats.to_local);
+    gb_fabric_print_dir("to peer", &stats.to_peer);
+
+    return 0;
+}
+
+static int gb_fabric_bench(int argc, char *argv[])
+{
+    uint8_t payload[GB_FABRIC_MAX_PAYLOAD];
+    size_t payload_size = 0;
+    unsigned int count = 1000;
+    unsigned int window = 1;
+    int cport = -1;
+    int type = -1;
+    int c;
+
+    while ((c = getopt(argc, argv, "c:t:p:n:W:")) != -1) {
+        switch (c) {
+        case 'c':
+            cport = strtol(optarg, NULL, 10);
+            break;
+        case 't':
+            type = strtol(optarg, NULL, 0);
+            break;
+        case 'p':
+            if (gb_fabric_parse_hex(optarg, payload, &payload_size))
+                return -EINVAL;
+            break;
+        case 'n':
+            count = strtoul(optarg, NULL, 10);
+            break;
+        case 'W':
+            window = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            return -EINVAL;
+        }
+    }
+
+    if (cport < 0 || type <= 0 || type >= GB_FABRIC_RESPONSE_FLAG ||
+        !count || !window)
+        return -EINVAL;
+
+    return gb_fabric_bench_run(cport, type, payload, payload_size, count,
+                               window);
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int gb_fabric_main(int argc, char *argv[])
+#endif
+{
+    int retval = -EINVAL;
+
+    if (argc < 2) {
+        show_usage(argc != 1 ? "gb_fabric" : argv[0]);
+        return -1;
+    }
+
+    optind = -1;
+    if (!strcmp(argv[1], "link"))
+        retval = gb_fabric_link(argc - 1, argv + 1);
+    else if (!strcmp(argv[1], "stats"))
+        retval = gb_fabric_stats(argc - 1, argv + 1);
+    else if (!strcmp(argv[1], "bench"))
+        retval = gb_fabric_bench(argc - 1, argv + 1);
+
+    if (retval == -EINVAL)
+        show_usage(argv[0]);
+
+    return retval;
+}
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <pthread.h>
+#include <semaphore.h>
 #include <sys/time.h>
 
 #include <nuttx/greybus/loopback.h>
@@ -82,6 +83,14 @@ struct loopback_context {
     int count; /* -1 = infinite */
     int err;
     unsigned sent;
+
+    /* benchmark mode */
+    int bench;
+    unsigned bench_sent;
+    unsigned bench_done;
+    unsigned bench_err;
+    unsigned nsamples;
+    uint32_t *samples;
 };
 
 static void loopback_ctx_lock(struct loopback_context *ctx)
@@ -108,6 +117,7 @@ static void loopback_ctx_list_unlock(void)
 }
 
 static pthread_once_t loopback_init_once = PTHREAD_ONCE_INIT;
+static sem_t loopback_bench_sem;
 
 static int get_cport(int cport, void *data)
 {
@@ -130,6 +140,8 @@ static void loopback_init(void)
 {
     int status;
 
+    sem_init(&loopback_bench_sem, 0, 0);
+
     status = gb_loopback_get_cports(get_cport, NULL);
     if (status < 0)
         fprintf(stderr, "gb_loopback initialization failed: %d\n", status);
@@ -268,6 +280,212 @@ int gb_loopback_service(void)
     return 0;
 }
 
+/*
+ * Benchmark mode: keep up to 'window' requests in flight on every selected
+ * cport, wait for 'count' of them to complete and report the round-trip
+ * latency distribution and the throughput. Each completion posts
+ * loopback_bench_sem so that the sending loop can refill the windows.
+ */
+static void loopback_bench_resp_cb(int cport, int status, uint32_t rtt_usec,
+                                   void *data)
+{
+    struct loopback_context *ctx = data;
+
+    loopback_ctx_lock(ctx);
+    if (status != OK)
+        ctx->bench_err++;
+    else if (ctx->samples)
+        ctx->samples[ctx->nsamples++] = rtt_usec;
+    ctx->bench_done++;
+    loopback_ctx_unlock(ctx);
+
+    sem_post(&loopback_bench_sem);
+}
+
+static int loopback_bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* nearest-rank percentile of a sorted sample array */
+static uint32_t loopback_bench_pct(uint32_t *samples, unsigned n, unsigned pct)
+{
+    unsigned rank = (n * pct + 99) / 100;
+
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+static void loopback_bench_report(struct loopback_context *ctx, size_t size,
+                                  uint64_t elapsed_usec)
+{
+    uint64_t total = 0;
+    unsigned long bps;
+    unsigned i, n = ctx->nsamples;
+
+    if (n == 0) {
+        printf("%7d %7lu %8u %5u %7s %7s %7s %7s %7s %9s\n",
+               ctx->cport, (unsigned long)size, ctx->bench_done, ctx->bench_err,
+               "-", "-", "-", "-", "-", "-");
+        return;
+    }
+
+    qsort(ctx->samples, n, sizeof(ctx->samples[0]), loopback_bench_cmp);
+    for (i = 0; i < n; i++)
+        total += ctx->samples[i];
+
+    /* Request payload bytes per second, echoed data is not accounted */
+    bps = elapsed_usec ? (uint64_t)n * size * 1000000 / elapsed_usec : 0;
+
+    printf("%7d %7lu %8u %5u %7u %7u %7u %7u %7u %5lu.%03lu\n",
+           ctx->cport, (unsigned long)size, ctx->bench_done, ctx->bench_err,
+           ctx->samples[0], (uint32_t)(total / n),
+           loopback_bench_pct(ctx->samples, n, 50),
+           loopback_bench_pct(ctx->samples, n, 99),
+           ctx->samples[n - 1],
+           bps / 1000000, (bps % 1000000) / 1000);
+}
+
+static int loopback_bench_run(int cport, int type, size_t size,
+                              unsigned window, unsigned count)
+{
+    struct timeval tv_start, tv_end, tv_total;
+    struct loopback_context *ctx;
+    struct list_head *iter;
+    uint64_t elapsed = 0;
+    int pending;
+    int status;
+    int rv = 0;
+
+    loopback_ctx_list_lock();
+    list_foreach(&loopback_ctx_list, iter) {
+        ctx = list_entry(iter, struct loopback_context, list);
+        if (cport >= 0 && cport != ctx->cport)
+            continue;
+
+        loopback_ctx_lock(ctx);
+        if (ctx->active) {
+            fprintf(stderr, "cport %d busy, skipping\n", ctx->cport);
+            loopback_ctx_unlock(ctx);
+            continue;
+        }
+
+        ctx->samples = malloc(count * sizeof(ctx->samples[0]));
+        if (!ctx->samples) {
+            loopback_ctx_unlock(ctx);
+            rv = -ENOMEM;
+            break;
+        }
+        ctx->bench = 1;
+        ctx->bench_sent = 0;
+        ctx->bench_done = 0;
+        ctx->bench_err = 0;
+        ctx->nsamples = 0;
+        loopback_ctx_unlock(ctx);
+
+        gb_loopback_reset(ctx->cport);
+        gb_loopback_set_resp_cb(ctx->cport, loopback_bench_resp_cb, ctx);
+    }
+    loopback_ctx_list_unlock();
+
+    if (rv)
+        goto out;
+
+    /* Forget about the completions a previous run did not wait for */
+    while (sem_trywait(&loopback_bench_sem) == 0)
+        ;
+
+    gettimeofday(&tv_start, NULL);
+
+    do {
+        pending = 0;
+
+        loopback_ctx_list_lock();
+        list_foreach(&loopback_ctx_list, iter) {
+            ctx = list_entry(iter, struct loopback_context, list);
+            if (!ctx->bench)
+                continue;
+
+            while (ctx->bench_sent < count &&
+                   gb_loopback_get_outstanding(ctx->cport) < window) {
+                loopback_ctx_lock(ctx);
+                ctx->bench_sent++;
+                loopback_ctx_unlock(ctx);
+
+                status = gb_loopback_send_req(ctx->cport, size, type);
+                if (status != OK) {
+                    /* No completion will come for this one */
+                    loopback_ctx_lock(ctx);
+                    ctx->bench_err++;
+                    ctx->bench_done++;
+                    loopback_ctx_unlock(ctx);
+                    break;
+                }
+            }
+
+            loopback_ctx_lock(ctx);
+            if (ctx->bench_done < count)
+                pending = 1;
+            loopback_ctx_unlock(ctx);
+        }
+        loopback_ctx_list_unlock();
+
+        if (pending)
+            sem_wait(&loopback_bench_sem);
+    } while (pending);
+
+    gettimeofday(&tv_end, NULL);
+    timersub(&tv_end, &tv_start, &tv_total);
+    elapsed = tv_total.tv_sec * (uint64_t)1000000 + tv_total.tv_usec;
+
+out:
+    loopback_ctx_list_lock();
+    list_foreach(&loopback_ctx_list, iter) {
+        ctx = list_entry(iter, struct loopback_context, list);
+        if (!ctx->bench && !ctx->samples)
+            continue;
+
+        gb_loopback_set_resp_cb(ctx->cport, NULL, NULL);
+        if (!rv)
+            loopback_bench_report(ctx, size, elapsed);
+
+        loopback_ctx_lock(ctx);
+        free(ctx->samples);
+        ctx->samples = NULL;
+        ctx->bench = 0;
+        loopback_ctx_unlock(ctx);
+    }
+    loopback_ctx_list_unlock();
+
+    return rv;
+}
+
+static int loopback_bench(int cport, int type, size_t size, size_t max_size,
+                          unsigned window, unsigned count)
+{
+    int status;
+
+    printf("  CPORT    SIZE     REQS   ERR     MIN     AVG     P50     P99"
+           "     MAX      MB/s\n");
+
+    if (type == GB_LOOPBACK_TYPE_PING) {
+        size = 1;
+        max_size = 1;
+    } else if (size == 0) {
+        size = 1;
+    }
+
+    while (1) {
+        status = loopback_bench_run(cport, type, size, window, count);
+        if (status < 0 || size >= max_size)
+            break;
+        size = size * 2 < max_size ? size * 2 : max_size;
+    }
+
+    return status;
+}
+
 #ifdef CONFIG_BUILD_KERNEL
 int main(int argc, FAR char *argv[])
 #else
@@ -278,12 +496,14 @@ int gbl_main(int argc, char *argv[])
     struct loopback_context *ctx;
     struct list_head *iter;
     unsigned wait = 1000;
+    unsigned window = 1;
     const char *cmd;
     size_t size = 1;
+    size_t max_size = 0;
 
     pthread_once(&loopback_init_once, loopback_init);
 
-    while ((opt = getopt (argc, argv, "c:s:t:w:n:")) != -1) {
+    while ((opt = getopt (argc, argv, "c:s:m:t:w:W:n:")) != -1) {
         switch (opt) {
         case 'c':
             st = sscanf(optarg, "%d", &cport);
@@ -295,6 +515,16 @@ int gbl_main(int argc, char *argv[])
             if (st != 1)
                 goto help;
             break;
+        case 'm':
+            st = sscanf(optarg, "%u", &max_size);
+            if (st != 1)
+                goto help;
+            break;
+        case 'W':
+            st = sscanf(optarg, "%u", &window);
+            if (st != 1 || window == 0)
+                goto help;
+            break;
         case 't':
             type = op_type_from_str(optarg);
             if (type < 0)
@@ -341,6 +571,11 @@ int gbl_main(int argc, char *argv[])
 
             if (cport < 0 || cport == ctx->cport) {
                 loopback_ctx_lock(ctx);
+                if (ctx->bench) {
+                    fprintf(stderr, "cport %d busy, skipping\n", ctx->cport);
+                    loopback_ctx_unlock(ctx);
+                    continue;
+                }
                 gb_loopback_reset(ctx->cport);
                 ctx->active = 1;
                 ctx->type = type;
@@ -354,6 +589,31 @@ int gbl_main(int argc, char *argv[])
 
         loopback_ctx_list_unlock();
         loopback_wakeup();
+    } else if (strcmp(cmd, "bench") == 0) {
+        if (type == GB_LOOPBACK_TYPE_NONE) {
+            fprintf(stderr, "operation type must be specified for 'bench'\n");
+            rv = EXIT_FAILURE;
+            goto out;
+        }
+
+        if (max_size < size)
+            max_size = size;
+
+        /* The sweep stops at the largest payload a CPort buffer can carry */
+        if (type != GB_LOOPBACK_TYPE_PING &&
+            max_size > gb_loopback_get_max_size()) {
+            max_size = gb_loopback_get_max_size();
+            if (size > max_size)
+                size = max_size;
+            printf("size capped at %lu bytes\n", (unsigned long)max_size);
+        }
+
+        st = loopback_bench(cport, type, size, max_size, window,
+                            count > 0 ? count : 1000);
+        if (st < 0) {
+            fprintf(stderr, "benchmark failed: %d\n", st);
+            rv = EXIT_FAILURE;
+        }
     } else if (strcmp(cmd, "stop") == 0) {
         loopback_ctx_list_lock();
 
@@ -397,18 +657,25 @@ help:
     printf(
         "Greybus loopback tool\n\n"
         "Usage:\n"
-        "\tgbl [-c CPORT] [-s SIZE] [-t ping|xfer|sink] "
-                        "[-w MS] [-n COUNT] start|stop|status\n\n"
+        "\tgbl [-c CPORT] [-s SIZE] [-m SIZE] [-t ping|xfer|sink] "
+                        "[-w MS] [-W REQS] [-n COUNT] "
+                        "start|stop|status|bench\n\n"
         "\tCommands:\n"
         "\t\tstart:\t\tstart a loopback command on a cport\n"
         "\t\tstop:\t\tstop the command on given cport\n"
-        "\t\tstatus:\t\tshow current status\n\n"
+        "\t\tstatus:\t\tshow current status\n"
+        "\t\tbench:\t\tmeasure latency (us) and throughput, "
+                        "then return\n\n"
         "\tOptions:\n"
         "\t\t-c CPORT:\tcport number (all cports if not given)\n"
         "\t\t-s SIZE:\tdata size in bytes\n"
+        "\t\t-m SIZE:\tbench: sweep sizes, doubling from -s up to SIZE,\n"
+        "\t\t\t\tcapped at the CPort buffer payload size\n"
         "\t\t-t TYPE:\tloopback operation type\n"
         "\t\t-w MS:\t\ttime to wait before sending next request (in ms)\n"
+        "\t\t-W REQS:\tbench: requests in flight per cport (default 1)\n"
         "\t\t-n COUNT:\tnumber of requests to send before stopping\n"
+        "\t\t\t\t(bench: per cport and size, default 1000)\n"
     );
 
     return EXIT_FAILURE;
@@ -36,9 +36,10 @@
 
 static void show_usage(const char *appname)
 {
-    printf("%s [-r filepath] [-p filepath]\n", appname);
+    printf("%s [-r filepath] [-s] [-t] [-p filepath]\n", appname);
     printf("\t-r: tape greybus communication into 'filepath'\n");
     printf("\t-s: stop current taping\n");
+    printf("\t-t: replay with the recorded timing (before -p)\n");
     printf("\t-p: replay greybus tape from 'filepath'\n");
 }
 
@@ -50,6 +51,7 @@ int gb_tape_main(int argc, char *argv[])
 {
     int c;
     int retval;
+    bool timed = false;
 
     if (argc < 2) {
         show_usage(argc != 1 ? "gb_tape" : argv[0]);
@@ -58,9 +60,13 @@ int gb_tape_main(int argc, char *argv[])
 
     optind = -1;
 
+#if defined(CONFIG_GREYBUS_TAPE_ARM_SEMIHOSTING)
     gb_tape_arm_semihosting_register();
+#elif defined(CONFIG_GREYBUS_TAPE_FILE)
+    gb_tape_file_register();
+#endif
 
-    while ((c = getopt(argc, argv, "r:p:s")) != -1) {
+    while ((c = getopt(argc, argv, "r:p:st")) != -1) {
         switch (c) {
         case 'r':
             retval = gb_tape_communication(optarg);
@@ -78,8 +84,12 @@ int gb_tape_main(int argc, char *argv[])
             }
             break;
 
+        case 't':
+            timed = true;
+            break;
+
         case 'p':
-            retval = gb_tape_replay(optarg);
+            retval = gb_tape_replay(optarg, timed);
             if (retval) {
                 fprintf(stderr, "gb_tape: tape replay error: %s\n",
                         strerror(retval));
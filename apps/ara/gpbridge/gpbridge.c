@@ -37,6 +37,7 @@
 #include <pthread.h>
 
 #include <arch/tsb/unipro.h>
+#include <nuttx/greybus/fabric.h>
 #include <apps/greybus-utils/utils.h>
 #include <apps/ara/service_mgr.h>
 #include <apps/ara/gb_loopback.h>
@@ -64,7 +65,11 @@ int bridge_main(int argc, char *argv[])
     int ret;
 
     enable_manifest("IID-1", NULL, 0);
+#ifdef CONFIG_GREYBUS_FABRIC
+    gb_fabric_init();
+#else
     gb_unipro_init();
+#endif
     srvmgr_start(services);
 
     ret = pthread_create(&enable_cports_thread, NULL, enable_cports_fn, NULL);
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Jitter buffer simulator: audio messages sent at a constant rate arrive on
+ * a link that delivers them late and in bursts, are queued in a ring buffer
+ * as the Greybus I2S receiver does, and are played at the nominal rate.
+ * Time is counted in message periods, so runs are reproducible and do not
+ * depend on the system tick.
+ */
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <nuttx/ring_buf.h>
+#include <nuttx/greybus/i2s.h>
+
+#define SILENCE                 UINT32_MAX
+
+#define DEFAULT_MESSAGES        10000
+#define DEFAULT_PERIOD_USEC     1000
+#define DEFAULT_MIN_DEPTH       2
+#define DEFAULT_MAX_DEPTH       32
+
+struct sim {
+    struct ring_buf *wr;
+    struct ring_buf *rd;
+    unsigned int depth;
+
+    /* Playback checks */
+    uint32_t next_seq;
+    uint32_t played;
+    uint32_t silence;
+    uint32_t dry;
+    uint32_t skipped;
+};
+
+static void show_usage(const char *appname)
+{
+    printf("%s [-n messages] [-b burst] [-j jitter] [-l loss_pct]\n",
+           appname);
+    printf("\t[-m min_depth] [-M max_depth] [-p period_usec] [-s seed]\n");
+    printf("\tthe link delivers messages every 'burst' periods, each one\n");
+    printf("\tup to 'jitter' periods late, and loses 'loss_pct' percent\n");
+    printf("\tof them\n");
+}
+
+/* Arrival time of message 'seq', the link keeps the messages in order */
+static uint32_t sim_schedule(uint32_t seq, uint32_t prev, unsigned int burst,
+                             unsigned int jitter)
+{
+    uint32_t arrival;
+
+    arrival = seq + (jitter ? rand() % (jitter + 1) : 0);
+    arrival = ((arrival + burst - 1) / burst) * burst;
+
+    return arrival > prev ? arrival : prev;
+}
+
+static int sim_push(struct sim *sim, uint32_t seq)
+{
+    if (!ring_buf_is_producers(sim->wr))
+        return -ENOSPC;
+
+    ring_buf_reset(sim->wr);
+    *(uint32_t *) ring_buf_put(sim->wr, sizeof(seq)) = seq;
+    ring_buf_pass(sim->wr);
+
+    sim->wr = ring_buf_get_next(sim->wr);
+    sim->depth++;
+
+    return 0;
+}
+
+static void sim_play(struct sim *sim, struct gb_i2s_jitter *jb, bool draining)
+{
+    unsigned int silence;
+    uint32_t seq;
+
+    if (!ring_buf_is_consumers(sim->rd)) {
+        /* Nothing at all to play: the hardware would underrun */
+        sim->dry++;
+        return;
+    }
+
+    seq = *(uint32_t *) ring_buf_get_head(sim->rd);
+    ring_buf_pass(sim->rd);
+    sim->rd = ring_buf_get_next(sim->rd);
+    sim->depth--;
+
+    if (seq == SILENCE) {
+        sim->silence++;
+    } else {
+        if (seq > sim->next_seq)
+            sim->skipped += seq - sim->next_seq;
+        sim->next_seq = seq + 1;
+        sim->played++;
+    }
+
+    /* Once the stream is over, let the buffer drain */
+    silence = gb_i2s_jitter_played(jb, sim->depth);
+    while (!draining && silence-- && !sim_push(sim, SILENCE))
+        ;
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int i2s_jitter_main(int argc, char *argv[])
+#endif
+{
+    struct gb_i2s_jitter_stats stats;
+    struct gb_i2s_jitter jb;
+    struct sim sim = { 0 };
+    struct ring_buf *ring;
+    unsigned int messages = DEFAULT_MESSAGES;
+    unsigned int period = DEFAULT_PERIOD_USEC;
+    unsigned int min_depth = DEFAULT_MIN_DEPTH;
+    unsigned int max_depth = DEFAULT_MAX_DEPTH;
+    unsigned int burst = 1;
+    unsigned int jitter = 0;
+    unsigned int loss = 0;
+    unsigned int seed = 1;
+    uint32_t arrival;
+    uint32_t sent = 0;
+    uint32_t t;
+    bool playing = false;
+    int opt;
+
+    optind = -1;
+    while ((opt = getopt(argc, argv, "n:b:j:l:m:M:p:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            messages = strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            burst = strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            jitter = strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            loss = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            min_depth = strtoul(optarg, NULL, 10);
+            break;
+        case 'M':
+            max_depth = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            period = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!messages || !burst || !max_depth || loss > 100) {
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* One spare entry, so that a full buffer never wraps onto the reader */
+    ring = ring_buf_alloc_ring(max_depth + 1, 0, sizeof(uint32_t), 0,
+                               NULL, NULL, NULL);
+    if (!ring) {
+        fprintf(stderr, "can't allocate the ring\n");
+        return EXIT_FAILURE;
+    }
+
+    sim.wr = ring;
+    sim.rd = ring;
+
+    gb_i2s_jitter_init(&jb, period, min_depth, max_depth);
+    srand(seed);
+
+    /* Message 'sent' is sent at time 'sent' and arrives at 'arrival' */
+    arrival = sim_schedule(0, 0, burst, jitter);
+    for (t = 0; sent < messages || sim.depth; t++) {
+        while (sent < messages && arrival <= t) {
+            if (!loss || (unsigned int) rand() % 100 >= loss) {
+                if (gb_i2s_jitter_arrived(&jb, sim.depth))
+                    sim_push(&sim, sent);
+
+                if (!playing)
+                    playing = gb_i2s_jitter_ready(&jb, sim.depth);
+            }
+
+            sent++;
+            arrival = sim_schedule(sent, arrival, burst, jitter);
+        }
+
+        /* Flush what is left once the stream is over */
+        if (!playing && sent == messages && sim.depth)
+            playing = true;
+
+        if (playing)
+            sim_play(&sim, &jb, sent == messages);
+    }
+
+    gb_i2s_jitter_get_stats(&jb, &stats);
+
+    printf("%u messages over %u periods of %u us\n", messages, t, period);
+    printf("played %u, silence %u, skipped %u, dry %u\n", sim.played,
+           sim.silence, sim.skipped, sim.dry);
+    printf("underruns %u, overruns %u, expansions %u, compressions %u\n",
+           stats.underruns, stats.overruns, stats.expansions,
+           stats.compressions);
+    printf("jitter %u us (peak %u us), target depth %u, max depth %u\n",
+           stats.jitter, stats.peak_jitter, stats.target, stats.max_depth);
+    printf("max latency %u us\n", stats.max_latency);
+
+    ring_buf_free_ring(ring, NULL, NULL);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Ring buffer stress test and benchmark: a producer thread and a consumer
+ * thread move sequence numbers through a ring of struct ring_buf entries,
+ * either one entry at a time with ring_buf_pass() or in batches with the
+ * ring_buf_spsc interface.  Each entry carries a pattern derived from its
+ * sequence number, which the consumer checks.
+ *
+ * Only include/nuttx/ring_buf.h is needed, so the program also runs on a
+ * host, where the two threads really run in parallel:
+ *
+ *   cc -O2 -DRING_BUF_TEST_HOST -Dring_buf_test_main=main \
+ *      -idirafter nuttx/include apps/ara/ring_buf/ring_buf_test.c -lpthread
+ */
+
+#ifndef RING_BUF_TEST_HOST
+#include <nuttx/config.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/ring_buf.h>
+
+#define MAX_ENTRIES             64
+#define PAYLOAD_WORDS           8
+
+#define DEFAULT_COUNT           100000
+#define DEFAULT_ENTRIES         16
+#define DEFAULT_BATCH           8
+
+struct payload {
+    uint32_t seq;
+    uint32_t words[PAYLOAD_WORDS];
+};
+
+struct test {
+    struct ring_buf_spsc q;
+    struct ring_buf *ring;
+    bool batch_mode;
+    unsigned int count;
+    unsigned int batch;
+
+    /* Producer side */
+    uint32_t prod_seed;
+    unsigned int full;
+
+    /* Consumer side */
+    uint32_t cons_seed;
+    unsigned int empty;
+    unsigned int errors;
+    unsigned int max_fill;
+};
+
+static struct ring_buf g_entries[MAX_ENTRIES];
+static struct payload g_payloads[MAX_ENTRIES];
+
+static void show_usage(const char *appname)
+{
+    printf("%s [-n count] [-e entries] [-b batch] [-p]\n", appname);
+    printf("\t-n: number of entries to move (default %u)\n", DEFAULT_COUNT);
+    printf("\t-e: entries in the ring, up to %u (default %u)\n", MAX_ENTRIES,
+           DEFAULT_ENTRIES);
+    printf("\t-b: largest batch, each batch has a random size up to it\n");
+    printf("\t    (default %u)\n", DEFAULT_BATCH);
+    printf("\t-p: pass entries one at a time with ring_buf_pass()\n");
+}
+
+/* Small xorshift generator, so that each thread has its own sequence */
+static uint32_t test_random(uint32_t *seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *seed = x;
+}
+
+static struct ring_buf *test_setup_ring(unsigned int entries)
+{
+    unsigned int i;
+
+    for (i = 0; i < entries; i++) {
+        memset(&g_entries[i], 0, sizeof(g_entries[i]));
+        g_entries[i].next = &g_entries[(i + 1) % entries];
+        ring_buf_set_priv(&g_entries[i], &g_payloads[i]);
+        ring_buf_set_owner(&g_entries[i], RING_BUF_OWNER_PRODUCER);
+    }
+
+    return &g_entries[0];
+}
+
+static void test_fill(struct ring_buf *rb, uint32_t seq)
+{
+    struct payload *payload = ring_buf_get_priv(rb);
+    unsigned int i;
+
+    payload->seq = seq;
+    for (i = 0; i < PAYLOAD_WORDS; i++)
+        payload->words[i] = seq * (i + 1) ^ 0xa5a5a5a5;
+}
+
+static int test_check(struct ring_buf *rb, uint32_t seq)
+{
+    struct payload *payload = ring_buf_get_priv(rb);
+    unsigned int i;
+
+    if (payload->seq != seq)
+        return -EIO;
+
+    for (i = 0; i < PAYLOAD_WORDS; i++) {
+        if (payload->words[i] != (seq * (i + 1) ^ 0xa5a5a5a5))
+            return -EIO;
+    }
+
+    return 0;
+}
+
+static unsigned int test_batch(struct test *test, uint32_t *seed,
+                               uint32_t seq)
+{
+    unsigned int n = 1 + test_random(seed) % test->batch;
+
+    return n < test->count - seq ? n : test->count - seq;
+}
+
+static void *test_producer(void *arg)
+{
+    struct test *test = arg;
+    struct ring_buf *rb = test->ring;
+    unsigned int i, n;
+    uint32_t seq = 0;
+
+    while (seq < test->count) {
+        if (!test->batch_mode) {
+            if (!ring_buf_is_producers(rb)) {
+                test->full++;
+                sched_yield();
+                continue;
+            }
+
+            test_fill(rb, seq++);
+            ring_buf_pass(rb);
+            rb = ring_buf_get_next(rb);
+            continue;
+        }
+
+        n = test_batch(test, &test->prod_seed, seq);
+        rb = ring_buf_spsc_reserve(&test->q, &n);
+        if (!rb) {
+            test->full++;
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++, rb = ring_buf_get_next(rb))
+            test_fill(rb, seq++);
+
+        ring_buf_spsc_commit(&test->q, n);
+    }
+
+    return NULL;
+}
+
+static void *test_consumer(void *arg)
+{
+    struct test *test = arg;
+    struct ring_buf *rb = test->ring;
+    unsigned int i, n, fill;
+    uint32_t seq = 0;
+
+    while (seq < test->count) {
+        if (!test->batch_mode) {
+            if (!ring_buf_is_consumers(rb)) {
+                test->empty++;
+                sched_yield();
+                continue;
+            }
+
+            if (test_check(rb, seq++))
+                test->errors++;
+            ring_buf_pass(rb);
+            rb = ring_buf_get_next(rb);
+            continue;
+        }
+
+        fill = ring_buf_spsc_count(&test->q);
+        if (fill > test->max_fill)
+            test->max_fill = fill;
+
+        n = test_batch(test, &test->cons_seed, seq);
+        rb = ring_buf_spsc_peek(&test->q, &n);
+        if (!rb) {
+            test->empty++;
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++, rb = ring_buf_get_next(rb)) {
+            if (test_check(rb, seq++))
+                test->errors++;
+        }
+
+        ring_buf_spsc_release(&test->q, n);
+    }
+
+    return NULL;
+}
+
+static uint64_t test_time_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int ring_buf_test_main(int argc, char *argv[])
+#endif
+{
+    struct test test;
+    pthread_t producer, consumer;
+    unsigned int entries = DEFAULT_ENTRIES;
+    uint64_t start, elapsed;
+    int opt;
+    int ret;
+
+    memset(&test, 0, sizeof(test));
+    test.batch_mode = true;
+    test.count = DEFAULT_COUNT;
+    test.batch = DEFAULT_BATCH;
+    test.prod_seed = 0x12345678;
+    test.cons_seed = 0x87654321;
+
+    optind = -1;
+    while ((opt = getopt(argc, argv, "n:e:b:p")) != -1) {
+        switch (opt) {
+        case 'n':
+            test.count = strtoul(optarg, NULL, 10);
+            break;
+        case 'e':
+            entries = strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            test.batch = strtoul(optarg, NULL, 10);
+            break;
+        case 'p':
+            test.batch_mode = false;
+            break;
+        default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!test.count || !entries || entries > MAX_ENTRIES || !test.batch) {
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    test.ring = test_setup_ring(entries);
+    if (test.batch_mode)
+        ring_buf_spsc_init(&test.q, test.ring);
+
+    start = test_time_usec();
+
+    ret = pthread_create(&consumer, NULL, test_consumer, &test);
+    if (ret) {
+        fprintf(stderr, "can't create the consumer: %d\n", ret);
+        return EXIT_FAILURE;
+    }
+
+    ret = pthread_create(&producer, NULL, test_producer, &test);
+    if (ret) {
+        fprintf(stderr, "can't create the producer: %d\n", ret);
+        /* The consumer waits for entries that will never come */
+        pthread_cancel(consumer);
+        pthread_join(consumer, NULL);
+        return EXIT_FAILURE;
+    }
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    elapsed = test_time_usec() - start;
+    if (!elapsed)
+        elapsed = 1;
+
+    printf("%s: %u entries through a ring of %u", test.batch_mode ?
+           "spsc" : "pass", test.count, entries);
+    if (test.batch_mode)
+        printf(", batches of up to %u", test.batch);
+    printf("\n");
+    printf("time %llu us, %llu entries/s\n", (unsigned long long) elapsed,
+           (unsigned long long) test.count * 1000000 / elapsed);
+    printf("ring full %u times, empty %u times", test.full, test.empty);
+    if (test.batch_mode)
+        printf(", max fill %u", test.max_fill);
+    printf("\n");
+    printf("%u errors\n", test.errors);
+
+    return test.errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -42,6 +42,10 @@
 #include "ara_board.h"
 #include "interface.h"
 #include "attr_names.h"
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+#include <nuttx/clock.h>
+#include "tsb_switch_driver_sim.h"
+#endif
 #endif
 
 #define DBG_COMP DBG_SVC
@@ -67,6 +71,9 @@ enum {
     LINKSTATUS,
     DME_IO,
     TESTFEATURE,
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    SIM,
+#endif
     MAX_CMD,
 };
 
@@ -85,6 +92,9 @@ static const struct command commands[] = {
     [LINKSTATUS] = {'s', "linkstatus", "print UniPro link status bit mask"},
     [DME_IO]  = {'d', "dme", "get/set DME attributes"},
     [TESTFEATURE] = {'t', "testfeature", "UniPro test feature"},
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    [SIM] = {'m', "sim", "drive the software switch model"},
+#endif
 };
 
 static void usage(int exit_status) {
@@ -1009,6 +1019,226 @@ static int test_feature(int argc, char* argv[]) {
     return 0;
 }
 
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+/* ----------------------------------------------------------------------
+ * Switch model scenarios.
+ */
+
+#define SIM_SCRIPT_ARGS     8
+#define SIM_IDLE_TIMEOUT_MS 5000
+#define SIM_CONN_CPORTS     32
+
+static void sim_usage(void) {
+    printk("svc %s <command> [args]: usage:\n", commands[SIM].longc);
+    printk("    insert <port>       : plug a module on <port>\n");
+    printk("    remove <port>       : unplug the module on <port>\n");
+    printk("    mbox <port> <val>   : have the module on <port> write its mailbox\n");
+    printk("    wait                : wait for the pending interrupts to be handled\n");
+    printk("    sleep <ms>          : pause for <ms> milliseconds\n");
+    printk("    storm <n> [mask]    : plug or unplug <n> modules in a row, on the\n"
+           "                          ports in hexadecimal <mask> (default 0x3fff)\n");
+    printk("    conn <n> [src] [dst]: create <n> connections between interfaces\n"
+           "                          <src> and <dst> (default apb1 and apb2)\n");
+    printk("    stats               : print the model counters\n");
+    printk("    reset               : reset the model counters\n");
+    printk("    run \"<cmd>; ...\"    : run a sequence of the above commands\n");
+}
+
+static void sim_print_stats(const struct switch_sim_stats *stats) {
+    printk("inserts=%u removes=%u mailboxes=%u\n",
+           stats->inserts, stats->removes, stats->mailboxes);
+    printk("irqs raised=%u handled=%u handler runs=%u\n",
+           stats->irqs_raised, stats->irqs_handled, stats->handler_runs);
+    printk("irq latency avg=%u us max=%u us\n",
+           stats->irqs_handled ?
+           stats->irq_usec_total / stats->irqs_handled : 0,
+           stats->irq_usec_max);
+    printk("ncp round-trips=%u\n", stats->ncp_transfers);
+}
+
+static int sim_storm(struct tsb_switch *sw, unsigned int count,
+                     uint32_t mask) {
+    struct switch_sim_stats stats;
+    uint32_t start;
+    unsigned int i;
+    uint8_t port;
+    int rc;
+
+    mask &= (1 << SWITCH_UNIPORT_MAX) - 1;
+    if (!mask) {
+        return -EINVAL;
+    }
+
+    switch_sim_reset_stats(sw);
+    start = clock_systimer();
+
+    for (i = 0; i < count; i++) {
+        do {
+            port = rand() % SWITCH_UNIPORT_MAX;
+        } while (!(mask & (1 << port)));
+
+        if (switch_sim_module_present(sw, port)) {
+            rc = switch_sim_module_remove(sw, port);
+        } else {
+            rc = switch_sim_module_insert(sw, port);
+        }
+        if (rc) {
+            printk("storm: port %u: %d\n", port, rc);
+            return rc;
+        }
+    }
+
+    rc = switch_sim_wait_idle(sw, SIM_IDLE_TIMEOUT_MS);
+    if (rc) {
+        printk("storm: interrupts still pending: %d\n", rc);
+    }
+
+    printk("storm: %u events in %u ms\n", count,
+           TICK2MSEC(clock_systimer() - start));
+    switch_sim_get_stats(sw, &stats);
+    sim_print_stats(&stats);
+
+    return rc;
+}
+
+static int sim_conn(struct tsb_switch *sw, unsigned int count,
+                    const char *src_name, const char *dst_name) {
+    struct switch_stats before, after;
+    struct interface *src, *dst;
+    uint32_t connections;
+    uint32_t start;
+    unsigned int i;
+    uint16_t cport;
+    int rc = 0;
+
+    src = interface_get_by_name(src_name);
+    dst = interface_get_by_name(dst_name);
+    if (!src || !dst) {
+        printk("conn: nonexistent interface %s\n", src ? dst_name : src_name);
+        return -EINVAL;
+    }
+
+    switch_get_stats(sw, &before);
+    start = clock_systimer();
+
+    for (i = 0; i < count; i++) {
+        cport = i % SIM_CONN_CPORTS;
+        rc = svc_connect_interfaces(src, cport, dst, cport, CPORT_TC0,
+                                    CPORT_FLAGS_CSD_N | CPORT_FLAGS_CSV_N);
+        if (rc) {
+            printk("conn: [%s:%u]<->[%s:%u] failed: %d\n",
+                   src_name, cport, dst_name, cport, rc);
+            break;
+        }
+    }
+
+    switch_get_stats(sw, &after);
+    connections = after.connections - before.connections;
+
+    printk("conn: %u connections in %u ms\n", connections,
+           TICK2MSEC(clock_systimer() - start));
+    printk("conn: avg=%u us max=%u us, %u DME accesses in %u batches\n",
+           connections ?
+           (after.connection_usec_total - before.connection_usec_total) /
+           connections : 0,
+           after.connection_usec_max,
+           after.dme_ops - before.dme_ops,
+           after.dme_batches - before.dme_batches);
+
+    return rc;
+}
+
+static int sim_exec(struct tsb_switch *sw, int argc, char *argv[]) {
+    struct switch_sim_stats stats;
+    const char *cmd = argv[0];
+
+    if (!strcmp(cmd, "insert") && argc == 2) {
+        return switch_sim_module_insert(sw, strtol(argv[1], NULL, 10));
+    } else if (!strcmp(cmd, "remove") && argc == 2) {
+        return switch_sim_module_remove(sw, strtol(argv[1], NULL, 10));
+    } else if (!strcmp(cmd, "mbox") && argc == 3) {
+        return switch_sim_mailbox(sw, strtol(argv[1], NULL, 10),
+                                  strtoul(argv[2], NULL, 0));
+    } else if (!strcmp(cmd, "wait") && argc == 1) {
+        return switch_sim_wait_idle(sw, SIM_IDLE_TIMEOUT_MS);
+    } else if (!strcmp(cmd, "sleep") && argc == 2) {
+        usleep(strtoul(argv[1], NULL, 10) * 1000);
+        return 0;
+    } else if (!strcmp(cmd, "storm") && (argc == 2 || argc == 3)) {
+        return sim_storm(sw, strtoul(argv[1], NULL, 10),
+                         argc == 3 ? strtoul(argv[2], NULL, 16) :
+                                     (1 << SWITCH_UNIPORT_MAX) - 1);
+    } else if (!strcmp(cmd, "conn") && argc >= 2 && argc <= 4) {
+        return sim_conn(sw, strtoul(argv[1], NULL, 10),
+                        argc > 2 ? argv[2] : "apb1",
+                        argc > 3 ? argv[3] : "apb2");
+    } else if (!strcmp(cmd, "stats") && argc == 1) {
+        switch_sim_get_stats(sw, &stats);
+        sim_print_stats(&stats);
+        return 0;
+    } else if (!strcmp(cmd, "reset") && argc == 1) {
+        switch_sim_reset_stats(sw);
+        return 0;
+    }
+
+    printk("svc %s: bad command '%s'\n", commands[SIM].longc, cmd);
+    return -EINVAL;
+}
+
+static int sim_run(struct tsb_switch *sw, char *script) {
+    char *args[SIM_SCRIPT_ARGS];
+    char *line, *line_save;
+    char *arg, *arg_save;
+    int nargs;
+    int rc;
+
+    for (line = strtok_r(script, ";\n", &line_save); line;
+         line = strtok_r(NULL, ";\n", &line_save)) {
+        nargs = 0;
+        for (arg = strtok_r(line, " \t", &arg_save);
+             arg && nargs < SIM_SCRIPT_ARGS;
+             arg = strtok_r(NULL, " \t", &arg_save)) {
+            args[nargs++] = arg;
+        }
+        if (!nargs) {
+            continue;
+        }
+
+        rc = sim_exec(sw, nargs, args);
+        if (rc) {
+            printk("svc %s: '%s' failed: %d\n", commands[SIM].longc,
+                   args[0], rc);
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+static int sim(int argc, char *argv[]) {
+    struct tsb_switch *sw = svc->sw;
+
+    if (!sw) {
+        return -ENODEV;
+    }
+
+    if (argc < 3 || !strcmp(argv[2], "-h")) {
+        sim_usage();
+        return argc < 3 ? -EINVAL : 0;
+    }
+
+    if (!strcmp(argv[2], "run")) {
+        if (argc != 4) {
+            sim_usage();
+            return -EINVAL;
+        }
+        return sim_run(sw, argv[3]);
+    }
+
+    return sim_exec(sw, argc - 2, argv + 2);
+}
+#endif
+
 static int ara_svc_main(int argc, char *argv[]) {
     /* Current main(), for configs/ara/svc (BDB1B, BDB2A, spiral 2
      * modules, etc.). */
@@ -1058,6 +1288,11 @@ static int ara_svc_main(int argc, char *argv[]) {
     case TESTFEATURE:
         rc = test_feature(argc, argv);
         break;
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    case SIM:
+        rc = sim(argc, argv);
+        break;
+#endif
     default:
         usage(EXIT_FAILURE);
     }
@@ -0,0 +1,348 @@
+/****************************************************************************
+ * examples/ostest/ctxswitch.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#include "ostest.h"
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+#if CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS < 2
+#  error CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS must be at least 2
+#endif
+
+/* Total number of sched_yield() calls timed for each number of threads */
+
+#define NYIELDS 4096
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile int g_nyields;
+
+static sem_t g_reprio_sem;
+static volatile int g_reprio_step;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* All the threads have the same priority and yield to each other: each call
+ * moves the caller behind all the other ready-to-run threads and switches
+ * to the next one.
+ */
+
+static void *yield_thread(void *parameter)
+{
+  int loops = (int)((intptr_t)parameter);
+  int i;
+
+  for (i = 0; i < loops; i++)
+    {
+      sched_yield();
+      g_nyields++;
+    }
+
+  return NULL;
+}
+
+/* The running thread changes its own priority up and down, which does not
+ * cause a context switch, then blocks at the higher priority.  The
+ * ready-to-run list must not keep track of it at its previous priority.
+ */
+
+static void *reprio_thread(void *parameter)
+{
+  int priority = (int)((intptr_t)parameter);
+  struct sched_param sparam;
+
+  sparam.sched_priority = priority + 1;
+  sched_setparam(0, &sparam);
+  sparam.sched_priority = priority;
+  sched_setparam(0, &sparam);
+  sparam.sched_priority = priority + 1;
+  sched_setparam(0, &sparam);
+
+  g_reprio_step = 1;
+  sem_wait(&g_reprio_sem);
+  g_reprio_step = 3;
+  return NULL;
+}
+
+/* A new thread at the priority that reprio_thread() left */
+
+static void *reprio_waiter(void *parameter)
+{
+  g_reprio_step = 2;
+  return NULL;
+}
+
+static int start_thread(pthread_t *thread, int priority,
+                        pthread_startroutine_t entry, void *arg)
+{
+  struct sched_param sparam;
+  pthread_attr_t attr;
+  int status;
+
+  pthread_attr_init(&attr);
+  sparam.sched_priority = priority;
+  pthread_attr_setschedparam(&attr, &sparam);
+
+  status = pthread_create(thread, &attr, entry, arg);
+  if (status != 0)
+    {
+      printf("ctxswitch_test: ERROR pthread_create failed: %d\n", status);
+      return -1;
+    }
+
+  return 0;
+}
+
+static int reprio_check(int priority)
+{
+  pthread_t thread;
+  pthread_t waiter;
+  int ret = 0;
+
+  /* Both threads have a higher priority than this one:  each step below
+   * is complete when the call that starts it returns.
+   */
+
+  sem_init(&g_reprio_sem, 0, 0);
+  g_reprio_step = 0;
+
+  if (start_thread(&thread, priority, reprio_thread,
+                   (void *)((intptr_t)priority)) < 0)
+    {
+      sem_destroy(&g_reprio_sem);
+      return -1;
+    }
+
+  if (g_reprio_step != 1)
+    {
+      printf("ctxswitch_test: ERROR reprioritized thread did not block\n");
+      ret = -1;
+    }
+
+  if (start_thread(&waiter, priority, reprio_waiter, NULL) == 0)
+    {
+      if (g_reprio_step != 2)
+        {
+          printf("ctxswitch_test: ERROR thread at the old priority "
+                 "did not run\n");
+          ret = -1;
+        }
+
+      pthread_join(waiter, NULL);
+    }
+  else
+    {
+      ret = -1;
+    }
+
+  sem_post(&g_reprio_sem);
+  if (g_reprio_step != 3)
+    {
+      printf("ctxswitch_test: ERROR reprioritized thread did not wake up\n");
+      ret = -1;
+    }
+
+  pthread_join(thread, NULL);
+  sem_destroy(&g_reprio_sem);
+
+  if (ret == 0)
+    {
+      printf("ctxswitch_test: Reprioritization of the running thread OK\n");
+    }
+
+  return ret;
+}
+
+static uint64_t time_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int measure(int nthreads, int priority)
+{
+  pthread_t threads[CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS];
+  struct sched_param sparam;
+  pthread_attr_t attr;
+  uint64_t elapsed;
+  int loops = NYIELDS / nthreads;
+  int status;
+  int ret = 0;
+  int i;
+
+  g_nyields = 0;
+
+  status = pthread_attr_init(&attr);
+  if (status != 0)
+    {
+      printf("ctxswitch_test: ERROR pthread_attr_init failed: %d\n", status);
+      return -1;
+    }
+
+  sparam.sched_priority = priority;
+  status = pthread_attr_setschedparam(&attr, &sparam);
+  if (status != 0)
+    {
+      printf("ctxswitch_test: ERROR pthread_attr_setschedparam failed: %d\n",
+             status);
+      return -1;
+    }
+
+  /* Create all the threads before letting any of them run, so that they
+   * all are in the ready-to-run list when the first one yields.
+   */
+
+  sched_lock();
+  for (i = 0; i < nthreads; i++)
+    {
+      status = pthread_create(&threads[i], &attr, yield_thread,
+                              (void *)((intptr_t)loops));
+      if (status != 0)
+        {
+          printf("ctxswitch_test: ERROR failed to start thread %d: %d\n",
+                 i, status);
+          nthreads = i;
+          ret = -1;
+          break;
+        }
+    }
+
+  /* This thread has a lower priority: it only gets the CPU back once all
+   * the threads are done.
+   */
+
+  elapsed = time_usec();
+  sched_unlock();
+
+  for (i = 0; i < nthreads; i++)
+    {
+      pthread_join(threads[i], NULL);
+    }
+
+  elapsed = time_usec() - elapsed;
+
+  if (ret == 0)
+    {
+      if (g_nyields != nthreads * loops)
+        {
+          printf("ctxswitch_test: ERROR %d yields, expected %d\n",
+                 g_nyields, nthreads * loops);
+          ret = -1;
+        }
+
+      printf("ctxswitch_test: %2d threads: %d switches in %lu us, "
+             "%lu ns/switch\n", nthreads, g_nyields, (unsigned long)elapsed,
+             (unsigned long)(elapsed * 1000 / (g_nyields ? g_nyields : 1)));
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ctxswitch_test
+ *
+ * Description:
+ *   Measure the cost of a context switch between threads of the same
+ *   priority, as a function of the number of such threads ready to run.
+ *   With CONFIG_SCHED_READYTORUN_BITMAP, it should not depend on the latter.
+ *   First check that the running thread can change its own priority
+ *   without corrupting the ready-to-run list.
+ *
+ ****************************************************************************/
+
+void ctxswitch_test(void)
+{
+  struct sched_param sparam;
+  int nthreads;
+  int my_pri;
+
+  printf("ctxswitch_test: Started\n");
+
+  if (sched_getparam(getpid(), &sparam) != 0)
+    {
+      printf("ctxswitch_test: ERROR sched_getparam failed\n");
+      return;
+    }
+
+  my_pri = sparam.sched_priority;
+  if (my_pri + 2 > sched_get_priority_max(SCHED_FIFO))
+    {
+      printf("ctxswitch_test: Skipping, priority %d is too high\n", my_pri);
+      return;
+    }
+
+  if (reprio_check(my_pri + 1) < 0)
+    {
+      return;
+    }
+
+  /* A single thread would not switch context when yielding */
+
+  for (nthreads = 2; ; nthreads *= 2)
+    {
+      if (nthreads > CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS)
+        {
+          nthreads = CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS;
+        }
+
+      if (measure(nthreads, my_pri + 1) < 0 ||
+          nthreads == CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS)
+        {
+          break;
+        }
+    }
+
+  printf("ctxswitch_test: Done\n");
+}
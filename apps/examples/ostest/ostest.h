@@ -71,6 +71,30 @@
 #  define CONFIG_EXAMPLES_OSTEST_NBARRIER_THREADS 8
 #endif
 
+/* This is the largest number of idle threads blocked on their own semaphore
+ * while measuring the cost of sem_post() in the semaphore wait queue test.
+ */
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS
+#  define CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS 8
+#endif
+
+/* This is the largest number of threads of the same priority switching to
+ * each other in the context switch test.
+ */
+
+#ifndef CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS
+#  define CONFIG_EXAMPLES_OSTEST_CTXSWITCH_NTHREADS 8
+#endif
+
+/* This is the largest number of active watchdogs in the watchdog stress
+ * test.
+ */
+
+#ifndef CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS
+#  define CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS 1000
+#endif
+
 /* Priority inheritance */
 
 #if defined(CONFIG_DEBUG) && defined(CONFIG_PRIORITY_INHERITANCE) && defined(CONFIG_SEM_PHDEBUG)
@@ -137,6 +161,18 @@ void sem_test(void);
 
 void semtimed_test(void);
 
+/* semwaitq.c ***************************************************************/
+
+void semwaitq_test(void);
+
+/* ctxswitch.c **************************************************************/
+
+void ctxswitch_test(void);
+
+/* wdstress.c ***************************************************************/
+
+void wdstress_test(void);
+
 /* cond.c *******************************************************************/
 
 void cond_test(void);
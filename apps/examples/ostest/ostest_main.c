@@ -382,6 +382,14 @@ static int user_main(int argc, char *argv[])
       semtimed_test();
       check_test_memory_usage();
 
+      printf("\nuser_main: semaphore wait queue test\n");
+      semwaitq_test();
+      check_test_memory_usage();
+
+      printf("\nuser_main: context switch test\n");
+      ctxswitch_test();
+      check_test_memory_usage();
+
 #endif
 
 #ifndef CONFIG_DISABLE_PTHREAD
@@ -460,6 +468,15 @@ static int user_main(int argc, char *argv[])
       check_test_memory_usage();
 #endif /* CONFIG_PRIORITY_INHERITANCE && !CONFIG_DISABLE_SIGNALS && !CONFIG_DISABLE_PTHREAD */
 
+#if !defined(CONFIG_BUILD_PROTECTED) && !defined(CONFIG_BUILD_KERNEL) && \
+    !defined(CONFIG_DISABLE_SIGNALS)
+      /* Measure the cost of watchdog timers */
+
+      printf("\nuser_main: watchdog stress test\n");
+      wdstress_test();
+      check_test_memory_usage();
+#endif
+
 #if defined(CONFIG_ARCH_HAVE_VFORK) && defined(CONFIG_SCHED_WAITPID) && \
    !defined(CONFIG_DISABLE_SIGNALS)
       printf("\nuser_main: vfork() test\n");
@@ -0,0 +1,264 @@
+/****************************************************************************
+ * examples/ostest/semwaitq.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#include "ostest.h"
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/* Number of contended posts timed for each number of idle threads */
+
+#define NPOSTS 2000
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static sem_t g_waitq_sem;
+static sem_t g_idle_sem[CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS];
+static volatile int g_wakeups;
+static volatile bool g_done;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Blocks on its own semaphore until the end of a measurement.  These
+ * threads have a higher priority than the waiter, so they sit ahead of it
+ * in the list of all tasks waiting for a semaphore.
+ */
+
+static void *idle_thread(void *parameter)
+{
+  int id = (int)((intptr_t)parameter);
+
+  while (sem_wait(&g_idle_sem[id]) != 0);
+  return NULL;
+}
+
+/* Takes every count posted on g_waitq_sem */
+
+static void *waiter_thread(void *parameter)
+{
+  for (;;)
+    {
+      if (sem_wait(&g_waitq_sem) != 0)
+        {
+          continue;
+        }
+
+      if (g_done)
+        {
+          break;
+        }
+
+      g_wakeups++;
+    }
+
+  return NULL;
+}
+
+static uint64_t time_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int start_thread(pthread_t *thread, int priority,
+                        void *(*entry)(void *), void *arg)
+{
+  struct sched_param sparam;
+  pthread_attr_t attr;
+  int status;
+
+  status = pthread_attr_init(&attr);
+  if (status != 0)
+    {
+      return status;
+    }
+
+  sparam.sched_priority = priority;
+  status = pthread_attr_setschedparam(&attr, &sparam);
+  if (status != 0)
+    {
+      return status;
+    }
+
+  return pthread_create(thread, &attr, entry, arg);
+}
+
+/* Time NPOSTS posts, each one waking up the waiter, with 'nidle' unrelated
+ * threads blocked on other semaphores.
+ */
+
+static int measure(int nidle, int my_pri)
+{
+  pthread_t idle[CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS];
+  pthread_t waiter;
+  uint64_t elapsed;
+  int status;
+  int ret = 0;
+  int i;
+
+  sem_init(&g_waitq_sem, 0, 0);
+  g_wakeups = 0;
+  g_done = false;
+
+  /* Both the idle threads and the waiter preempt this thread as soon as
+   * they are created, and run until they block.
+   */
+
+  for (i = 0; i < nidle; i++)
+    {
+      sem_init(&g_idle_sem[i], 0, 0);
+      status = start_thread(&idle[i], my_pri + 2, idle_thread,
+                            (void *)((intptr_t)i));
+      if (status != 0)
+        {
+          printf("semwaitq_test: ERROR failed to start idle thread %d: %d\n",
+                 i, status);
+          nidle = i;
+          ret = -1;
+          goto errout_with_idle;
+        }
+    }
+
+  status = start_thread(&waiter, my_pri + 1, waiter_thread, NULL);
+  if (status != 0)
+    {
+      printf("semwaitq_test: ERROR failed to start the waiter: %d\n",
+             status);
+      ret = -1;
+      goto errout_with_idle;
+    }
+
+  elapsed = time_usec();
+  for (i = 0; i < NPOSTS; i++)
+    {
+      sem_post(&g_waitq_sem);
+    }
+
+  elapsed = time_usec() - elapsed;
+
+  if (g_wakeups != NPOSTS)
+    {
+      printf("semwaitq_test: ERROR %d wakeups for %d posts\n",
+             g_wakeups, NPOSTS);
+      ret = -1;
+    }
+
+  printf("semwaitq_test: %2d idle threads: %d posts in %lu us, %lu ns/post\n",
+         nidle, NPOSTS, (unsigned long)elapsed,
+         (unsigned long)(elapsed * 1000 / NPOSTS));
+
+  g_done = true;
+  sem_post(&g_waitq_sem);
+  pthread_join(waiter, NULL);
+
+errout_with_idle:
+  for (i = 0; i < nidle; i++)
+    {
+      sem_post(&g_idle_sem[i]);
+      pthread_join(idle[i], NULL);
+      sem_destroy(&g_idle_sem[i]);
+    }
+
+  sem_destroy(&g_waitq_sem);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: semwaitq_test
+ *
+ * Description:
+ *   Measure the cost of posting a semaphore that a task is waiting for, as
+ *   a function of the number of other tasks blocked on other semaphores.
+ *   With per-semaphore wait queues, it should not depend on the latter.
+ *
+ ****************************************************************************/
+
+void semwaitq_test(void)
+{
+  struct sched_param sparam;
+  int my_pri;
+  int nidle;
+
+  printf("semwaitq_test: Started\n");
+
+  if (sched_getparam(getpid(), &sparam) != 0)
+    {
+      printf("semwaitq_test: ERROR sched_getparam failed\n");
+      return;
+    }
+
+  my_pri = sparam.sched_priority;
+  if (my_pri + 2 > sched_get_priority_max(SCHED_FIFO))
+    {
+      printf("semwaitq_test: Skipping, priority %d is too high\n", my_pri);
+      return;
+    }
+
+  for (nidle = 0; ; nidle = nidle ? 2 * nidle : 1)
+    {
+      if (nidle > CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS)
+        {
+          nidle = CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS;
+        }
+
+      if (measure(nidle, my_pri) < 0 ||
+          nidle == CONFIG_EXAMPLES_OSTEST_SEMWAITQ_NTHREADS)
+        {
+          break;
+        }
+    }
+
+  printf("semwaitq_test: Done\n");
+}
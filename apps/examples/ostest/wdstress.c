@@ -0,0 +1,219 @@
+/****************************************************************************
+ * examples/ostest/wdstress.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nuttx/wdog.h>
+
+#include "ostest.h"
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/* Number of wd_start() and wd_cancel() calls timed for each number of
+ * active watchdogs.
+ */
+
+#define NOPS 10000
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile int g_nexpired;
+static uint32_t g_seed;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t wdstress_random(void)
+{
+  g_seed = g_seed * 1103515245 + 12345;
+  return g_seed >> 8;
+}
+
+static void wdstress_handler(int argc, uint32_t arg)
+{
+  g_nexpired++;
+}
+
+static uint64_t time_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Delays long enough for the watchdogs to never expire during the
+ * measurements.
+ */
+
+static int long_delay(void)
+{
+  return 60 * CLK_TCK + wdstress_random() % (60 * CLK_TCK);
+}
+
+static int measure(FAR struct wdog_s *wdogs, int nwdogs)
+{
+  uint64_t start;
+  uint64_t restart;
+  uint64_t cancel;
+  int ret = 0;
+  int i;
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      wd_static(&wdogs[i]);
+      wd_start(&wdogs[i], long_delay(), (wdentry_t)wdstress_handler, 1, i);
+    }
+
+  /* Time the restart of active watchdogs, which cancels them first */
+
+  start = time_usec();
+  for (i = 0; i < NOPS; i++)
+    {
+      wd_start(&wdogs[wdstress_random() % nwdogs], long_delay(),
+               (wdentry_t)wdstress_handler, 1, i);
+    }
+
+  restart = time_usec() - start;
+
+  /* Time the cancellation of active watchdogs, each one followed by a
+   * restart so that the number of active watchdogs does not change.
+   */
+
+  start = time_usec();
+  for (i = 0; i < NOPS; i++)
+    {
+      FAR struct wdog_s *wdog = &wdogs[wdstress_random() % nwdogs];
+
+      wd_cancel(wdog);
+      wd_start(wdog, long_delay(), (wdentry_t)wdstress_handler, 1, i);
+    }
+
+  cancel = time_usec() - start;
+
+  printf("wdstress_test: %4d watchdogs: wd_start %lu ns, "
+         "wd_cancel + wd_start %lu ns\n", nwdogs,
+         (unsigned long)(restart * 1000 / NOPS),
+         (unsigned long)(cancel * 1000 / NOPS));
+
+  /* Now let all of them expire within a few ticks */
+
+  g_nexpired = 0;
+  for (i = 0; i < nwdogs; i++)
+    {
+      wd_start(&wdogs[i], 1 + wdstress_random() % 10,
+               (wdentry_t)wdstress_handler, 1, i);
+    }
+
+  usleep(20 * 1000000 / CLK_TCK);
+
+  if (g_nexpired != nwdogs)
+    {
+      printf("wdstress_test: ERROR %d watchdogs expired, expected %d\n",
+             g_nexpired, nwdogs);
+      ret = -1;
+    }
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      if (wd_cancel(&wdogs[i]) == OK)
+        {
+          printf("wdstress_test: ERROR watchdog %d still active\n", i);
+          ret = -1;
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wdstress_test
+ *
+ * Description:
+ *   Measure the cost of starting and cancelling a watchdog when 10, 100,
+ *   ... up to CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS watchdogs are active,
+ *   and check that all of them expire.  With CONFIG_WDOG_TIMING_WHEEL, the
+ *   cost should not depend on the number of active watchdogs.
+ *
+ ****************************************************************************/
+
+void wdstress_test(void)
+{
+  FAR struct wdog_s *wdogs;
+  int nwdogs;
+
+  printf("wdstress_test: Started\n");
+
+  wdogs = malloc(CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS * sizeof(*wdogs));
+  if (!wdogs)
+    {
+      printf("wdstress_test: ERROR failed to allocate %d watchdogs\n",
+             CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS);
+      return;
+    }
+
+  g_seed = 1;
+  for (nwdogs = 10; ; nwdogs *= 10)
+    {
+      if (nwdogs > CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS)
+        {
+          nwdogs = CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS;
+        }
+
+      if (measure(wdogs, nwdogs) < 0 ||
+          nwdogs == CONFIG_EXAMPLES_OSTEST_WDSTRESS_NWDOGS)
+        {
+          break;
+        }
+    }
+
+  free(wdogs);
+  printf("wdstress_test: Done\n");
+}
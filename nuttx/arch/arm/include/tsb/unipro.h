@@ -31,6 +31,7 @@
 #ifndef _UNIPRO_H_
 #define _UNIPRO_H_
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #ifdef CONFIG_TSB_CHIP_REV_ES1
@@ -44,11 +45,45 @@
 typedef int (*unipro_send_completion_t)(int status, const void *buf,
                                         void *priv);
 
+/*
+ * TX arbitration between CPorts with queued buffers: a CPort is only served
+ * when no CPort of a higher priority can make progress. CPorts of the same
+ * priority are served in round-robin, each one moving up to its weight in
+ * chunks of data per round.
+ */
+enum unipro_tx_priority {
+    UNIPRO_TX_PRIORITY_HIGH,
+    UNIPRO_TX_PRIORITY_NORMAL,
+    UNIPRO_TX_PRIORITY_LOW,
+    UNIPRO_TX_PRIORITY_COUNT,
+};
+
+struct unipro_tx_stats {
+    /** messages sent, bytes sent and messages dropped on error */
+    uint32_t messages;
+    uint32_t bytes;
+    uint32_t errors;
+    /** unipro_send_async() calls refused because of the queue limit */
+    uint32_t rejected;
+    /** bytes currently queued, and the highest value seen */
+    uint32_t queued_bytes;
+    uint32_t max_queued_bytes;
+    /** messages currently queued, and the highest value seen */
+    uint32_t queued_msgs;
+    uint32_t max_queued_msgs;
+    /** tx_writable() notifications sent after a rejection */
+    uint32_t writable;
+    /** time from queueing to the end of the transfer (usec) */
+    uint32_t max_delay;
+    uint64_t total_delay;
+};
+
 struct unipro_driver {
     const char name[32];
     int (*rx_handler)(unsigned int cportid,  // Called in irq context
                       void *data,
                       size_t len);
+    void (*tx_writable)(unsigned int cportid); // Called from the TX worker
 };
 
 void unipro_init(void);
@@ -58,6 +93,11 @@ int unipro_send(unsigned int cportid, const void *buf, size_t len);
 int unipro_send_async(unsigned int cportid, const void *buf, size_t len,
                       unipro_send_completion_t callback, void *priv);
 int unipro_unpause_rx(unsigned int cportid);
+int unipro_set_tx_priority(unsigned int cportid,
+                           enum unipro_tx_priority prio, unsigned int weight);
+int unipro_set_tx_queue_limit(unsigned int cportid, size_t max_bytes);
+int unipro_get_tx_stats(unsigned int cportid, struct unipro_tx_stats *stats);
+void unipro_reset_tx_stats(unsigned int cportid);
 int unipro_attr_read(uint16_t attr,
                      uint32_t *val,
                      uint16_t selector,
@@ -71,6 +71,7 @@
 #include <nuttx/arch.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/syslog/ramlog.h>
+#include <nuttx/sched_note.h>
 
 #include <arch/board/board.h>
 
@@ -206,6 +207,12 @@ void up_initialize(void)
     }
 #endif
 
+  /* Start the performance counter */
+
+#ifdef CONFIG_ARCH_HAVE_PERF
+  up_perf_init();
+#endif
+
   /* Initialize the system timer interrupt */
 
 #if !defined(CONFIG_SUPPRESS_INTERRUPTS) && !defined(CONFIG_SUPPRESS_TIMER_INTS) && \
@@ -233,6 +240,10 @@ void up_initialize(void)
   devzero_register();   /* Standard /dev/zero */
 #endif
 
+#if defined(CONFIG_DRIVER_NOTE)
+  note_register();      /* Scheduler notes, /dev/note */
+#endif
+
 #endif /* CONFIG_NFILE_DESCRIPTORS */
 
   /* Initialize the serial device driver */
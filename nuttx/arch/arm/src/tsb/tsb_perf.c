@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Performance counter: the Cortex-M3 DWT cycle counter, which runs at the
+ * CPU clock.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <nuttx/arch.h>
+#include <arch/board/board.h>
+
+#include "nvic.h"
+#include "up_arch.h"
+
+#define DWT_CTRL                0xe0001000
+#define DWT_CYCCNT              0xe0001004
+
+#define DWT_CTRL_CYCCNTENA      (1 << 0)
+
+/* The cycle counter runs at the CPU clock, as the system timer does */
+#define TSB_PERF_FREQ           BOARD_CPU_FREQUENCY
+
+void up_perf_init(void)
+{
+    modifyreg32(NVIC_DEMCR, 0, NVIC_DEMCR_TRCENA);
+    putreg32(0, DWT_CYCCNT);
+    modifyreg32(DWT_CTRL, 0, DWT_CTRL_CYCCNTENA);
+}
+
+uint32_t up_perf_gettime(void)
+{
+    return getreg32(DWT_CYCCNT);
+}
+
+uint32_t up_perf_getfreq(void)
+{
+    return TSB_PERF_FREQ;
+}
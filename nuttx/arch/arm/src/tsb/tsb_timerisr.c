@@ -37,8 +37,8 @@
 #include "nvic.h"
 #include "up_arch.h"
 
-/* 96 MHz */
-#define SYSTICK_RELOAD 960000
+/* The SysTick runs at the CPU clock */
+#define SYSTICK_RELOAD (BOARD_CPU_FREQUENCY / CLK_TCK)
 
 int up_timerisr(int irq, uint32_t *regs)
 {
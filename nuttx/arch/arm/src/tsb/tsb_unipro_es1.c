@@ -236,6 +236,26 @@ int unipro_unpause_rx(unsigned int cportid)
     return -ENOSYS;
 }
 
+int unipro_set_tx_priority(unsigned int cportid,
+                           enum unipro_tx_priority prio, unsigned int weight)
+{
+    return -ENOSYS;
+}
+
+int unipro_set_tx_queue_limit(unsigned int cportid, size_t max_bytes)
+{
+    return -ENOSYS;
+}
+
+int unipro_get_tx_stats(unsigned int cportid, struct unipro_tx_stats *stats)
+{
+    return -ENOSYS;
+}
+
+void unipro_reset_tx_stats(unsigned int cportid)
+{
+}
+
 /**
  * @brief Clear and disable UniPro interrupt
  */
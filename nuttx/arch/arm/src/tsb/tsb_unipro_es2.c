@@ -29,11 +29,19 @@
  */
 
 #include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <nuttx/util.h>
 #include <nuttx/irq.h>
 #include <nuttx/arch.h>
 #include <nuttx/list.h>
 
+#ifdef CONFIG_TSB_UNIPRO_DMA
+#include <nuttx/device.h>
+#include <nuttx/device_dma.h>
+#endif
+
 #include <nuttx/greybus/unipro.h>
 #include <nuttx/greybus/tsb_unipro.h>
 
@@ -53,6 +61,14 @@
 #define DBG_UNIPRO(fmt, ...) ((void)0)
 #endif
 
+#ifndef CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH
+#define CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH    4
+#endif
+
+#if CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH < 1
+#error "CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH must be at least 1"
+#endif
+
 #define TRANSFER_MODE          (2)
 #define TRANSFER_MODE_2_CTRL_0 (0xAAAAAAAA) // Transfer mode 2 for CPorts 0-15
 /*
@@ -63,6 +79,22 @@
 #define TRANSFER_MODE_2_CTRL_1 (0xAAAAAAA5) // Transfer mode 2 for CPorts 18-31
 #define TRANSFER_MODE_2_CTRL_2 (0x00AAAAAA) // Transfer mode 2 for CPorts 32-43
 
+struct unipro_buffer {
+    struct list_head list;
+    unipro_send_completion_t callback;
+    void *priv;
+    bool som;
+    int byte_sent;
+    int len;
+    const void *data;
+    uint64_t queued;            // time of unipro_send_async() (usec)
+#ifdef CONFIG_TSB_UNIPRO_DMA
+    volatile bool dma_busy;     // DMA copy to the CPort TX buffer in flight
+    int dma_status;
+    int dma_len;
+#endif
+};
+
 struct cport {
     struct unipro_driver *driver;
     uint8_t *tx_buf;                // TX region for this CPort
@@ -71,24 +103,53 @@ struct cport {
     int connected;
 
     struct list_head tx_fifo;
+
+    /* Descriptors for unipro_send_async(), never more than these in tx_fifo */
+    struct list_head tx_free;
+    struct unipro_buffer tx_descs[CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH];
+    bool tx_throttled;          // a send was refused, notify when writable
+
+    /* TX arbitration, see unipro_tx_worker() */
+    uint8_t tx_prio;
+    uint8_t tx_weight;
+    size_t tx_limit;
+    struct unipro_tx_stats tx_stats;
 };
 
+#define CPORT_BITMAP_WORDS     ((CPORT_MAX + 31) / 32)
+
+#ifndef CONFIG_TSB_UNIPRO_TX_YIELD_COUNT
+#define CONFIG_TSB_UNIPRO_TX_YIELD_COUNT    8
+#endif
+
+#ifndef CONFIG_TSB_UNIPRO_TX_BACKOFF_USEC
+#define CONFIG_TSB_UNIPRO_TX_BACKOFF_USEC   1000
+#endif
+
+#ifndef CONFIG_TSB_UNIPRO_TX_QUEUE_LIMIT
+#define CONFIG_TSB_UNIPRO_TX_QUEUE_LIMIT    0
+#endif
+
 struct worker {
     pthread_t thread;
     sem_t tx_fifo_lock;
+
+    /* CPorts with at least one buffer in their tx_fifo, per priority */
+    uint32_t pending[UNIPRO_TX_PRIORITY_COUNT][CPORT_BITMAP_WORDS];
+
+    /* First CPort to serve on the next round, per priority */
+    unsigned int rr_next[UNIPRO_TX_PRIORITY_COUNT];
+
+    /* Stats about how often the worker had to wait for TX FIFO space */
+    unsigned int yields;
+    unsigned int backoffs;
 };
 
 static struct worker worker;
 
-struct unipro_buffer {
-    struct list_head list;
-    unipro_send_completion_t callback;
-    void *priv;
-    bool som;
-    int byte_sent;
-    int len;
-    const void *data;
-};
+#ifdef CONFIG_TSB_UNIPRO_DMA
+static struct device *unipro_dma_dev;
+#endif
 
 #define CPORT_RX_BUF_BASE         (0x20000000U)
 #define CPORT_RX_BUF_SIZE         (CPORT_BUF_SIZE)
@@ -105,6 +166,9 @@ struct unipro_buffer {
     .rx_buf      = CPORT_RX_BUF(id),   \
     .cportid     = id,                 \
     .connected   = 0,                  \
+    .tx_prio     = UNIPRO_TX_PRIORITY_NORMAL, \
+    .tx_weight   = 1,                  \
+    .tx_limit    = CONFIG_TSB_UNIPRO_TX_QUEUE_LIMIT, \
 }
 
 #define CPORTID_CDSI0    (16)
@@ -154,6 +218,26 @@ static inline struct cport *cport_handle(unsigned int cportid) {
 #define irqn_to_cport(irqn)          cport_handle((irqn - TSB_IRQ_UNIPRO_RX_EOM00))
 #define cportid_to_irqn(cportid)     (TSB_IRQ_UNIPRO_RX_EOM00 + cportid)
 
+static inline void cport_set_pending(struct cport *cport)
+{
+    worker.pending[cport->tx_prio][cport->cportid / 32] |=
+        1 << (cport->cportid % 32);
+}
+
+static inline void cport_clear_pending(struct cport *cport)
+{
+    worker.pending[cport->tx_prio][cport->cportid / 32] &=
+        ~(1 << (cport->cportid % 32));
+}
+
+static uint64_t unipro_tx_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 /* Helpers */
 static uint32_t cport_get_status(struct cport*);
 static inline void clear_rx_interrupt(struct cport*);
@@ -518,6 +602,20 @@ static inline void unipro_set_eom_flag(struct cport *cport)
     putreg8(1, CPORT_EOM_BIT(cport));
 }
 
+/**
+ * @brief           Return where to write data in the CPort TX buffer
+ * @param[in]       cport: CPort handle
+ * @param[in]       som: "start of message" flag
+ */
+static inline uint8_t *cport_tx_dest(struct cport *cport, bool som)
+{
+    /*
+     * If this is not the start of a new message,
+     * message data must be written to first address of CPort Tx Buffer + 1.
+     */
+    return som ? cport->tx_buf : cport->tx_buf + sizeof(uint32_t);
+}
+
 /**
  * @brief UniPro debug dump
  */
@@ -634,6 +732,10 @@ static void dump_regs(void) {
         }
     }
 
+    lldbg("TX worker:\n");
+    lldbg("========================================\n");
+    lldbg("    yields: %u backoffs: %u\n", worker.yields, worker.backoffs);
+
     lldbg("NVIC:\n");
     lldbg("========================================\n");
     tsb_dumpnvic();
@@ -702,29 +804,153 @@ int unipro_init_cport(unsigned int cportid)
     return 0;
 }
 
-static void unipro_dequeue_tx_buffer(struct unipro_buffer *buffer, int status)
+static void unipro_dequeue_tx_buffer(struct cport *cport,
+                                     struct unipro_buffer *buffer, int status)
 {
+    struct unipro_tx_stats *stats = &cport->tx_stats;
+    unipro_send_completion_t callback;
+    const void *data;
+    void *priv;
+    bool throttled;
+    uint64_t delay;
     irqstate_t flags;
 
     DEBUGASSERT(buffer);
 
+    /* The descriptor goes back to the free list before the callback runs */
+    callback = buffer->callback;
+    data = buffer->data;
+    priv = buffer->priv;
+    delay = unipro_tx_time() - buffer->queued;
+
     flags = irqsave();
     list_del(&buffer->list);
+    if (list_is_empty(&cport->tx_fifo)) {
+        cport_clear_pending(cport);
+    }
+    list_add(&cport->tx_free, &buffer->list);
+
+    throttled = cport->tx_throttled;
+    cport->tx_throttled = false;
+    if (throttled) {
+        stats->writable++;
+    }
+
+    stats->queued_msgs--;
+
+    stats->queued_bytes -= buffer->len;
+    if (status) {
+        stats->errors++;
+    } else {
+        stats->messages++;
+        stats->bytes += buffer->len;
+        stats->total_delay += delay;
+        if (delay > stats->max_delay) {
+            stats->max_delay = delay;
+        }
+    }
     irqrestore(flags);
 
-    if (buffer->callback) {
-        buffer->callback(status, buffer->data, buffer->priv);
+    if (callback) {
+        callback(status, data, priv);
+    }
+
+    /* Let the sender know it can try again */
+    if (throttled && cport->driver && cport->driver->tx_writable) {
+        cport->driver->tx_writable(cport->cportid);
+    }
+}
+
+#ifdef CONFIG_TSB_UNIPRO_DMA
+/**
+ * @brief           DMA copy completion callback
+ * @param[in]       dev: DMA device
+ * @param[in]       status: 0 if the copy succeeded, -errno otherwise
+ * @param[in]       arg: UniPro buffer being copied
+ */
+static void unipro_dma_complete(struct device *dev, int status, void *arg)
+{
+    struct unipro_buffer *buffer = arg;
+
+    if (status < 0) {
+        buffer->dma_status = status;
+    } else {
+        buffer->byte_sent += buffer->dma_len;
+        buffer->som = false;
+    }
+    buffer->dma_busy = false;
+
+    /* Let the worker set the EOM flag or send the remaining data */
+    sem_post(&worker.tx_fifo_lock);
+}
+
+/**
+ * @brief           Copy the next chunk of a buffer to the CPort using DMA
+ * @return          0 when the buffer has been entirely sent,
+ *                  -EBUSY when a DMA copy has been started,
+ *                  -EAGAIN when waiting for a copy or for TX FIFO space,
+ *                  -EOPNOTSUPP when the chunk must be copied by the CPU,
+ *                  -EINVAL when the buffer has been dropped.
+ * @param[in]       cport: CPort handle
+ * @param[in]       buffer: buffer at the head of the CPort tx_fifo
+ */
+static int unipro_send_tx_buffer_dma(struct cport *cport,
+                                     struct unipro_buffer *buffer)
+{
+    uint16_t count;
+    int retval;
+
+    if (buffer->dma_busy) {
+        return -EAGAIN;
+    }
+
+    if (buffer->dma_status < 0) {
+        unipro_dequeue_tx_buffer(cport, buffer, buffer->dma_status);
+        lldbg("DMA copy failed. Dropping message...\n");
+        return -EINVAL;
+    }
+
+    /*
+     * The CPU path also sets the EOM flag once everything has been copied,
+     * so never start an empty copy.
+     */
+    if (!unipro_dma_dev || buffer->byte_sent >= buffer->len ||
+        buffer->len - buffer->byte_sent < CONFIG_TSB_UNIPRO_DMA_THRESHOLD) {
+        return -EOPNOTSUPP;
+    }
+
+    count = unipro_get_tx_free_buffer_space(cport);
+    if (!count) {
+        return -EAGAIN;
+    } else if (count > buffer->len - buffer->byte_sent) {
+        count = buffer->len - buffer->byte_sent;
     }
 
-    free(buffer);
+    buffer->dma_len = count;
+    buffer->dma_busy = true;
+
+    retval = device_dma_memcpy(unipro_dma_dev,
+                               cport_tx_dest(cport, buffer->som),
+                               buffer->data + buffer->byte_sent, count,
+                               unipro_dma_complete, buffer);
+    if (retval) {
+        /* No DMA descriptor available, let the CPU do the copy */
+        buffer->dma_busy = false;
+        return -EOPNOTSUPP;
+    }
+
+    return -EBUSY;
 }
+#endif
 
 /**
  * @brief           send data over given UniPro CPort
  * @return          0 on success, -EINVAL on invalid parameter,
  *                  -EBUSY when buffer could not be completely transferred
  *                  (unipro_send_tx_buffer() shall be called again until
- *                  buffer is enterily sent (return value == 0)).
+ *                  buffer is enterily sent (return value == 0)),
+ *                  -EAGAIN when nothing could be written because the
+ *                  CPort TX FIFO is full.
  * @param[in]       operation: greybus loopback operation
  */
 static int unipro_send_tx_buffer(struct cport *cport)
@@ -748,58 +974,173 @@ static int unipro_send_tx_buffer(struct cport *cport)
 
     irqrestore(flags);
 
+#ifdef CONFIG_TSB_UNIPRO_DMA
+    retval = unipro_send_tx_buffer_dma(cport, buffer);
+    if (retval != -EOPNOTSUPP) {
+        return retval;
+    }
+#endif
+
+    if (buffer->byte_sent >= buffer->len) {
+        unipro_set_eom_flag(cport);
+        unipro_dequeue_tx_buffer(cport, buffer, 0);
+        return 0;
+    }
+
     retval = unipro_send_sync(cport->cportid,
                               buffer->data + buffer->byte_sent,
                               buffer->len - buffer->byte_sent, buffer->som);
     if (retval < 0) {
-        unipro_dequeue_tx_buffer(buffer, retval);
+        unipro_dequeue_tx_buffer(cport, buffer, retval);
         lldbg("unipro_send_sync failed. Dropping message...\n");
         return -EINVAL;
     }
 
+    if (retval == 0) {
+        return -EAGAIN;
+    }
+
     buffer->som = false;
     buffer->byte_sent += retval;
 
     if (buffer->byte_sent >= buffer->len) {
         unipro_set_eom_flag(cport);
-        unipro_dequeue_tx_buffer(buffer, 0);
+        unipro_dequeue_tx_buffer(cport, buffer, 0);
         return 0;
     }
 
     return -EBUSY;
 }
 
+/**
+ * @brief           Wait for the CPort TX FIFOs to drain
+ *
+ * The ES2 bridge does not raise any interrupt when TX buffer space becomes
+ * available, so back off instead of spinning: first yield the CPU to the
+ * other threads, and if the FIFOs are still full after a few rounds, sleep.
+ * The sleep is cut short as soon as a new buffer gets queued.
+ *
+ * @param[in]       stalls: number of consecutive passes without progress
+ */
+static void unipro_tx_backoff(unsigned int stalls)
+{
+    struct timespec abstime;
+
+    if (stalls <= CONFIG_TSB_UNIPRO_TX_YIELD_COUNT) {
+        worker.yields++;
+        sched_yield();
+        return;
+    }
+
+    worker.backoffs++;
+
+    clock_gettime(CLOCK_REALTIME, &abstime);
+    abstime.tv_nsec += CONFIG_TSB_UNIPRO_TX_BACKOFF_USEC * 1000;
+    while (abstime.tv_nsec >= 1000000000) {
+        abstime.tv_sec++;
+        abstime.tv_nsec -= 1000000000;
+    }
+
+    sem_timedwait(&worker.tx_fifo_lock, &abstime);
+}
+
+/**
+ * @brief           Serve the pending CPorts of one priority level
+ *
+ * The CPorts are served in round-robin, starting one CPort further on every
+ * round, and each CPort may move up to tx_weight chunks of data (as much as
+ * its TX FIFO accepts at once) before the next one gets its turn.
+ *
+ * @return          true if any data was moved
+ * @param[in]       prio: priority level to serve
+ * @param[in]       pending: snapshot of the pending CPorts of that level
+ */
+static bool unipro_tx_serve(unsigned int prio, const uint32_t *pending)
+{
+    unsigned int first = worker.rr_next[prio];
+    struct cport *cport;
+    bool progress = false;
+    unsigned int cportid;
+    unsigned int chunk;
+    unsigned int i;
+    int retval;
+
+    for (i = 0; i < CPORT_MAX; i++) {
+        cportid = (first + i) % CPORT_MAX;
+        if (!(pending[cportid / 32] & (1 << (cportid % 32)))) {
+            continue;
+        }
+
+        cport = cport_handle(cportid);
+        for (chunk = 0; chunk < cport->tx_weight; chunk++) {
+            retval = unipro_send_tx_buffer(cport);
+            if (retval == -EAGAIN) {
+                break;
+            }
+
+            progress = true;
+            if (list_is_empty(&cport->tx_fifo)) {
+                break;
+            }
+        }
+    }
+
+    worker.rr_next[prio] = (first + 1) % CPORT_MAX;
+    return progress;
+}
+
 /**
  * @brief           Send data buffer(s) on CPort whenever ready.
  *                  Ensure that TX queues are reinspected until
  *                  all CPorts have no work available.
  *                  Then suspend again until new data is available.
+ *
+ * Priority levels are served in strict order: a level is only looked at
+ * when no CPort of a higher level could make progress, either because
+ * their queues are empty or because their TX FIFOs are full.
  */
 static void *unipro_tx_worker(void *data)
 {
-    int i;
-    bool is_busy;
-    int retval;
+    uint32_t pending[UNIPRO_TX_PRIORITY_COUNT][CPORT_BITMAP_WORDS];
+    unsigned int stalls = 0;
+    unsigned int prio;
+    unsigned int i;
+    irqstate_t flags;
+    bool is_idle;
+    bool progress;
 
     while (1) {
-        /* Block until a buffer is pending on any CPort */
-        sem_wait(&worker.tx_fifo_lock);
-
-        do {
-            is_busy = false;
-
-            for (i = 0; i < cport_max(); i++) {
-                /* Browse all CPorts sending any pending buffers */
-                retval = unipro_send_tx_buffer(cport_handle(i));
-                if (retval == -EBUSY) {
-                    /*
-                     * Buffer only partially sent, have to try again for
-                     * remaining part.
-                     */
-                    is_busy = true;
+        flags = irqsave();
+        memcpy(pending, worker.pending, sizeof(pending));
+        irqrestore(flags);
+
+        is_idle = true;
+        for (prio = 0; prio < UNIPRO_TX_PRIORITY_COUNT; prio++) {
+            for (i = 0; i < CPORT_BITMAP_WORDS; i++) {
+                if (pending[prio][i]) {
+                    is_idle = false;
                 }
             }
-        } while (is_busy); /* exit when CPort(s) current pending buffer sent */
+        }
+
+        if (is_idle) {
+            /* Block until a buffer is pending on any CPort */
+            stalls = 0;
+            sem_wait(&worker.tx_fifo_lock);
+            continue;
+        }
+
+        progress = false;
+        for (prio = 0; prio < UNIPRO_TX_PRIORITY_COUNT && !progress; prio++) {
+            progress = unipro_tx_serve(prio, pending[prio]);
+        }
+
+        if (progress) {
+            stalls = 0;
+        } else {
+            /* Every pending CPort has a full TX FIFO */
+            unipro_tx_backoff(++stalls);
+        }
     }
 
     return NULL;
@@ -810,7 +1151,7 @@ static void *unipro_tx_worker(void *data)
  */
 void unipro_init(void)
 {
-    unsigned int i;
+    unsigned int i, j;
     int retval;
     struct cport *cport;
 
@@ -828,9 +1169,20 @@ void unipro_init(void)
         cport = cport_handle(i);
         if (cport) {
             list_init(&cport->tx_fifo);
+            list_init(&cport->tx_free);
+            for (j = 0; j < ARRAY_SIZE(cport->tx_descs); j++) {
+                list_add(&cport->tx_free, &cport->tx_descs[j].list);
+            }
         }
     }
 
+#ifdef CONFIG_TSB_UNIPRO_DMA
+    unipro_dma_dev = device_open(DEVICE_TYPE_DMA_HW, 0);
+    if (!unipro_dma_dev) {
+        lldbg("No DMA engine available, using CPU copies.\n");
+    }
+#endif
+
     if (es2_fixup_mphy()) {
         lldbg("Failed to apply M-PHY fixups (results in link instability at HS-G1).\n");
     }
@@ -861,7 +1213,15 @@ void unipro_init(void)
 
 /**
  * @brief           send data over UniPro asynchronously (not blocking)
- * @return          0 on success, <0 otherwise
+ *
+ * Buffers are queued on pre-allocated descriptors, so that the queue of a
+ * CPort is bounded by CONFIG_TSB_UNIPRO_TX_QUEUE_DEPTH messages and by its
+ * queue limit in bytes. When either is reached, the call fails with -EAGAIN
+ * and the tx_writable() handler of the CPort driver is called once a queued
+ * buffer has been sent.
+ *
+ * @return          0 on success, -EAGAIN when the CPort queue is full,
+ *                  <0 otherwise
  * @param[in]       cportid: target CPort ID
  * @param[in]       buf: data buffer
  * @param[in]       len: data buffer length (in bytes)
@@ -874,6 +1234,7 @@ int unipro_send_async(unsigned int cportid, const void *buf, size_t len,
     struct cport *cport;
     struct unipro_buffer *buffer;
     irqstate_t flags;
+    uint64_t queued;
 
     if (len > CPORT_BUF_SIZE) {
         return -EINVAL;
@@ -891,25 +1252,161 @@ int unipro_send_async(unsigned int cportid, const void *buf, size_t len,
 
     DEBUGASSERT(TRANSFER_MODE == 2);
 
-    buffer = zalloc(sizeof(*buffer));
-    if (!buffer) {
-        return -ENOMEM;
+    queued = unipro_tx_time();
+
+    flags = irqsave();
+
+    /* Push back on the sender, but never refuse a buffer to an idle CPort */
+    if (list_is_empty(&cport->tx_free) ||
+        (cport->tx_limit && !list_is_empty(&cport->tx_fifo) &&
+         cport->tx_stats.queued_bytes + len > cport->tx_limit)) {
+        cport->tx_stats.rejected++;
+        cport->tx_throttled = true;
+        irqrestore(flags);
+        return -EAGAIN;
     }
+
+    buffer = list_entry(cport->tx_free.next, struct unipro_buffer, list);
+    list_del(&buffer->list);
+
+    memset(buffer, 0, sizeof(*buffer));
     list_init(&buffer->list);
     buffer->som = true;
     buffer->len = len;
     buffer->callback = callback;
     buffer->priv = priv;
     buffer->data = buf;
+    buffer->queued = queued;
 
-    flags = irqsave();
     list_add(&cport->tx_fifo, &buffer->list);
+    cport_set_pending(cport);
+
+    cport->tx_stats.queued_bytes += len;
+    if (cport->tx_stats.queued_bytes > cport->tx_stats.max_queued_bytes) {
+        cport->tx_stats.max_queued_bytes = cport->tx_stats.queued_bytes;
+    }
+    if (++cport->tx_stats.queued_msgs > cport->tx_stats.max_queued_msgs) {
+        cport->tx_stats.max_queued_msgs = cport->tx_stats.queued_msgs;
+    }
     irqrestore(flags);
 
     sem_post(&worker.tx_fifo_lock);
     return 0;
 }
 
+/**
+ * @brief           Set the TX priority and weight of a CPort
+ * @return          0 on success, -EINVAL on invalid parameter
+ * @param[in]       cportid: CPort ID
+ * @param[in]       prio: priority level, UNIPRO_TX_PRIORITY_HIGH first
+ * @param[in]       weight: number of chunks the CPort may send per
+ *                  round-robin turn among the CPorts of its level
+ */
+int unipro_set_tx_priority(unsigned int cportid,
+                           enum unipro_tx_priority prio, unsigned int weight)
+{
+    struct cport *cport;
+    irqstate_t flags;
+    bool pending;
+
+    cport = cport_handle(cportid);
+    if (!cport || prio >= UNIPRO_TX_PRIORITY_COUNT || !weight ||
+        weight > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    flags = irqsave();
+
+    /* Move the CPort over to the pending bitmap of its new level */
+    pending = !list_is_empty(&cport->tx_fifo);
+    if (pending) {
+        cport_clear_pending(cport);
+    }
+    cport->tx_prio = prio;
+    cport->tx_weight = weight;
+    if (pending) {
+        cport_set_pending(cport);
+    }
+
+    irqrestore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief           Limit the number of bytes queued on a CPort
+ * @return          0 on success, -EINVAL on invalid parameter
+ * @param[in]       cportid: CPort ID
+ * @param[in]       max_bytes: limit above which unipro_send_async() returns
+ *                  -EAGAIN, 0 for no limit
+ */
+int unipro_set_tx_queue_limit(unsigned int cportid, size_t max_bytes)
+{
+    struct cport *cport;
+
+    cport = cport_handle(cportid);
+    if (!cport) {
+        return -EINVAL;
+    }
+
+    cport->tx_limit = max_bytes;
+    return 0;
+}
+
+/**
+ * @brief           Get the TX statistics of a CPort
+ * @return          0 on success, -EINVAL on invalid parameter
+ * @param[in]       cportid: CPort ID
+ * @param[out]      stats: statistics
+ */
+int unipro_get_tx_stats(unsigned int cportid, struct unipro_tx_stats *stats)
+{
+    struct cport *cport;
+    irqstate_t flags;
+
+    cport = cport_handle(cportid);
+    if (!cport || !stats) {
+        return -EINVAL;
+    }
+
+    flags = irqsave();
+    *stats = cport->tx_stats;
+    irqrestore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief           Reset the TX statistics of a CPort
+ *
+ * The number of bytes and messages currently queued is kept, as they are
+ * still accounted for by the buffers in the queue.
+ *
+ * @param[in]       cportid: CPort ID
+ */
+void unipro_reset_tx_stats(unsigned int cportid)
+{
+    struct cport *cport;
+    irqstate_t flags;
+    uint32_t queued_bytes;
+    uint32_t queued_msgs;
+
+    cport = cport_handle(cportid);
+    if (!cport) {
+        return;
+    }
+
+    flags = irqsave();
+    queued_bytes = cport->tx_stats.queued_bytes;
+    queued_msgs = cport->tx_stats.queued_msgs;
+    memset(&cport->tx_stats, 0, sizeof(cport->tx_stats));
+    cport->tx_stats.queued_bytes = queued_bytes;
+    cport->tx_stats.max_queued_bytes = queued_bytes;
+    cport->tx_stats.queued_msgs = queued_msgs;
+    cport->tx_stats.max_queued_msgs = queued_msgs;
+    irqrestore(flags);
+}
+
 /**
  * @brief send data down a CPort
  * @param cportid cport to send down
@@ -978,15 +1475,7 @@ static int unipro_send_sync(unsigned int cportid,
 
     DEBUGASSERT(TRANSFER_MODE == 2);
 
-    /*
-     * If this is not the start of a new message,
-     * message data must be written to first address of CPort Tx Buffer + 1.
-     */
-    if (!som) {
-        tx_buf = cport->tx_buf + sizeof(uint32_t);
-    } else {
-        tx_buf = cport->tx_buf;
-    }
+    tx_buf = cport_tx_dest(cport, som);
 
     count = unipro_get_tx_free_buffer_space(cport);
     if (!count) {
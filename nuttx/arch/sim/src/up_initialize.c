@@ -46,6 +46,7 @@
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/syslog/ramlog.h>
+#include <nuttx/sched_note.h>
 
 #include "up_internal.h"
 
@@ -122,6 +123,12 @@ void up_initialize(void)
   syslog("SIM: Initializing");
 #endif
 
+  /* Start the performance counter */
+
+#ifdef CONFIG_ARCH_HAVE_PERF
+  up_perf_init();
+#endif
+
   /* Register devices */
 
 #if CONFIG_NFILE_DESCRIPTORS > 0
@@ -134,6 +141,10 @@ void up_initialize(void)
   devzero_register();   /* Standard /dev/zero */
 #endif
 
+#if defined(CONFIG_DRIVER_NOTE)
+  note_register();      /* Scheduler notes, /dev/note */
+#endif
+
 #endif /* CONFIG_NFILE_DESCRIPTORS */
 
   /* Register a console (or not) */
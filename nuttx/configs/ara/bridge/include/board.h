@@ -33,6 +33,10 @@
 #ifndef __ASSEMBLY__
 # include <stdint.h>
 #endif
+
+/* Clocking: the CPU, and its SysTick and DWT cycle counter, run at 96MHz */
+
+#define BOARD_CPU_FREQUENCY     96000000
 #ifndef __ASSEMBLY__
 
 void tsb_boardinitialize(void);
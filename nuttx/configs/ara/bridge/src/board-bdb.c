@@ -35,6 +35,7 @@
 #include <nuttx/config.h>
 #include <nuttx/device.h>
 #include <nuttx/device_table.h>
+#include <nuttx/device_dma.h>
 #include <nuttx/util.h>
 #include <nuttx/usb.h>
 #include <nuttx/i2c.h>
@@ -142,6 +143,10 @@ void board_initialize(void)
 
     tsb_driver_register();
     bdb_driver_register();
+
+#ifdef CONFIG_DMA_SW
+    sw_dma_register();
+#endif
 #endif
 
     board_display_init();
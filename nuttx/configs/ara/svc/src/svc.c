@@ -31,6 +31,7 @@
 #include <nuttx/config.h>
 #include <nuttx/arch.h>
 #include <nuttx/util.h>
+#include <nuttx/clock.h>
 #include <nuttx/greybus/unipro.h>
 
 #include <apps/greybus-utils/utils.h>
@@ -193,6 +194,8 @@ static void manifest_disable(unsigned char *manifest_file,
 }
 
 static int setup_default_routes(struct tsb_switch *sw) {
+    uint32_t start = clock_systimer();
+    struct switch_stats stats;
     int i, j, rc;
     int conn_size;
     uint8_t port_id_0, port_id_1;
@@ -283,6 +286,16 @@ static int setup_default_routes(struct tsb_switch *sw) {
 
     switch_dump_routing_table(sw);
 
+    if (!switch_get_stats(sw, &stats)) {
+        dbg_info("Default routes set up in %u ms: %u connections (max %u us), "
+                 "%u link configurations (max %u us), "
+                 "%u DME accesses, %u batches\n",
+                 TICK2MSEC(clock_systimer() - start),
+                 stats.connections, stats.connection_usec_max,
+                 stats.link_cfgs, stats.link_cfg_usec_max,
+                 stats.dme_ops, stats.dme_batches);
+    }
+
     return 0;
 }
 
@@ -34,6 +34,7 @@
 #define DBG_COMP    DBG_SWITCH
 #include <nuttx/config.h>
 #include <nuttx/arch.h>
+#include <nuttx/clock.h>
 #include <nuttx/greybus/unipro.h>
 #include <errno.h>
 #include <string.h>
@@ -49,6 +50,9 @@
 #include "vreg.h"
 #include "tsb_switch_driver_es1.h"
 #include "tsb_switch_driver_es2.h"
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+#include "tsb_switch_driver_sim.h"
+#endif
 
 #define IRQ_WORKER_DEFPRIO          50
 #define IRQ_WORKER_STACKSIZE        2048
@@ -130,6 +134,11 @@ static void dev_ids_destroy(struct tsb_switch *sw) {
 
 static void switch_power_on_reset(struct tsb_switch *sw)
 {
+    /* The software model has nothing to power */
+    if (sw->pdata->rev == SWITCH_REV_SIM) {
+        return;
+    }
+
     /* Enable the switch power supplies regulator */
     vreg_get(sw->pdata->vreg);
 
@@ -140,6 +149,10 @@ static void switch_power_on_reset(struct tsb_switch *sw)
 
 static void switch_power_off(struct tsb_switch *sw)
 {
+    if (sw->pdata->rev == SWITCH_REV_SIM) {
+        return;
+    }
+
     /* Release the switch power supplies regulator */
     vreg_put(sw->pdata->vreg);
 
@@ -169,6 +182,7 @@ int switch_dme_set(struct tsb_switch *sw,
     if (!sw->ops->set) {
         return -EOPNOTSUPP;
     }
+    sw->stats.dme_ops++;
     return sw->ops->set(sw, portid, attrid, select_index, attr_value);
 }
 
@@ -180,6 +194,7 @@ int switch_dme_get(struct tsb_switch *sw,
     if (!sw->ops->get) {
         return -EOPNOTSUPP;
     }
+    sw->stats.dme_ops++;
     return sw->ops->get(sw, portid, attrid, select_index, attr_value);
 }
 
@@ -191,6 +206,7 @@ int switch_dme_peer_set(struct tsb_switch *sw,
     if (!sw->ops->peer_set) {
         return -EOPNOTSUPP;
     }
+    sw->stats.dme_ops++;
     return sw->ops->peer_set(sw, portid, attrid, select_index, attr_value);
 }
 
@@ -202,9 +218,149 @@ int switch_dme_peer_get(struct tsb_switch *sw,
     if (!sw->ops->peer_get) {
         return -EOPNOTSUPP;
     }
+    sw->stats.dme_ops++;
     return sw->ops->peer_get(sw, portid, attrid, select_index, attr_value);
 }
 
+/**
+ * @brief Perform a single DME access of a batch
+ */
+static int switch_dme_op_do(struct tsb_switch *sw, struct switch_dme_op *op)
+{
+    switch (op->type) {
+    case SWITCH_DME_SET:
+        return switch_dme_set(sw, op->portid, op->attrid, op->select_index,
+                              op->value);
+    case SWITCH_DME_GET:
+        return switch_dme_get(sw, op->portid, op->attrid, op->select_index,
+                              &op->value);
+    case SWITCH_DME_PEER_SET:
+        return switch_dme_peer_set(sw, op->portid, op->attrid,
+                                   op->select_index, op->value);
+    case SWITCH_DME_PEER_GET:
+        return switch_dme_peer_get(sw, op->portid, op->attrid,
+                                   op->select_index, &op->value);
+    default:
+        return -EINVAL;
+    }
+}
+
+void switch_dme_batch_init(struct switch_dme_batch *batch)
+{
+    batch->count = 0;
+    batch->overflow = false;
+}
+
+/**
+ * @brief Queue a DME access in a batch
+ *
+ * @return index of the access in the batch, -ENOSPC if the batch is full
+ */
+int switch_dme_batch_add(struct switch_dme_batch *batch,
+                         enum switch_dme_op_type type,
+                         uint8_t portid,
+                         uint16_t attrid,
+                         uint16_t select_index,
+                         uint32_t attr_value)
+{
+    struct switch_dme_op *op;
+
+    if (batch->count >= SWITCH_DME_BATCH_MAX) {
+        batch->overflow = true;
+        return -ENOSPC;
+    }
+
+    op = &batch->ops[batch->count];
+    op->type = type;
+    op->portid = portid;
+    op->attrid = attrid;
+    op->select_index = select_index;
+    op->value = attr_value;
+    op->rc = -EINTR;
+
+    return batch->count++;
+}
+
+/**
+ * @brief Perform all the DME accesses queued in a batch
+ *
+ * The result of each access is stored in its rc field, and the value of
+ * the attributes read in its value field.
+ *
+ * A batch does not stop at the first failed access. Switches that pipeline
+ * the accesses (ES2) have already sent some of the following ones to the
+ * switch, and those are performed. The accesses that were not performed
+ * have their rc set to -EINTR. Callers must not queue an access in the same
+ * batch as the accesses it depends on: submit them first and check the
+ * result.
+ *
+ * The batch is emptied once submitted. Nothing is performed if an access
+ * could not be queued in the batch.
+ *
+ * @return 0 if all accesses succeeded, result of the first failed one
+ *         otherwise, -ENOSPC if the batch overflowed
+ */
+int switch_dme_batch_submit(struct tsb_switch *sw,
+                            struct switch_dme_batch *batch)
+{
+    unsigned int i;
+    int rc = 0;
+
+    if (batch->overflow) {
+        dbg_error("%s(): too many DME accesses in batch\n", __func__);
+        switch_dme_batch_init(batch);
+        return -ENOSPC;
+    }
+
+    if (!batch->count) {
+        return 0;
+    }
+
+    if (sw->ops->dme_batch) {
+        rc = sw->ops->dme_batch(sw, batch->ops, batch->count);
+        for (i = 0; i < batch->count; i++) {
+            if (batch->ops[i].rc != -EINTR) {
+                sw->stats.dme_ops++;
+            }
+        }
+    } else {
+        for (i = 0; i < batch->count && !rc; i++) {
+            rc = switch_dme_op_do(sw, &batch->ops[i]);
+            batch->ops[i].rc = rc;
+        }
+    }
+
+    sw->stats.dme_batches++;
+    batch->count = 0;
+
+    return rc;
+}
+
+/**
+ * @brief Get the access counters and link bring-up timings of the switch
+ */
+int switch_get_stats(struct tsb_switch *sw, struct switch_stats *stats)
+{
+    if (!sw || !stats) {
+        return -EINVAL;
+    }
+
+    memcpy(stats, &sw->stats, sizeof(*stats));
+    return 0;
+}
+
+/* Accounts the time elapsed since start, with a system tick resolution */
+static void switch_stats_add_time(uint32_t *total, uint32_t *max,
+                                  uint32_t start)
+{
+    uint32_t usec = TICK2USEC(clock_systimer() - start);
+
+    *total += usec;
+    if (usec > *max) {
+        *max = usec;
+    }
+}
+
 int switch_port_irq_enable(struct tsb_switch *sw,
                            uint8_t portid,
                            bool enable) {
@@ -495,117 +651,79 @@ int switch_irq_handler(struct tsb_switch *sw) {
     return sw->ops->switch_irq_handler(sw);
 }
 
-static int switch_set_port_l4attr(struct tsb_switch *sw,
-                                  uint8_t portid,
-                                  uint16_t attrid,
-                                  uint16_t selector,
-                                  uint32_t val) {
-    int rc;
+static int switch_batch_port_l4attr(struct switch_dme_batch *batch,
+                                    bool set,
+                                    uint8_t portid,
+                                    uint16_t attrid,
+                                    uint16_t selector,
+                                    uint32_t val) {
+    enum switch_dme_op_type type;
 
     if (portid == SWITCH_PORT_ID) {
-        rc = switch_dme_set(sw, portid, attrid, selector, val);
+        type = set ? SWITCH_DME_SET : SWITCH_DME_GET;
     } else {
-        rc = switch_dme_peer_set(sw, portid, attrid, selector, val);
+        type = set ? SWITCH_DME_PEER_SET : SWITCH_DME_PEER_GET;
     }
 
-    return rc;
+    return switch_dme_batch_add(batch, type, portid, attrid, selector, val);
 }
 
-static int switch_get_port_l4attr(struct tsb_switch *sw,
-                                  uint8_t portid,
-                                  uint16_t attrid,
-                                  uint16_t selector,
-                                  uint32_t *val) {
-    int rc;
-
-    if (portid == SWITCH_PORT_ID) {
-        rc = switch_dme_get(sw, portid, attrid, selector, val);
-    } else {
-        rc = switch_dme_peer_get(sw, portid, attrid, selector, val);
-    }
-
-    return rc;
-}
-
-
-static int switch_set_pair_attr(struct tsb_switch *sw,
-                                struct unipro_connection *c,
-                                uint16_t attrid,
-                                uint32_t val0,
-                                uint32_t val1) {
-    int rc;
-    rc = switch_set_port_l4attr(sw,
-            c->port_id0,
-            attrid,
-            c->cport_id0,
-            val0);
-    if (rc) {
-        return rc;
-    }
-
-    rc = switch_set_port_l4attr(sw,
-            c->port_id1,
-            attrid,
-            c->cport_id1,
-            val1);
-    if (rc) {
-        return rc;
-    }
-
-    return 0;
+static void switch_batch_pair_attr(struct switch_dme_batch *batch,
+                                   struct unipro_connection *c,
+                                   uint16_t attrid,
+                                   uint32_t val0,
+                                   uint32_t val1) {
+    switch_batch_port_l4attr(batch, true, c->port_id0, attrid, c->cport_id0,
+                             val0);
+    switch_batch_port_l4attr(batch, true, c->port_id1, attrid, c->cport_id1,
+                             val1);
 }
 
 static int switch_cport_connect(struct tsb_switch *sw,
                                 struct unipro_connection *c) {
     int e2efc_enabled = (!!(c->flags & CPORT_FLAGS_E2EFC) == 1);
     int csd_enabled = (!!(c->flags & CPORT_FLAGS_CSD_N) == 0);
+    int need_local = e2efc_enabled || (!e2efc_enabled && csd_enabled);
+    struct switch_dme_batch batch;
+    uint32_t cport0_local = 0;
+    uint32_t cport1_local = 0;
+    int local0 = -1;
+    int local1 = -1;
     int rc = 0;
 
+    switch_dme_batch_init(&batch);
+
     /* Disable any existing connection(s). */
-    rc = switch_set_pair_attr(sw, c, T_CONNECTIONSTATE, 0, 0);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_CONNECTIONSTATE, 0, 0);
 
     /*
      * Point each device at the other.
      */
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              T_PEERDEVICEID,
-                              c->device_id1,
-                              c->device_id0);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch,
+                           c,
+                           T_PEERDEVICEID,
+                           c->device_id1,
+                           c->device_id0);
 
     /*
      * Point each CPort at the other.
      */
-    rc = switch_set_pair_attr(sw, c, T_PEERCPORTID, c->cport_id1, c->cport_id0);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_PEERCPORTID, c->cport_id1,
+                           c->cport_id0);
 
     /*
      * Match up traffic classes.
      */
-    rc = switch_set_pair_attr(sw, c, T_TRAFFICCLASS, c->tc, c->tc);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_TRAFFICCLASS, c->tc, c->tc);
 
     /*
      * Make sure the protocol IDs are equal. (We don't use them otherwise.)
      */
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              T_PROTOCOLID,
-                              CPORT_DEFAULT_T_PROTOCOLID,
-                              CPORT_DEFAULT_T_PROTOCOLID);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch,
+                           c,
+                           T_PROTOCOLID,
+                           CPORT_DEFAULT_T_PROTOCOLID,
+                           CPORT_DEFAULT_T_PROTOCOLID);
 
     /*
      * Set default TxTokenValue and RxTokenValue values.
@@ -614,24 +732,16 @@ static int switch_cport_connect(struct tsb_switch *sw,
      * enabled, so don't change them to different values unless you
      * also patch up the E2EFC case, below.
      */
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              T_TXTOKENVALUE,
-                              CPORT_DEFAULT_TOKENVALUE,
-                              CPORT_DEFAULT_TOKENVALUE);
-    if (rc) {
-        return rc;
-    }
-
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              T_RXTOKENVALUE,
-                              CPORT_DEFAULT_TOKENVALUE,
-                              CPORT_DEFAULT_TOKENVALUE);
-    if (rc) {
-        return rc;
-    }
-
+    switch_batch_pair_attr(&batch,
+                           c,
+                           T_TXTOKENVALUE,
+                           CPORT_DEFAULT_TOKENVALUE,
+                           CPORT_DEFAULT_TOKENVALUE);
+    switch_batch_pair_attr(&batch,
+                           c,
+                           T_RXTOKENVALUE,
+                           CPORT_DEFAULT_TOKENVALUE,
+                           CPORT_DEFAULT_TOKENVALUE);
 
     /*
      * Set CPort flags.
@@ -639,87 +749,74 @@ static int switch_cport_connect(struct tsb_switch *sw,
      * (E2EFC needs to be the same on both sides, which is handled by
      * having a single flags value for now.)
      */
-    rc = switch_set_pair_attr(sw, c, T_CPORTFLAGS, c->flags, c->flags);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_CPORTFLAGS, c->flags, c->flags);
 
     /*
      * If E2EFC is enabled, or E2EFC is disabled and CSD is enabled,
      * then each CPort's T_PeerBufferSpace must equal the peer CPort's
-     * T_LocalBufferSpace.
+     * T_LocalBufferSpace. Reading them does not depend on the above.
      */
-    if (e2efc_enabled || (!e2efc_enabled && csd_enabled)) {
-        uint32_t cport0_local = 0;
-        uint32_t cport1_local = 0;
-        rc = switch_get_port_l4attr(sw,
-                c->port_id0,
-                T_LOCALBUFFERSPACE,
-                c->cport_id0,
-                &cport0_local);
-        if (rc) {
-            return rc;
-        }
+    if (need_local) {
+        local0 = switch_batch_port_l4attr(&batch, false, c->port_id0,
+                                          T_LOCALBUFFERSPACE, c->cport_id0, 0);
+        local1 = switch_batch_port_l4attr(&batch, false, c->port_id1,
+                                          T_LOCALBUFFERSPACE, c->cport_id1, 0);
+    }
 
-        rc = switch_get_port_l4attr(sw,
-                c->port_id1,
-                T_LOCALBUFFERSPACE,
-                c->cport_id1,
-                &cport1_local);
-        if (rc) {
-            return rc;
-        }
+    rc = switch_dme_batch_submit(sw, &batch);
+    if (rc) {
+        return rc;
+    }
 
-        rc = switch_set_pair_attr(sw,
-                                  c,
-                                  T_LOCALBUFFERSPACE,
-                                  cport0_local,
-                                  cport1_local);
-        if (rc) {
-            return rc;
-        }
+    if (need_local) {
+        cport0_local = batch.ops[local0].value;
+        cport1_local = batch.ops[local1].value;
+        switch_batch_pair_attr(&batch,
+                               c,
+                               T_LOCALBUFFERSPACE,
+                               cport0_local,
+                               cport1_local);
     }
 
     /*
      * Ensure the CPorts aren't in test mode.
      */
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              T_CPORTMODE,
-                              CPORT_MODE_APPLICATION,
-                              CPORT_MODE_APPLICATION);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch,
+                           c,
+                           T_CPORTMODE,
+                           CPORT_MODE_APPLICATION,
+                           CPORT_MODE_APPLICATION);
 
     /*
      * Clear out the credits to send on each side.
      */
-    rc = switch_set_pair_attr(sw, c, T_CREDITSTOSEND, 0, 0);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_CREDITSTOSEND, 0, 0);
 
     /*
      * XXX Toshiba-specific TSB_MaxSegmentConfig (move to bridge ASIC code.)
      */
-    rc = switch_set_pair_attr(sw,
-                              c,
-                              TSB_MAXSEGMENTCONFIG,
-                              CPORT_DEFAULT_TSB_MAXSEGMENTCONFIG,
-                              CPORT_DEFAULT_TSB_MAXSEGMENTCONFIG);
+    switch_batch_pair_attr(&batch,
+                           c,
+                           TSB_MAXSEGMENTCONFIG,
+                           CPORT_DEFAULT_TSB_MAXSEGMENTCONFIG,
+                           CPORT_DEFAULT_TSB_MAXSEGMENTCONFIG);
+
+    /*
+     * Accesses following a failed one may already have been performed,
+     * so the connections are only established in a batch of their own,
+     * once the whole configuration is known to be in place.
+     */
+    rc = switch_dme_batch_submit(sw, &batch);
     if (rc) {
         return rc;
     }
+
     /*
      * Establish the connections!
      */
-    rc = switch_set_pair_attr(sw, c, T_CONNECTIONSTATE, 1, 1);
-    if (rc) {
-        return rc;
-    }
+    switch_batch_pair_attr(&batch, c, T_CONNECTIONSTATE, 1, 1);
 
-    return rc;
+    return switch_dme_batch_submit(sw, &batch);
 }
 
 static int switch_cport_disconnect(struct tsb_switch *sw,
@@ -897,6 +994,7 @@ int switch_setup_routing_table(struct tsb_switch *sw,
  */
 int switch_connection_create(struct tsb_switch *sw,
                              struct unipro_connection *c) {
+    uint32_t start;
     int rc;
 
     if (!c) {
@@ -904,6 +1002,8 @@ int switch_connection_create(struct tsb_switch *sw,
         goto err0;
     }
 
+    start = clock_systimer();
+
     dbg_info("Creating connection: "
              "[p=%u,d=%u,c=%u]<->[p=%u,d=%u,c=%u] "
              "TC: %u Flags: 0x%x\n",
@@ -945,6 +1045,10 @@ int switch_connection_create(struct tsb_switch *sw,
         goto err0;
     }
 
+    sw->stats.connections++;
+    switch_stats_add_time(&sw->stats.connection_usec_total,
+                          &sw->stats.connection_usec_max, start);
+
     return 0;
 
 #if !(CONFIG_ARCH_BOARD_ARA_BDB2A_SVC || CONFIG_ARCH_BOARD_ARA_SDB_SVC)
@@ -1149,181 +1253,164 @@ static int switch_active_cfg_is_sane(const struct unipro_pwr_cfg *pcfg,
     return 1;
 }
 
-static int switch_configure_link_tx(struct tsb_switch *sw,
-                                    uint8_t port_id,
-                                    const struct unipro_pwr_cfg *tx,
-                                    uint32_t tx_term) {
-    int rc = 0;
+static void switch_configure_link_tx(struct switch_dme_batch *batch,
+                                     uint8_t port_id,
+                                     const struct unipro_pwr_cfg *tx,
+                                     uint32_t tx_term) {
     /* If it needs changing, apply the TX side of the new link
      * configuration. */
     if (tx->upro_mode != UNIPRO_MODE_UNCHANGED) {
-        rc = switch_dme_set(sw, port_id, PA_TXGEAR,
-                            UNIPRO_SELINDEX_NULL, tx->upro_gear) ||
-            switch_dme_set(sw, port_id, PA_TXTERMINATION,
-                           UNIPRO_SELINDEX_NULL, tx_term) ||
-            switch_dme_set(sw, port_id, PA_ACTIVETXDATALANES,
-                           UNIPRO_SELINDEX_NULL, tx->upro_nlanes);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id, PA_TXGEAR,
+                             UNIPRO_SELINDEX_NULL, tx->upro_gear);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id, PA_TXTERMINATION,
+                             UNIPRO_SELINDEX_NULL, tx_term);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id,
+                             PA_ACTIVETXDATALANES, UNIPRO_SELINDEX_NULL,
+                             tx->upro_nlanes);
     }
-    return rc;
 }
 
-static int switch_configure_link_rx(struct tsb_switch *sw,
-                                    uint8_t port_id,
-                                    const struct unipro_pwr_cfg *rx,
-                                    uint32_t rx_term) {
-    int rc = 0;
+static void switch_configure_link_rx(struct switch_dme_batch *batch,
+                                     uint8_t port_id,
+                                     const struct unipro_pwr_cfg *rx,
+                                     uint32_t rx_term) {
     /* If it needs changing, apply the RX side of the new link
      * configuration.
      */
     if (rx->upro_mode != UNIPRO_MODE_UNCHANGED) {
-        rc = switch_dme_set(sw, port_id, PA_RXGEAR,
-                            UNIPRO_SELINDEX_NULL, rx->upro_gear) ||
-            switch_dme_set(sw, port_id, PA_RXTERMINATION,
-                           UNIPRO_SELINDEX_NULL, rx_term) ||
-            switch_dme_set(sw, port_id, PA_ACTIVERXDATALANES,
-                           UNIPRO_SELINDEX_NULL, rx->upro_nlanes);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id, PA_RXGEAR,
+                             UNIPRO_SELINDEX_NULL, rx->upro_gear);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id, PA_RXTERMINATION,
+                             UNIPRO_SELINDEX_NULL, rx_term);
+        switch_dme_batch_add(batch, SWITCH_DME_SET, port_id,
+                             PA_ACTIVERXDATALANES, UNIPRO_SELINDEX_NULL,
+                             rx->upro_nlanes);
     }
-    return rc;
 }
 
-static int switch_configure_link_user_data
-        (struct tsb_switch *sw,
+static void switch_configure_link_user_data
+        (struct switch_dme_batch *batch,
          uint8_t port_id,
          const struct unipro_pwr_user_data *udata) {
-    int rc = 0;
     const uint32_t flags = udata->flags;
     if (flags & UPRO_PWRF_FC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA0,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_fc0_protection_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA0,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_fc0_protection_timeout);
     }
     if (flags & UPRO_PWRF_TC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA1,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_tc0_replay_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA1,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_tc0_replay_timeout);
     }
     if (flags & UPRO_PWRF_AFC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA2,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_afc0_req_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA2,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_afc0_req_timeout);
     }
     if (flags & UPRO_PWRF_FC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA3,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_fc1_protection_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA3,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_fc1_protection_timeout);
     }
     if (flags & UPRO_PWRF_TC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA4,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_tc1_replay_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA4,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_tc1_replay_timeout);
     }
     if (flags & UPRO_PWRF_AFC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            PA_PWRMODEUSERDATA5,
-                            UNIPRO_SELINDEX_NULL,
-                            udata->upro_pwr_afc1_req_timeout);
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             PA_PWRMODEUSERDATA5,
+                             UNIPRO_SELINDEX_NULL,
+                             udata->upro_pwr_afc1_req_timeout);
     }
-    return rc;
 }
 
-static int switch_configure_link_tsbdata
-        (struct tsb_switch *sw,
+static void switch_configure_link_tsbdata
+        (struct switch_dme_batch *batch,
          uint8_t port_id,
          const struct tsb_local_l2_timer_cfg *tcfg) {
-    int rc = 0;
     const unsigned int flags = tcfg->tsb_flags;
     if (flags & TSB_LOCALL2F_FC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_FC0PROTECTIONTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_fc0_protection_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_FC0PROTECTIONTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_fc0_protection_timeout);
     }
     if (flags & TSB_LOCALL2F_TC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_TC0REPLAYTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_tc0_replay_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_TC0REPLAYTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_tc0_replay_timeout);
     }
     if (flags & TSB_LOCALL2F_AFC0) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_AFC0REQTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_afc0_req_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_AFC0REQTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_afc0_req_timeout);
     }
     if (flags & TSB_LOCALL2F_FC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_FC1PROTECTIONTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_fc1_protection_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_FC1PROTECTIONTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_fc1_protection_timeout);
     }
     if (flags & TSB_LOCALL2F_TC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_TC1REPLAYTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_tc1_replay_timeout);
-        if (rc) {
-            return rc;
-        }
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_TC1REPLAYTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_tc1_replay_timeout);
     }
     if (flags & TSB_LOCALL2F_AFC1) {
-        rc = switch_dme_set(sw,
-                            port_id,
-                            DME_AFC1REQTIMEOUTVAL,
-                            UNIPRO_SELINDEX_NULL,
-                            tcfg->tsb_afc1_req_timeout);
+        switch_dme_batch_add(batch,
+                             SWITCH_DME_SET,
+                             port_id,
+                             DME_AFC1REQTIMEOUTVAL,
+                             UNIPRO_SELINDEX_NULL,
+                             tcfg->tsb_afc1_req_timeout);
     }
-    return rc;
 }
 
+/*
+ * Submits the link configuration queued in the batch, then starts the power
+ * mode change and waits for its completion.
+ */
 static int switch_apply_power_mode(struct tsb_switch *sw,
+                                   struct switch_dme_batch *batch,
                                    uint8_t port_id,
                                    uint32_t pwr_mode) {
     const int max_tries = 100;
     int rc;
     uint32_t val;
+    int ind;
+    int pwr;
     int i;
 
     dbg_insane("%s(): enter, port=%u, pwr_mode=0x%x\n", __func__, port_id,
@@ -1333,18 +1420,45 @@ static int switch_apply_power_mode(struct tsb_switch *sw,
      * Clear out the results of a previous failed or timed-out power
      * mode change, if any.
      */
-    rc = switch_dme_get(sw, port_id, TSB_DME_POWERMODEIND,
-                        UNIPRO_SELINDEX_NULL, &val);
-    if (!rc) {
+    ind = switch_dme_batch_add(batch, SWITCH_DME_GET, port_id,
+                               TSB_DME_POWERMODEIND, UNIPRO_SELINDEX_NULL, 0);
+    pwr = switch_dme_batch_add(batch, SWITCH_DME_SET, port_id, PA_PWRMODE,
+                               UNIPRO_SELINDEX_NULL, pwr_mode);
+
+    rc = switch_dme_batch_submit(sw, batch);
+    if (ind < 0 || pwr < 0) {
+        dbg_error("%s(): can't configure link: %d\n", __func__, rc);
+        goto out;
+    }
+
+    /* The power mode change must not start on a half-configured link */
+    for (i = 0; i < ind; i++) {
+        if (batch->ops[i].rc) {
+            rc = batch->ops[i].rc;
+            dbg_error("%s(): can't configure link: %d\n", __func__, rc);
+            goto out;
+        }
+    }
+
+    if (!batch->ops[ind].rc) {
         dbg_verbose("%s(): previous TSB_DME_POWERMODEIND=0x%x\n",
-                    __func__, val);
+                    __func__, batch->ops[ind].value);
     } else {
         dbg_error("%s(): can't clear TSB_DME_POWERMODEIND: %d\n",
-                  __func__, rc);
+                  __func__, batch->ops[ind].rc);
+    }
+
+    /*
+     * Only request the power mode change again if the batch stopped before
+     * it: on ES2, it has normally been performed after the failed GET.
+     */
+    if (batch->ops[pwr].rc == -EINTR) {
+        rc = switch_dme_set(sw, port_id, PA_PWRMODE, UNIPRO_SELINDEX_NULL,
+                            pwr_mode);
+    } else {
+        rc = batch->ops[pwr].rc;
     }
 
-    rc = switch_dme_set(sw, port_id, PA_PWRMODE, UNIPRO_SELINDEX_NULL,
-                        pwr_mode);
     if (rc) {
         dbg_error("%s(): can't set PA_PWRMODE (0x%x) to 0x%x: %d\n",
                   __func__, PA_PWRMODE, pwr_mode, rc);
@@ -1456,6 +1570,8 @@ int switch_configure_link(struct tsb_switch *sw,
                           const struct unipro_link_cfg *cfg,
                           const struct tsb_link_cfg *tcfg) {
     int rc = 0;
+    struct switch_dme_batch batch;
+    uint32_t start = clock_systimer();
     const struct unipro_pwr_cfg *tx = &cfg->upro_tx_cfg;
     uint32_t tx_term = !!(cfg->flags & UPRO_LINKF_TX_TERMINATION);
     const struct unipro_pwr_cfg *rx = &cfg->upro_rx_cfg;
@@ -1466,6 +1582,8 @@ int switch_configure_link(struct tsb_switch *sw,
 
     dbg_verbose("%s(): port=%d\n", __func__, port_id);
 
+    switch_dme_batch_init(&batch);
+
     /* FIXME ADD JIRA support hibernation and link off modes. */
     if (tx->upro_mode == UNIPRO_HIBERNATE_MODE ||
         tx->upro_mode == UNIPRO_OFF_MODE ||
@@ -1485,51 +1603,41 @@ int switch_configure_link(struct tsb_switch *sw,
     /* Changes to a link's HS series require special preparation, and
      * involve restrictions on the power mode to apply next.
      *
-     * Handle that properly before setting PA_HSSERIES. */
+     * Handle that properly before setting PA_HSSERIES.
+     *
+     * PA_HSSERIES and the rest of the configuration are queued in a single
+     * batch, submitted along with the power mode change. */
     if (cfg->upro_hs_ser != UNIPRO_HS_SERIES_UNCHANGED) {
         rc = switch_prep_for_series_change(sw, port_id, cfg, &pwr_mode);
         if (rc) {
             goto out;
         }
-        rc = switch_dme_set(sw, port_id, PA_HSSERIES, UNIPRO_SELINDEX_NULL,
-                            cfg->upro_hs_ser);
-        if (rc) {
-            dbg_error("%s(): can't change PA_HSSeries: %d\n",
-                      __func__, rc);
-            goto out;
-        }
+        switch_dme_batch_add(&batch, SWITCH_DME_SET, port_id, PA_HSSERIES,
+                             UNIPRO_SELINDEX_NULL, cfg->upro_hs_ser);
     }
 
     /* Apply TX and RX link reconfiguration as needed. */
-    rc = switch_configure_link_tx(sw, port_id, tx, tx_term) ||
-        switch_configure_link_rx(sw, port_id, rx, rx_term);
-    if (rc) {
-        goto out;
-    }
+    switch_configure_link_tx(&batch, port_id, tx, tx_term);
+    switch_configure_link_rx(&batch, port_id, rx, rx_term);
 
     /* Handle scrambling. */
-    rc = switch_dme_set(sw, port_id, PA_SCRAMBLING,
-                        UNIPRO_SELINDEX_NULL, scrambling);
-    if (rc) {
-        goto out;
-    }
+    switch_dme_batch_add(&batch, SWITCH_DME_SET, port_id, PA_SCRAMBLING,
+                         UNIPRO_SELINDEX_NULL, scrambling);
 
     /* Set any DME user data we understand. */
-    rc = switch_configure_link_user_data(sw, port_id, udata);
-    if (rc) {
-        goto out;
-    }
+    switch_configure_link_user_data(&batch, port_id, udata);
 
     /* Handle Toshiba extensions to the link configuration procedure. */
     if (tcfg) {
-        rc = switch_configure_link_tsbdata(sw, port_id, &tcfg->tsb_l2tim_cfg);
-    }
-    if (rc) {
-        goto out;
+        switch_configure_link_tsbdata(&batch, port_id, &tcfg->tsb_l2tim_cfg);
     }
 
     /* Kick off the actual power mode change, and see what happens. */
-    rc = switch_apply_power_mode(sw, port_id, pwr_mode);
+    rc = switch_apply_power_mode(sw, &batch, port_id, pwr_mode);
+
+    sw->stats.link_cfgs++;
+    switch_stats_add_time(&sw->stats.link_cfg_usec_total,
+                          &sw->stats.link_cfg_usec_max, start);
  out:
     dbg_insane("%s(): exit, rc=%d\n", __func__, rc);
     return rc;
@@ -1633,6 +1741,11 @@ struct tsb_switch *switch_init(struct tsb_switch_data *pdata) {
 
     list_init(&sw->listeners);
 
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    /* The software model stands in for whatever switch the board has */
+    pdata->rev = SWITCH_REV_SIM;
+#endif
+
     switch_power_on_reset(sw);
 
     switch (sw->pdata->rev) {
@@ -1647,6 +1760,13 @@ struct tsb_switch *switch_init(struct tsb_switch_data *pdata) {
             goto error;
         }
         break;
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    case SWITCH_REV_SIM:
+        if (tsb_switch_sim_init(sw)) {
+            goto error;
+        }
+        break;
+#endif
     default:
         dbg_error("Unsupported switch revision: %u\n", sw->pdata->rev);
         goto error;
@@ -1729,6 +1849,11 @@ void switch_exit(struct tsb_switch *sw) {
     case SWITCH_REV_ES2:
         tsb_switch_es2_exit(sw);
         break;
+#ifdef CONFIG_ARA_SVC_SWITCH_SIM
+    case SWITCH_REV_SIM:
+        tsb_switch_sim_exit(sw);
+        break;
+#endif
     default:
         dbg_error("Unsupported switch revision: %u\n", sw->pdata->rev);
         break;
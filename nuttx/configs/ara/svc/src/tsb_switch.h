@@ -188,6 +188,67 @@ struct tsb_link_cfg {
     struct tsb_local_l2_timer_cfg tsb_l2tim_cfg;
 };
 
+/**
+ * @brief DME attribute accesses that can be queued in a batch
+ */
+enum switch_dme_op_type {
+    SWITCH_DME_SET,
+    SWITCH_DME_GET,
+    SWITCH_DME_PEER_SET,
+    SWITCH_DME_PEER_GET,
+};
+
+/* Largest number of DME accesses in one batch */
+#define SWITCH_DME_BATCH_MAX        (24)
+
+/**
+ * @brief One DME attribute access of a batch
+ */
+struct switch_dme_op {
+    uint8_t type;
+    uint8_t portid;
+    uint16_t attrid;
+    uint16_t select_index;
+    /** value to set, or value read once the batch completed */
+    uint32_t value;
+    /** result of the access, -EINTR if it was not performed */
+    int rc;
+};
+
+/**
+ * @brief DME attribute accesses submitted together to the switch
+ *
+ * Accesses are performed in the order they were queued. The switch driver
+ * may have several of them in flight, which saves a bus round trip per
+ * access. Processing stops at the first failed access.
+ *
+ * @see switch_dme_batch_submit()
+ */
+struct switch_dme_batch {
+    unsigned int count;
+    /** an access did not fit, the batch will not be submitted */
+    bool overflow;
+    struct switch_dme_op ops[SWITCH_DME_BATCH_MAX];
+};
+
+/**
+ * @brief Switch access counters and link bring-up timings
+ */
+struct switch_stats {
+    /** DME attribute accesses */
+    uint32_t dme_ops;
+    /** DME batches submitted */
+    uint32_t dme_batches;
+    /** connections created, and time spent creating them (usec) */
+    uint32_t connections;
+    uint32_t connection_usec_total;
+    uint32_t connection_usec_max;
+    /** link configurations, and time spent configuring links (usec) */
+    uint32_t link_cfgs;
+    uint32_t link_cfg_usec_total;
+    uint32_t link_cfg_usec_max;
+};
+
 /**
  * Switch structs
  */
@@ -255,6 +316,11 @@ struct tsb_switch_ops {
     int (*switch_irq_enable)(struct tsb_switch *sw,
                              bool enable);
     int (*switch_irq_handler)(struct tsb_switch *sw);
+
+    /* Optional, DME accesses are done one by one when not provided */
+    int (*dme_batch)(struct tsb_switch *sw,
+                     struct switch_dme_op *ops,
+                     unsigned int count);
 };
 
 struct tsb_switch {
@@ -268,6 +334,7 @@ struct tsb_switch {
     uint8_t                 dev_ids[SWITCH_PORT_MAX];
 
     struct list_head        listeners;
+    struct switch_stats     stats;
 };
 
 enum tsb_switch_event_type {
@@ -477,7 +544,8 @@ struct tsb_switch_data {
 
 enum {
     SWITCH_REV_ES1 = 1,
-    SWITCH_REV_ES2 = 2
+    SWITCH_REV_ES2 = 2,
+    SWITCH_REV_SIM = 3,     /* software model, see tsb_switch_sim.c */
 };
 
 struct tsb_switch *switch_init(struct tsb_switch_data *pdata);
@@ -511,6 +579,24 @@ int switch_dme_peer_get(struct tsb_switch *sw,
                         uint16_t select_index,
                         uint32_t *attr_value);
 
+/*
+ * Batched DME access
+ */
+
+void switch_dme_batch_init(struct switch_dme_batch *batch);
+
+int switch_dme_batch_add(struct switch_dme_batch *batch,
+                         enum switch_dme_op_type type,
+                         uint8_t portid,
+                         uint16_t attrid,
+                         uint16_t select_index,
+                         uint32_t attr_value);
+
+int switch_dme_batch_submit(struct tsb_switch *sw,
+                            struct switch_dme_batch *batch);
+
+int switch_get_stats(struct tsb_switch *sw, struct switch_stats *stats);
+
 int switch_port_irq_enable(struct tsb_switch *sw,
                            uint8_t portid,
                            bool enable);
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef  _TSB_SWITCH_DRIVER_SIM_H_
+#define  _TSB_SWITCH_DRIVER_SIM_H_
+
+#include <stdint.h>
+
+#include "tsb_switch.h"
+
+/**
+ * @brief Counters kept by the software switch model
+ */
+struct switch_sim_stats {
+    /** module insertions and removals */
+    uint32_t inserts;
+    uint32_t removes;
+    /** mailbox writes injected */
+    uint32_t mailboxes;
+    /** port interrupts raised, and handled by the IRQ worker */
+    uint32_t irqs_raised;
+    uint32_t irqs_handled;
+    /** passes of the IRQ handler */
+    uint32_t handler_runs;
+    /** time from an interrupt being raised to it being handled (usec) */
+    uint32_t irq_usec_total;
+    uint32_t irq_usec_max;
+    /** NCP round-trips a real switch would have needed */
+    uint32_t ncp_transfers;
+};
+
+int tsb_switch_sim_init(struct tsb_switch *);
+void tsb_switch_sim_exit(struct tsb_switch *);
+
+/*
+ * Scenario control: these act on the model as if a module had been
+ * plugged or unplugged, or had written its mailbox, and raise the
+ * corresponding port interrupts.
+ */
+int switch_sim_module_insert(struct tsb_switch *sw, uint8_t port_id);
+int switch_sim_module_remove(struct tsb_switch *sw, uint8_t port_id);
+int switch_sim_mailbox(struct tsb_switch *sw, uint8_t port_id, uint32_t val);
+bool switch_sim_module_present(struct tsb_switch *sw, uint8_t port_id);
+int switch_sim_wait_idle(struct tsb_switch *sw, unsigned int timeout_ms);
+
+int switch_sim_get_stats(struct tsb_switch *sw, struct switch_sim_stats *stats);
+void switch_sim_reset_stats(struct tsb_switch *sw);
+
+#endif
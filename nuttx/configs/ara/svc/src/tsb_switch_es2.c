@@ -39,6 +39,7 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <arch/byteorder.h>
@@ -63,6 +64,9 @@
 #define ES2_CPORT_NCP_MAX_PAYLOAD    (256)
 #define ES2_CPORT_DATA_MAX_PAYLOAD   (272)
 
+/* NCP requests of a DME batch written ahead of the CNFs read back */
+#define ES2_NCP_BATCH_WINDOW         (8)
+
 struct es2_cport {
     pthread_mutex_t lock;
     uint8_t rxbuf[ES2_CPORT_RX_MAX_SIZE];
@@ -1100,6 +1104,124 @@ static int es2_peer_get(struct tsb_switch *sw,
     return cnf.rc;
 }
 
+/* DME batch */
+static const uint8_t es2_dme_req_fid[] = {
+    [SWITCH_DME_SET]        = NCP_SETREQ,
+    [SWITCH_DME_GET]        = NCP_GETREQ,
+    [SWITCH_DME_PEER_SET]   = NCP_PEERSETREQ,
+    [SWITCH_DME_PEER_GET]   = NCP_PEERGETREQ,
+};
+
+static size_t es2_dme_req_build(const struct switch_dme_op *op, uint8_t *req)
+{
+    req[0] = SWITCH_DEVICE_ID;
+    req[1] = op->portid;
+    req[2] = es2_dme_req_fid[op->type];
+    req[3] = op->attrid >> 8;
+    req[4] = op->attrid & 0xff;
+    req[5] = op->select_index >> 8;
+    req[6] = op->select_index & 0xff;
+
+    if (op->type == SWITCH_DME_GET || op->type == SWITCH_DME_PEER_GET) {
+        return 7;
+    }
+
+    req[7] = (op->value >> 24) & 0xff;
+    req[8] = (op->value >> 16) & 0xff;
+    req[9] = (op->value >> 8) & 0xff;
+    req[10] = op->value & 0xff;
+    return 11;
+}
+
+static int es2_dme_cnf_read(struct tsb_switch *sw, struct switch_dme_op *op)
+{
+    bool get = op->type == SWITCH_DME_GET || op->type == SWITCH_DME_PEER_GET;
+    int rc;
+
+    struct __attribute__ ((__packed__)) cnf {
+        uint8_t port_id;
+        uint8_t function_id;
+        uint8_t reserved;
+        uint8_t rc;
+        uint32_t attr_val;
+    } cnf;
+
+    rc = es2_read(sw, CPORT_NCP, (uint8_t *) &cnf,
+                  get ? sizeof(cnf) : offsetof(struct cnf, attr_val));
+    if (rc) {
+        return rc;
+    }
+
+    /* A CNF function ID is the one of its request plus one */
+    if (cnf.function_id != es2_dme_req_fid[op->type] + 1) {
+        dbg_error("%s(): unexpected CNF 0x%x\n", __func__, cnf.function_id);
+        return -EPROTO;
+    }
+
+    if (get) {
+        op->value = be32_to_cpu(cnf.attr_val);
+    }
+
+    return cnf.rc;
+}
+
+/*
+ * The switch queues NCP requests in the TX entry FIFO of the NCP CPort and
+ * returns their CNFs in order, so up to ES2_NCP_BATCH_WINDOW requests are
+ * written before the oldest CNF is read back. A full FIFO (-EAGAIN) just
+ * means waiting for a CNF. Once an access fails no new request is written,
+ * but the CNFs of the requests already written are still collected.
+ */
+static int es2_dme_batch(struct tsb_switch *sw,
+                         struct switch_dme_op *ops,
+                         unsigned int count)
+{
+    struct sw_es2_priv *priv = sw->priv;
+    uint8_t req[11];
+    unsigned int sent = 0;
+    unsigned int done = 0;
+    size_t len;
+    int ret;
+    int rc = 0;
+
+    pthread_mutex_lock(&priv->ncp_cport.lock);
+
+    while (done < count) {
+        while (!rc && sent < count && sent - done < ES2_NCP_BATCH_WINDOW) {
+            len = es2_dme_req_build(&ops[sent], req);
+            ret = es2_write(sw, CPORT_NCP, req, len);
+            if (ret == -EAGAIN && sent > done) {
+                break;
+            }
+            if (ret) {
+                dbg_error("%s() write failed: rc=%d\n", __func__, ret);
+                ops[sent].rc = rc = ret;
+                break;
+            }
+            sent++;
+        }
+
+        if (done == sent) {
+            break;
+        }
+
+        ops[done].rc = es2_dme_cnf_read(sw, &ops[done]);
+        if (ops[done].rc) {
+            dbg_error("%s(): portId=%u, attrId=0x%04x failed: rc=%d\n",
+                      __func__, ops[done].portid, ops[done].attrid,
+                      ops[done].rc);
+            if (!rc) {
+                rc = ops[done].rc;
+            }
+        }
+        done++;
+    }
+
+    pthread_mutex_unlock(&priv->ncp_cport.lock);
+
+    return rc;
+}
+
 static int es2_lut_set(struct tsb_switch *sw,
                        uint8_t unipro_portid,
                        uint8_t lut_address,
@@ -1562,6 +1684,8 @@ static struct tsb_switch_ops es2_ops = {
 
     .switch_irq_enable     = es2_switch_irq_enable,
     .switch_irq_handler    = es2_switch_irq_handler,
+
+    .dme_batch             = es2_dme_batch,
 };
 
 int tsb_switch_es2_init(struct tsb_switch *sw, unsigned int spi_bus)
@@ -0,0 +1,1075 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software model of the UniPro switch.
+ *
+ * This implements the switch driver operations on top of in-memory state
+ * instead of an NCP link: the routing tables, the device ID masks and the
+ * DME attributes (local, peer and switch internal) are kept in RAM, and
+ * the port interrupts are raised by the scenario functions that simulate
+ * module insertion, removal and mailbox writes. It lets the SVC routing,
+ * connection setup and hotplug code be exercised and timed without a
+ * switch, or with more modules than there are on any board.
+ *
+ * The NCP cost of a real switch can be approximated by busy-waiting
+ * CONFIG_ARA_SVC_SWITCH_SIM_NCP_USEC per round-trip; a batch of DME
+ * accesses costs one round-trip per SIM_NCP_BATCH_WINDOW accesses, as
+ * with the pipelined ES2 transfers.
+ */
+
+#define DBG_COMP    DBG_SWITCH
+
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/util.h>
+
+#include <pthread.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "up_debug.h"
+#include "tsb_switch.h"
+#include "tsb_switch_driver_sim.h"
+#include "tsb_switch_event.h"
+
+#ifndef CONFIG_ARA_SVC_SWITCH_SIM_ATTRS
+#define CONFIG_ARA_SVC_SWITCH_SIM_ATTRS 512
+#endif
+
+#ifndef CONFIG_ARA_SVC_SWITCH_SIM_NCP_USEC
+#define CONFIG_ARA_SVC_SWITCH_SIM_NCP_USEC 0
+#endif
+
+#ifndef CONFIG_ARA_SVC_SWITCH_SIM_PORTS
+#define CONFIG_ARA_SVC_SWITCH_SIM_PORTS 0
+#endif
+
+#define SIM_SWVER               (0x0002)
+#define SIM_LUT_SIZE            (128)
+#define SIM_NCP_BATCH_WINDOW    (8)
+
+/* Port interrupt lines, same numbering as TSB_INTERRUPTSTATUS */
+#define SIM_IRQ_LINKSTARTUPIND  (0x1)
+#define SIM_IRQ_LINKLOSTIND     (0x2)
+#define SIM_IRQ_MAILBOX         (0xf)
+
+enum sim_attr_space {
+    SIM_SPACE_LOCAL,
+    SIM_SPACE_PEER,
+    SIM_SPACE_SWITCH,
+    SIM_SPACE_SYSCTRL,
+};
+
+enum sim_attr_state {
+    SIM_ATTR_FREE,
+    SIM_ATTR_USED,
+    SIM_ATTR_DELETED,
+};
+
+struct sim_attr {
+    uint8_t state;
+    uint8_t space;
+    uint8_t portid;
+    uint16_t attrid;
+    uint16_t select_index;
+    uint32_t value;
+};
+
+struct sim_port {
+    bool present;
+    bool irq_enabled;
+    /* pending interrupt lines, cleared by reading TSB_INTERRUPTSTATUS */
+    uint32_t irq_status;
+    /* system time at which the oldest pending line was raised */
+    uint32_t irq_raised;
+};
+
+struct sw_sim_priv {
+    pthread_mutex_t lock;
+    bool irq_enabled;
+    struct sim_port ports[SWITCH_PORT_MAX];
+    uint8_t lut[SWITCH_PORT_MAX][SIM_LUT_SIZE];
+    uint8_t dev_id_mask[SWITCH_PORT_MAX][16];
+    struct switch_sim_stats stats;
+    /* open-addressed table of every attribute written so far */
+    struct sim_attr attrs[CONFIG_ARA_SVC_SWITCH_SIM_ATTRS];
+};
+
+/* Peer attributes of a freshly inserted module */
+static const struct {
+    uint16_t attrid;
+    uint32_t value;
+} sim_module_attrs[] = {
+    { DME_DDBL1_REVISION,       0x0010 },
+    { DME_DDBL1_LEVEL,          0x0003 },
+    { DME_DDBL1_DEVICECLASS,    0x0000 },
+    { DME_DDBL1_MANUFACTURERID, 0x0126 },
+    { DME_DDBL1_PRODUCTID,      0x1000 },
+    { DME_DDBL1_LENGTH,         0x0008 },
+    { PA_CONNECTEDTXDATALANES,  PA_CONN_TX_DATA_LANES_NR },
+    { PA_CONNECTEDRXDATALANES,  PA_CONN_RX_DATA_LANES_NR },
+};
+
+static unsigned int sim_attr_hash(uint8_t space, uint8_t portid,
+                                  uint16_t attrid, uint16_t select_index)
+{
+    uint32_t key = ((uint32_t) attrid << 16) | select_index;
+
+    key ^= (((uint32_t) space << 8) | portid) * 2654435761u;
+    return key % CONFIG_ARA_SVC_SWITCH_SIM_ATTRS;
+}
+
+/*
+ * Look an attribute up, or allocate it if create is set. Must be called
+ * with the model locked.
+ */
+static struct sim_attr *sim_attr_find(struct sw_sim_priv *priv, uint8_t space,
+                                      uint8_t portid, uint16_t attrid,
+                                      uint16_t select_index, bool create)
+{
+    struct sim_attr *attr = NULL;
+    struct sim_attr *reuse = NULL;
+    unsigned int idx;
+    unsigned int i;
+
+    idx = sim_attr_hash(space, portid, attrid, select_index);
+    for (i = 0; i < CONFIG_ARA_SVC_SWITCH_SIM_ATTRS; i++) {
+        attr = &priv->attrs[(idx + i) % CONFIG_ARA_SVC_SWITCH_SIM_ATTRS];
+        if (attr->state == SIM_ATTR_FREE) {
+            break;
+        }
+        if (attr->state == SIM_ATTR_DELETED) {
+            if (!reuse) {
+                reuse = attr;
+            }
+            continue;
+        }
+        if (attr->space == space && attr->portid == portid &&
+            attr->attrid == attrid && attr->select_index == select_index) {
+            return attr;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    if (!reuse) {
+        if (i == CONFIG_ARA_SVC_SWITCH_SIM_ATTRS) {
+            dbg_error("%s(): attribute table full\n", __func__);
+            return NULL;
+        }
+        reuse = attr;
+    }
+
+    reuse->state = SIM_ATTR_USED;
+    reuse->space = space;
+    reuse->portid = portid;
+    reuse->attrid = attrid;
+    reuse->select_index = select_index;
+    reuse->value = 0;
+
+    return reuse;
+}
+
+static int sim_attr_write(struct sw_sim_priv *priv, uint8_t space,
+                          uint8_t portid, uint16_t attrid,
+                          uint16_t select_index, uint32_t value)
+{
+    struct sim_attr *attr;
+
+    attr = sim_attr_find(priv, space, portid, attrid, select_index, true);
+    if (!attr) {
+        return -ENOSPC;
+    }
+
+    attr->value = value;
+    return 0;
+}
+
+/* Attributes never written read back as zero, their reset value */
+static uint32_t sim_attr_read(struct sw_sim_priv *priv, uint8_t space,
+                              uint8_t portid, uint16_t attrid,
+                              uint16_t select_index)
+{
+    struct sim_attr *attr;
+
+    attr = sim_attr_find(priv, space, portid, attrid, select_index, false);
+    return attr ? attr->value : 0;
+}
+
+static void sim_attr_forget(struct sw_sim_priv *priv, uint8_t space,
+                            uint8_t portid)
+{
+    unsigned int i;
+
+    for (i = 0; i < CONFIG_ARA_SVC_SWITCH_SIM_ATTRS; i++) {
+        if (priv->attrs[i].state == SIM_ATTR_USED &&
+            priv->attrs[i].space == space &&
+            priv->attrs[i].portid == portid) {
+            priv->attrs[i].state = SIM_ATTR_DELETED;
+        }
+    }
+}
+
+/* Account for the NCP round-trips the access would cost on a real switch */
+static void sim_ncp_cost(struct sw_sim_priv *priv, unsigned int transfers)
+{
+    priv->stats.ncp_transfers += transfers;
+    if (CONFIG_ARA_SVC_SWITCH_SIM_NCP_USEC) {
+        up_udelay(transfers * CONFIG_ARA_SVC_SWITCH_SIM_NCP_USEC);
+    }
+}
+
+static bool sim_port_irq_deliverable(struct sw_sim_priv *priv, uint8_t portid)
+{
+    return priv->ports[portid].irq_enabled &&
+           priv->ports[portid].irq_status;
+}
+
+/* Raise a port interrupt line. Must be called with the model locked. */
+static void sim_raise_irq(struct tsb_switch *sw, uint8_t portid,
+                          unsigned int line)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    struct sim_port *port = &priv->ports[portid];
+
+    if (!port->irq_status) {
+        port->irq_raised = clock_systimer();
+    }
+    port->irq_status |= 1 << line;
+    priv->stats.irqs_raised++;
+
+    if (priv->irq_enabled && port->irq_enabled) {
+        switch_post_irq(sw);
+    }
+}
+
+static int sim_local_set(struct sw_sim_priv *priv, uint8_t portid,
+                         uint16_t attrid, uint16_t select_index,
+                         uint32_t value)
+{
+    uint32_t ind;
+    int rc;
+
+    rc = sim_attr_write(priv, SIM_SPACE_LOCAL, portid, attrid, select_index,
+                        value);
+    if (rc || attrid != PA_PWRMODE) {
+        return rc;
+    }
+
+    /* Power mode changes complete immediately, if there is a link */
+    ind = priv->ports[portid].present ? TSB_DME_POWERMODEIND_LOCAL :
+                                        TSB_DME_POWERMODEIND_FATAL_ERR;
+    return sim_attr_write(priv, SIM_SPACE_LOCAL, portid, TSB_DME_POWERMODEIND,
+                          UNIPRO_SELINDEX_NULL, ind);
+}
+
+static int sim_local_get(struct sw_sim_priv *priv, uint8_t portid,
+                         uint16_t attrid, uint16_t select_index,
+                         uint32_t *value)
+{
+    struct sim_port *port = &priv->ports[portid];
+    struct sim_attr *attr;
+    uint32_t usec;
+    uint32_t lines;
+
+    switch (attrid) {
+    case TSB_INTERRUPTSTATUS:
+        *value = port->irq_status;
+        if (port->irq_status) {
+            for (lines = port->irq_status; lines; lines &= lines - 1) {
+                priv->stats.irqs_handled++;
+            }
+            usec = TICK2USEC(clock_systimer() - port->irq_raised);
+            priv->stats.irq_usec_total += usec;
+            if (usec > priv->stats.irq_usec_max) {
+                priv->stats.irq_usec_max = usec;
+            }
+            port->irq_status = 0;
+        }
+        return 0;
+    case TSB_DME_POWERMODEIND:
+        /* Cleared on read */
+        attr = sim_attr_find(priv, SIM_SPACE_LOCAL, portid, attrid,
+                             select_index, false);
+        *value = attr ? attr->value : TSB_DME_POWERMODEIND_NONE;
+        if (attr) {
+            attr->value = TSB_DME_POWERMODEIND_NONE;
+        }
+        return 0;
+    default:
+        *value = sim_attr_read(priv, SIM_SPACE_LOCAL, portid, attrid,
+                               select_index);
+        return 0;
+    }
+}
+
+static int sim_peer_set(struct sw_sim_priv *priv, uint8_t portid,
+                        uint16_t attrid, uint16_t select_index,
+                        uint32_t value)
+{
+    if (!priv->ports[portid].present) {
+        return -EIO;
+    }
+
+    return sim_attr_write(priv, SIM_SPACE_PEER, portid, attrid, select_index,
+                          value);
+}
+
+static int sim_peer_get(struct sw_sim_priv *priv, uint8_t portid,
+                        uint16_t attrid, uint16_t select_index,
+                        uint32_t *value)
+{
+    if (!priv->ports[portid].present) {
+        return -EIO;
+    }
+
+    *value = sim_attr_read(priv, SIM_SPACE_PEER, portid, attrid,
+                           select_index);
+    return 0;
+}
+
+static int sim_set(struct tsb_switch *sw,
+                   uint8_t portid,
+                   uint16_t attrid,
+                   uint16_t select_index,
+                   uint32_t attr_value)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    if (portid >= SWITCH_PORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_local_set(priv, portid, attrid, select_index, attr_value);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_get(struct tsb_switch *sw,
+                   uint8_t portid,
+                   uint16_t attrid,
+                   uint16_t select_index,
+                   uint32_t *attr_value)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    if (portid >= SWITCH_PORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_local_get(priv, portid, attrid, select_index, attr_value);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_dme_peer_set(struct tsb_switch *sw,
+                            uint8_t portid,
+                            uint16_t attrid,
+                            uint16_t select_index,
+                            uint32_t attr_value)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    if (portid >= SWITCH_UNIPORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_peer_set(priv, portid, attrid, select_index, attr_value);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_dme_peer_get(struct tsb_switch *sw,
+                            uint8_t portid,
+                            uint16_t attrid,
+                            uint16_t select_index,
+                            uint32_t *attr_value)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    if (portid >= SWITCH_UNIPORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_peer_get(priv, portid, attrid, select_index, attr_value);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_dme_batch(struct tsb_switch *sw,
+                         struct switch_dme_op *ops,
+                         unsigned int count)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    struct switch_dme_op *op;
+    unsigned int i;
+    int rc = 0;
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, (count + SIM_NCP_BATCH_WINDOW - 1) / SIM_NCP_BATCH_WINDOW);
+
+    /* Like the NCP batches, stop at the first failed access */
+    for (i = 0; i < count && !rc; i++) {
+        op = &ops[i];
+
+        if (op->portid >= SWITCH_PORT_MAX ||
+            (op->portid >= SWITCH_UNIPORT_MAX &&
+             (op->type == SWITCH_DME_PEER_SET ||
+              op->type == SWITCH_DME_PEER_GET))) {
+            rc = -EINVAL;
+        } else {
+            switch (op->type) {
+            case SWITCH_DME_SET:
+                rc = sim_local_set(priv, op->portid, op->attrid,
+                                   op->select_index, op->value);
+                break;
+            case SWITCH_DME_GET:
+                rc = sim_local_get(priv, op->portid, op->attrid,
+                                   op->select_index, &op->value);
+                break;
+            case SWITCH_DME_PEER_SET:
+                rc = sim_peer_set(priv, op->portid, op->attrid,
+                                  op->select_index, op->value);
+                break;
+            case SWITCH_DME_PEER_GET:
+                rc = sim_peer_get(priv, op->portid, op->attrid,
+                                  op->select_index, &op->value);
+                break;
+            default:
+                rc = -EINVAL;
+                break;
+            }
+        }
+
+        op->rc = rc;
+    }
+
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_port_irq_enable(struct tsb_switch *sw,
+                               uint8_t port_id,
+                               bool enable)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    if (port_id >= SWITCH_PORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    priv->ports[port_id].irq_enabled = enable;
+    if (priv->irq_enabled && sim_port_irq_deliverable(priv, port_id)) {
+        switch_post_irq(sw);
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_lut_set(struct tsb_switch *sw,
+                       uint8_t unipro_portid,
+                       uint8_t addr,
+                       uint8_t dst_portid)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    if (unipro_portid >= SWITCH_PORT_MAX || addr >= SIM_LUT_SIZE) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    priv->lut[unipro_portid][addr] = dst_portid;
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_lut_get(struct tsb_switch *sw,
+                       uint8_t unipro_portid,
+                       uint8_t addr,
+                       uint8_t *dst_portid)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    if (unipro_portid >= SWITCH_PORT_MAX || addr >= SIM_LUT_SIZE) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    *dst_portid = priv->lut[unipro_portid][addr];
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_dump_routing_table(struct tsb_switch *sw)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int devid, unipro_portid;
+
+    dbg_info("======================================================\n");
+    dbg_info("Routing table:\n");
+    dbg_info(" [Port,DevId] -> [Port]\n");
+
+    pthread_mutex_lock(&priv->lock);
+    for (unipro_portid = 0; unipro_portid <= SWITCH_PORT_ID; unipro_portid++) {
+        for (devid = 0; devid < SIM_LUT_SIZE; devid++) {
+            if (priv->dev_id_mask[unipro_portid][15 - devid / 8] &
+                (1 << (devid % 8))) {
+                dbg_info(" [%2u,%2u] -> %2u\n", unipro_portid, devid,
+                         priv->lut[unipro_portid][devid]);
+            }
+        }
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    dbg_info("======================================================\n");
+
+    return 0;
+}
+
+static int sim_switch_attr_get(struct tsb_switch *sw,
+                               uint16_t attrid,
+                               uint32_t *val)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int i;
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+
+    switch (attrid) {
+    case SWVER:
+        *val = SIM_SWVER;
+        break;
+    case SWSTA:
+        *val = 0;
+        for (i = 0; i < SWITCH_UNIPORT_MAX; i++) {
+            if (priv->ports[i].present) {
+                *val |= 1 << i;
+            }
+        }
+        break;
+    case SWINT:
+        *val = 0;
+        for (i = 0; i < SWITCH_PORT_MAX; i++) {
+            if (sim_port_irq_deliverable(priv, i)) {
+                *val |= 1 << i;
+            }
+        }
+        break;
+    default:
+        *val = sim_attr_read(priv, SIM_SPACE_SWITCH, 0, attrid, 0);
+        break;
+    }
+
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_switch_attr_set(struct tsb_switch *sw,
+                               uint16_t attrid,
+                               uint32_t val)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_attr_write(priv, SIM_SPACE_SWITCH, 0, attrid, 0, val);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_switch_id_set(struct tsb_switch *sw,
+                             uint8_t cportid,
+                             uint8_t peer_cportid,
+                             uint8_t dis,
+                             uint8_t irt)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    dbg_verbose("%s(): cportid=%u, peer_cportid=%u, dis=%u, irt=%u\n",
+                __func__, cportid, peer_cportid, dis, irt);
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_sys_ctrl_set(struct tsb_switch *sw,
+                            uint16_t sc_addr,
+                            uint32_t val)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int rc;
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    rc = sim_attr_write(priv, SIM_SPACE_SYSCTRL, 0, sc_addr, 0, val);
+    pthread_mutex_unlock(&priv->lock);
+
+    return rc;
+}
+
+static int sim_sys_ctrl_get(struct tsb_switch *sw,
+                            uint16_t sc_addr,
+                            uint32_t *val)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    *val = sim_attr_read(priv, SIM_SPACE_SYSCTRL, 0, sc_addr, 0);
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_dev_id_mask_get(struct tsb_switch *sw,
+                               uint8_t unipro_portid,
+                               uint8_t *dst)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    if (unipro_portid >= SWITCH_PORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    memcpy(dst, priv->dev_id_mask[unipro_portid],
+           sizeof(priv->dev_id_mask[unipro_portid]));
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_dev_id_mask_set(struct tsb_switch *sw,
+                               uint8_t unipro_portid,
+                               uint8_t *mask)
+{
+    struct sw_sim_priv *priv = sw->priv;
+
+    if (unipro_portid >= SWITCH_PORT_MAX) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&priv->lock);
+    sim_ncp_cost(priv, 1);
+    memcpy(priv->dev_id_mask[unipro_portid], mask,
+           sizeof(priv->dev_id_mask[unipro_portid]));
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static int sim_switch_irq_enable(struct tsb_switch *sw, bool enable)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    int i;
+
+    pthread_mutex_lock(&priv->lock);
+    priv->irq_enabled = enable;
+    if (enable) {
+        for (i = 0; i < SWITCH_PORT_MAX; i++) {
+            if (sim_port_irq_deliverable(priv, i)) {
+                switch_post_irq(sw);
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+/* Same flow as the ES2 handler, so that it costs the same DME accesses */
+static int sim_switch_irq_handler(struct tsb_switch *sw)
+{
+    struct sw_sim_priv *priv = sw->priv;
+    struct tsb_switch_event e;
+    uint32_t swint, port_irq_status, attr_value;
+    int i;
+
+    do {
+        if (switch_internal_getattr(sw, SWINT, &swint)) {
+            dbg_error("IRQ: SWINT register read failed\n");
+            return -EIO;
+        }
+        dbg_insane("IRQ: SWINT=0x%x\n", swint);
+
+        for (i = 0; i < SWITCH_PORT_MAX; i++) {
+            if (!(swint & (1 << i))) {
+                continue;
+            }
+
+            if (switch_dme_get(sw, i, TSB_INTERRUPTSTATUS, 0x0,
+                               &port_irq_status)) {
+                dbg_error("IRQ: TSB_INTERRUPTSTATUS(%d) register read failed\n",
+                          i);
+                break;
+            }
+            dbg_insane("IRQ: TSB_INTERRUPTSTATUS(%d)=0x%04x\n",
+                       i, port_irq_status);
+
+            if (port_irq_status & (1 << SIM_IRQ_LINKSTARTUPIND)) {
+                dbg_info("IRQ: port %d link up\n", i);
+            }
+            if (port_irq_status & (1 << SIM_IRQ_LINKLOSTIND)) {
+                dbg_info("IRQ: port %d link lost\n", i);
+            }
+            if (port_irq_status & (1 << SIM_IRQ_MAILBOX)) {
+                if (switch_dme_get(sw, i, TSB_MAILBOX, 0x0, &attr_value)) {
+                    dbg_error("IRQ: port %d mailbox read failed\n", i);
+                    continue;
+                }
+                e.type = TSB_SWITCH_EVENT_MAILBOX;
+                e.mbox.port = i;
+                e.mbox.val = attr_value;
+                tsb_switch_event_notify(sw, &e);
+            }
+        }
+    } while (swint);
+
+    pthread_mutex_lock(&priv->lock);
+    priv->stats.handler_runs++;
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+static struct tsb_switch_ops sim_ops = {
+    .set                   = sim_set,
+    .get                   = sim_get,
+
+    .peer_set              = sim_dme_peer_set,
+    .peer_get              = sim_dme_peer_get,
+
+    .lut_set               = sim_lut_set,
+    .lut_get               = sim_lut_get,
+    .dump_routing_table    = sim_dump_routing_table,
+
+    .sys_ctrl_set          = sim_sys_ctrl_set,
+    .sys_ctrl_get          = sim_sys_ctrl_get,
+
+    .dev_id_mask_get       = sim_dev_id_mask_get,
+    .dev_id_mask_set       = sim_dev_id_mask_set,
+
+    .port_irq_enable       = sim_port_irq_enable,
+
+    .switch_attr_get       = sim_switch_attr_get,
+    .switch_attr_set       = sim_switch_attr_set,
+    .switch_id_set         = sim_switch_id_set,
+
+    .switch_irq_enable     = sim_switch_irq_enable,
+    .switch_irq_handler    = sim_switch_irq_handler,
+
+    .dme_batch             = sim_dme_batch,
+};
+
+/* Must be called with the model locked */
+static int sim_module_plug(struct sw_sim_priv *priv, uint8_t port_id)
+{
+    unsigned int i;
+    int rc;
+
+    for (i = 0; i < ARRAY_SIZE(sim_module_attrs); i++) {
+        rc = sim_attr_write(priv, SIM_SPACE_PEER, port_id,
+                            sim_module_attrs[i].attrid, UNIPRO_SELINDEX_NULL,
+                            sim_module_attrs[i].value);
+        if (!rc) {
+            rc = sim_attr_write(priv, SIM_SPACE_LOCAL, port_id,
+                                sim_module_attrs[i].attrid,
+                                UNIPRO_SELINDEX_NULL,
+                                sim_module_attrs[i].value);
+        }
+        if (rc) {
+            sim_attr_forget(priv, SIM_SPACE_PEER, port_id);
+            sim_attr_forget(priv, SIM_SPACE_LOCAL, port_id);
+            return rc;
+        }
+    }
+
+    priv->ports[port_id].present = true;
+    return 0;
+}
+
+int switch_sim_module_insert(struct tsb_switch *sw, uint8_t port_id)
+{
+    struct sw_sim_priv *priv;
+    int rc;
+
+    if (!sw || sw->ops != &sim_ops || port_id >= SWITCH_UNIPORT_MAX) {
+        return -EINVAL;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    if (priv->ports[port_id].present) {
+        rc = -EEXIST;
+        goto out;
+    }
+
+    rc = sim_module_plug(priv, port_id);
+    if (rc) {
+        goto out;
+    }
+
+    priv->stats.inserts++;
+    sim_raise_irq(sw, port_id, SIM_IRQ_LINKSTARTUPIND);
+
+out:
+    pthread_mutex_unlock(&priv->lock);
+    return rc;
+}
+
+int switch_sim_module_remove(struct tsb_switch *sw, uint8_t port_id)
+{
+    struct sw_sim_priv *priv;
+    int rc = 0;
+
+    if (!sw || sw->ops != &sim_ops || port_id >= SWITCH_UNIPORT_MAX) {
+        return -EINVAL;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    if (!priv->ports[port_id].present) {
+        rc = -ENODEV;
+        goto out;
+    }
+
+    /* The next module plugged in this port starts from a clean state */
+    priv->ports[port_id].present = false;
+    sim_attr_forget(priv, SIM_SPACE_PEER, port_id);
+    sim_attr_forget(priv, SIM_SPACE_LOCAL, port_id);
+
+    priv->stats.removes++;
+    sim_raise_irq(sw, port_id, SIM_IRQ_LINKLOSTIND);
+
+out:
+    pthread_mutex_unlock(&priv->lock);
+    return rc;
+}
+
+int switch_sim_mailbox(struct tsb_switch *sw, uint8_t port_id, uint32_t val)
+{
+    struct sw_sim_priv *priv;
+    int rc;
+
+    if (!sw || sw->ops != &sim_ops || port_id >= SWITCH_UNIPORT_MAX) {
+        return -EINVAL;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    if (!priv->ports[port_id].present) {
+        rc = -ENODEV;
+        goto out;
+    }
+
+    rc = sim_attr_write(priv, SIM_SPACE_LOCAL, port_id, TSB_MAILBOX,
+                        UNIPRO_SELINDEX_NULL, val);
+    if (rc) {
+        goto out;
+    }
+
+    priv->stats.mailboxes++;
+    sim_raise_irq(sw, port_id, SIM_IRQ_MAILBOX);
+
+out:
+    pthread_mutex_unlock(&priv->lock);
+    return rc;
+}
+
+bool switch_sim_module_present(struct tsb_switch *sw, uint8_t port_id)
+{
+    struct sw_sim_priv *priv;
+    bool present;
+
+    if (!sw || sw->ops != &sim_ops || port_id >= SWITCH_UNIPORT_MAX) {
+        return false;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    present = priv->ports[port_id].present;
+    pthread_mutex_unlock(&priv->lock);
+
+    return present;
+}
+
+/**
+ * @brief Wait for the IRQ worker to handle all the deliverable interrupts
+ *
+ * @return 0 once no interrupt is pending, -ETIMEDOUT otherwise
+ */
+int switch_sim_wait_idle(struct tsb_switch *sw, unsigned int timeout_ms)
+{
+    struct sw_sim_priv *priv;
+    uint32_t start = clock_systimer();
+    bool pending;
+    int i;
+
+    if (!sw || sw->ops != &sim_ops) {
+        return -EINVAL;
+    }
+    priv = sw->priv;
+
+    for (;;) {
+        pending = false;
+
+        pthread_mutex_lock(&priv->lock);
+        for (i = 0; i < SWITCH_PORT_MAX && priv->irq_enabled; i++) {
+            if (sim_port_irq_deliverable(priv, i)) {
+                pending = true;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&priv->lock);
+
+        if (!pending) {
+            return 0;
+        }
+
+        if (TICK2MSEC(clock_systimer() - start) >= timeout_ms) {
+            return -ETIMEDOUT;
+        }
+
+        usleep(1000);
+    }
+}
+
+int switch_sim_get_stats(struct tsb_switch *sw, struct switch_sim_stats *stats)
+{
+    struct sw_sim_priv *priv;
+
+    if (!sw || sw->ops != &sim_ops || !stats) {
+        return -EINVAL;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    *stats = priv->stats;
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+void switch_sim_reset_stats(struct tsb_switch *sw)
+{
+    struct sw_sim_priv *priv;
+
+    if (!sw || sw->ops != &sim_ops) {
+        return;
+    }
+    priv = sw->priv;
+
+    pthread_mutex_lock(&priv->lock);
+    memset(&priv->stats, 0, sizeof(priv->stats));
+    pthread_mutex_unlock(&priv->lock);
+}
+
+int tsb_switch_sim_init(struct tsb_switch *sw)
+{
+    struct sw_sim_priv *priv;
+    int i;
+
+    dbg_info("Initializing switch model...\n");
+
+    priv = zalloc(sizeof(struct sw_sim_priv));
+    if (!priv) {
+        dbg_error("%s: Failed to alloc the priv struct\n", __func__);
+        return -ENOMEM;
+    }
+
+    pthread_mutex_init(&priv->lock, NULL);
+    memset(priv->lut, INVALID_PORT, sizeof(priv->lut));
+
+    /* Modules present at power-on have their link already up */
+    for (i = 0; i < SWITCH_UNIPORT_MAX; i++) {
+        if ((CONFIG_ARA_SVC_SWITCH_SIM_PORTS & (1 << i)) &&
+            sim_module_plug(priv, i)) {
+            dbg_error("%s: Failed to plug a module on port %d\n", __func__, i);
+        }
+    }
+
+    sw->priv = priv;
+    sw->ops = &sim_ops;
+
+    dbg_info("... Done!\n");
+
+    return 0;
+}
+
+void tsb_switch_sim_exit(struct tsb_switch *sw) {
+    struct sw_sim_priv *priv;
+
+    if (!sw)
+        return;
+
+    priv = sw->priv;
+    if (priv) {
+        pthread_mutex_destroy(&priv->lock);
+    }
+    free(priv);
+    sw->priv = NULL;
+    sw->ops = NULL;
+}
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @brief Software DMA engine
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <nuttx/lib.h>
+#include <nuttx/list.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/device.h>
+#include <nuttx/device_table.h>
+#include <nuttx/device_dma.h>
+
+#include <arch/irq.h>
+
+struct sw_dma_request {
+    struct list_head    list;
+    void                *dst;
+    const void          *src;
+    size_t              len;
+    device_dma_callback callback;
+    void                *arg;
+};
+
+struct sw_dma_info {
+    struct device           *dev;
+    struct list_head        free_list;
+    struct list_head        pending_list;
+    sem_t                   pending_sem;
+    pthread_t               thread;
+    struct sw_dma_request   requests[CONFIG_DMA_SW_QUEUE_DEPTH];
+};
+
+static void *sw_dma_thread(void *data)
+{
+    struct sw_dma_info *info = data;
+    struct sw_dma_request *req;
+    device_dma_callback callback;
+    void *arg;
+    irqstate_t flags;
+
+    while (1) {
+        if (sem_wait(&info->pending_sem) < 0)
+            continue;
+
+        flags = irqsave();
+        if (list_is_empty(&info->pending_list)) {
+            irqrestore(flags);
+            continue;
+        }
+        req = list_entry(info->pending_list.next, struct sw_dma_request,
+                         list);
+        list_del(&req->list);
+        irqrestore(flags);
+
+        memcpy(req->dst, req->src, req->len);
+
+        callback = req->callback;
+        arg = req->arg;
+
+        flags = irqsave();
+        list_add(&info->free_list, &req->list);
+        irqrestore(flags);
+
+        if (callback)
+            callback(info->dev, 0, arg);
+    }
+
+    return NULL;
+}
+
+static int sw_dma_op_memcpy(struct device *dev, void *dst, const void *src,
+                            size_t len, device_dma_callback callback,
+                            void *arg)
+{
+    struct sw_dma_info *info = dev->private;
+    struct sw_dma_request *req;
+    irqstate_t flags;
+
+    if (!dst || !src)
+        return -EINVAL;
+
+    flags = irqsave();
+
+    if (list_is_empty(&info->free_list)) {
+        irqrestore(flags);
+        return -EBUSY;
+    }
+
+    req = list_entry(info->free_list.next, struct sw_dma_request, list);
+    list_del(&req->list);
+
+    req->dst = dst;
+    req->src = src;
+    req->len = len;
+    req->callback = callback;
+    req->arg = arg;
+
+    list_add(&info->pending_list, &req->list);
+    sem_post(&info->pending_sem);
+
+    irqrestore(flags);
+
+    return 0;
+}
+
+static int sw_dma_dev_probe(struct device *dev)
+{
+    struct sw_dma_info *info;
+    pthread_attr_t attr;
+    unsigned int i;
+    int ret;
+
+    info = zalloc(sizeof(*info));
+    if (!info)
+        return -ENOMEM;
+
+    list_init(&info->free_list);
+    list_init(&info->pending_list);
+    for (i = 0; i < ARRAY_SIZE(info->requests); i++) {
+        list_init(&info->requests[i].list);
+        list_add(&info->free_list, &info->requests[i].list);
+    }
+
+    sem_init(&info->pending_sem, 0, 0);
+    info->dev = dev;
+    dev->private = info;
+
+    ret = pthread_attr_init(&attr);
+    if (ret)
+        goto err_free_info;
+
+    pthread_attr_setstacksize(&attr, CONFIG_DMA_SW_STACKSIZE);
+    ret = pthread_create(&info->thread, &attr, sw_dma_thread, info);
+    pthread_attr_destroy(&attr);
+    if (ret)
+        goto err_free_info;
+
+    return 0;
+
+err_free_info:
+    sem_destroy(&info->pending_sem);
+    dev->private = NULL;
+    free(info);
+
+    return -ret;
+}
+
+static void sw_dma_dev_remove(struct device *dev)
+{
+    struct sw_dma_info *info = dev->private;
+
+    pthread_cancel(info->thread);
+    pthread_join(info->thread, NULL);
+
+    sem_destroy(&info->pending_sem);
+    free(info);
+    dev->private = NULL;
+}
+
+static struct device_dma_type_ops sw_dma_type_ops = {
+    .memcpy         = sw_dma_op_memcpy,
+};
+
+static struct device_driver_ops sw_dma_driver_ops = {
+    .probe          = sw_dma_dev_probe,
+    .remove         = sw_dma_dev_remove,
+    .type_ops.dma   = &sw_dma_type_ops,
+};
+
+static struct device_driver sw_dma_driver = {
+    .type   = DEVICE_TYPE_DMA_HW,
+    .name   = "sw_dma",
+    .desc   = "Software DMA Engine",
+    .ops    = &sw_dma_driver_ops,
+};
+
+static struct device sw_dma_devices[] = {
+    {
+        .type           = DEVICE_TYPE_DMA_HW,
+        .name           = "sw_dma",
+        .desc           = "Software DMA Engine",
+        .id             = 0,
+    },
+};
+
+static struct device_table sw_dma_device_table = {
+    .device         = sw_dma_devices,
+    .device_count   = ARRAY_SIZE(sw_dma_devices),
+};
+
+int sw_dma_register(void)
+{
+    int ret;
+
+    ret = device_table_register(&sw_dma_device_table);
+    if (ret)
+        return ret;
+
+    return device_register_driver(&sw_dma_driver);
+}
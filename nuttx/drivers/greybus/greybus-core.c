@@ -29,11 +29,14 @@
  */
 
 #include <nuttx/config.h>
+#include <nuttx/clock.h>
 #include <nuttx/list.h>
 #include <nuttx/greybus/greybus.h>
-#include <nuttx/greybus/tape.h>
 #include <nuttx/greybus/debug.h>
 #include <nuttx/wdog.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/arch.h>
+#include <nuttx/sched.h>
 
 #include <arch/tsb/unipro.h>
 #include <arch/atomic.h>
@@ -42,37 +45,104 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "greybus-core.h"
 
 #define DEFAULT_STACK_SIZE      2048
 #define TYPE_RESPONSE_FLAG      0x80
 #define TIMEOUT_IN_MS           1000
 #define GB_INVALID_TYPE         0
 
-#define ONE_SEC_IN_MSEC         1000
-#define ONE_MSEC_IN_NSEC        1000000
+/* Handlers are only looked up for requests */
+#define GB_HANDLER_INDEX_SIZE   TYPE_RESPONSE_FLAG
+
+#define GB_TIMEOUT_TICKS        MSEC2TICK(TIMEOUT_IN_MS)
+
+/* Outgoing requests waiting for a response, hashed by CPort and ID */
+#define GB_INFLIGHT_BUCKETS     32
+
+/* Timeout wheel: slots of 8 ticks, 32 slots */
+#define GB_WHEEL_TICKS          8
+#define GB_WHEEL_SLOTS          32
+
+#ifdef CONFIG_GREYBUS_TX_BATCH
+#define GB_TX_BATCH_IDLE_TICKS \
+    (USEC2TICK(CONFIG_GREYBUS_TX_BATCH_IDLE_USEC) ? \
+     USEC2TICK(CONFIG_GREYBUS_TX_BATCH_IDLE_USEC) : 1)
 
-#define TIMEOUT_WD_DELAY    (TIMEOUT_IN_MS * CLOCKS_PER_SEC) / ONE_SEC_IN_MSEC
+struct gb_tx_batch_msg {
+    struct gb_operation *operation;
+    const void *buf;
+    size_t len;
+};
+
+struct gb_tx_batch {
+    struct work_s work;         /* flush on idle */
+    unsigned int count;
+    size_t bytes;
+    struct gb_tx_batch_msg msgs[CONFIG_GREYBUS_TX_BATCH_MAX_MSGS];
+    struct gb_tx_batch_stats stats;
+};
+#endif
 
 struct gb_cport_driver {
     struct gb_driver *driver;
-    struct list_head tx_fifo;
+    const uint8_t *handler_index;   /* see gb_build_handler_index() */
+#ifdef CONFIG_GREYBUS_TX_BATCH
+    struct gb_tx_batch *tx_batch;   /* NULL when batching is disabled */
+#endif
     struct list_head rx_fifo;
+    struct list_head expired;   /* requests that timed out */
+    unsigned int inflight;      /* requests waiting for a response */
+    unsigned int max_inflight;
+    unsigned long timeouts;
+#ifdef CONFIG_GREYBUS_STATS
+    struct gb_cport_stats stats;
+#endif
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+    struct list_head ready;     /* entry in a worker pool run queue */
+    bool scheduled;             /* queued or being processed by a worker */
+#else
     sem_t rx_fifo_lock;
     pthread_t thread;
-    struct wdog_s timeout_wd;
+#endif
     struct gb_operation timedout_operation;
 };
 
-struct gb_tape_record_header {
-    uint16_t size;
-    uint16_t cport;
+struct gb_timeout_wheel {
+    struct wdog_s wd;
+    uint32_t now;               /* start tick of the next slot to expire */
+    unsigned int count;         /* requests in the wheel */
+    struct list_head slots[GB_WHEEL_SLOTS];
 };
 
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+struct gb_worker_pool {
+    sem_t ready_sem;
+    struct list_head ready[GB_DRIVER_PRIORITY_COUNT];
+    pthread_t threads[CONFIG_GREYBUS_WORKER_POOL_SIZE];
+    unsigned int pending;
+    unsigned int max_pending;
+    struct gb_worker_class_stats classes[GB_DRIVER_PRIORITY_COUNT];
+};
+
+/* Order in which the run queues are served */
+static const enum gb_driver_priority gb_worker_class_order[] = {
+    GB_DRIVER_PRIORITY_HIGH,
+    GB_DRIVER_PRIORITY_NORMAL,
+    GB_DRIVER_PRIORITY_LOW,
+};
+
+static struct gb_worker_pool g_worker_pool;
+#endif
+
 static atomic_t request_id;
 static struct gb_cport_driver g_cport[CPORT_MAX];
+static struct list_head g_inflight[GB_INFLIGHT_BUCKETS];
+static struct gb_timeout_wheel g_timeout_wheel;
 static struct gb_transport_backend *transport_backend;
-static struct gb_tape_mechanism *gb_tape;
-static int gb_tape_fd = -EBADFD;
 static struct gb_operation_hdr timedout_hdr = {
     .size = sizeof(timedout_hdr),
     .result = GB_OP_TIMEOUT,
@@ -84,7 +154,127 @@ static struct gb_operation_hdr oom_hdr = {
     .type = TYPE_RESPONSE_FLAG,
 };
 
-static void gb_operation_timeout(int argc, uint32_t cport, ...);
+static void gb_rx_fifo_post(unsigned int cportid);
+static void gb_timeout_wheel_tick(int argc, uint32_t arg, ...);
+
+#ifdef CONFIG_GREYBUS_STATS
+const unsigned long gb_latency_bucket_usec[GB_LATENCY_BUCKETS - 1] = {
+    250, 1000, 2500, 10000, 25000, 100000, 250000,
+};
+
+static void gb_stats_rx(unsigned int cport, size_t size)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    g_cport[cport].stats.rx_msgs++;
+    g_cport[cport].stats.rx_bytes += size;
+    irqrestore(flags);
+}
+
+/**
+ * @note This function must be called from an atomic context
+ */
+static void gb_stats_rx_fifo_push(unsigned int cport)
+{
+    struct gb_cport_stats *stats = &g_cport[cport].stats;
+
+    if (++stats->rx_fifo_depth > stats->rx_fifo_hwm)
+        stats->rx_fifo_hwm = stats->rx_fifo_depth;
+}
+
+/**
+ * @note This function must be called from an atomic context
+ */
+static void gb_stats_rx_fifo_pop(unsigned int cport, struct list_head *head)
+{
+    struct gb_operation *operation;
+
+    operation = list_entry(head, struct gb_operation, list);
+    if (operation->request_buffer != &timedout_hdr)
+        g_cport[cport].stats.rx_fifo_depth--;
+}
+
+/**
+ * @note This function must be called from an atomic context
+ */
+static void gb_stats_tx(unsigned int cport, size_t len, int retval)
+{
+    if (retval) {
+        g_cport[cport].stats.send_errors++;
+    } else {
+        g_cport[cport].stats.tx_msgs++;
+        g_cport[cport].stats.tx_bytes += len;
+    }
+}
+
+static void gb_stats_latency(struct gb_operation *operation)
+{
+    struct timespec now;
+    unsigned long usec;
+    irqstate_t flags;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    usec = (now.tv_sec - operation->time.tv_sec) * 1000000 +
+           (now.tv_nsec - operation->time.tv_nsec) / 1000;
+
+    for (i = 0; i < GB_LATENCY_BUCKETS - 1; i++) {
+        if (usec < gb_latency_bucket_usec[i])
+            break;
+    }
+
+    flags = irqsave();
+    g_cport[operation->cport].stats.latency[i]++;
+    irqrestore(flags);
+}
+
+int gb_cport_get_stats(unsigned int cport, struct gb_cport_stats *stats)
+{
+    irqstate_t flags;
+
+    if (cport >= CPORT_MAX || !stats)
+        return -EINVAL;
+
+    if (!g_cport[cport].driver)
+        return -ENODEV;
+
+    flags = irqsave();
+    *stats = g_cport[cport].stats;
+    stats->timeouts = g_cport[cport].timeouts;
+    irqrestore(flags);
+
+    stats->driver = gb_driver_name(g_cport[cport].driver);
+
+    return 0;
+}
+
+void gb_stats_reset(void)
+{
+    struct gb_cport_stats *stats;
+    unsigned int depth;
+    irqstate_t flags;
+    int i;
+
+    for (i = 0; i < CPORT_MAX; i++) {
+        stats = &g_cport[i].stats;
+
+        flags = irqsave();
+        depth = stats->rx_fifo_depth;
+        memset(stats, 0, sizeof(*stats));
+        stats->rx_fifo_depth = depth;
+        stats->rx_fifo_hwm = depth;
+        g_cport[i].timeouts = 0;
+        irqrestore(flags);
+    }
+}
+#else
+#define gb_stats_rx(cport, size)
+#define gb_stats_rx_fifo_push(cport)
+#define gb_stats_rx_fifo_pop(cport, head)
+#define gb_stats_tx(cport, len, retval)
+#define gb_stats_latency(operation)
+#endif
 
 uint8_t gb_errno_to_op_result(int err)
 {
@@ -133,46 +323,95 @@ uint8_t gb_errno_to_op_result(int err)
     }
 }
 
-static int gb_compare_handlers(const void *data1, const void *data2)
+/**
+ * Build the table giving the position of the handler of each request type
+ * in the driver op_handlers, plus one, or 0 when there is no handler. The
+ * table is shared by all the CPorts using the same driver.
+ */
+static int gb_build_handler_index(unsigned int cport, struct gb_driver *driver)
+{
+    uint8_t *index;
+    uint8_t type;
+    int i;
+
+    if (!driver->op_handlers)
+        return 0;
+
+    for (i = 0; i < CPORT_MAX; i++) {
+        if (g_cport[i].driver == driver) {
+            g_cport[cport].handler_index = g_cport[i].handler_index;
+            return 0;
+        }
+    }
+
+    if (driver->op_handlers_count > UINT8_MAX) {
+        gb_error("%s has too many handlers\n", gb_driver_name(driver));
+        return -EINVAL;
+    }
+
+    index = zalloc(GB_HANDLER_INDEX_SIZE);
+    if (!index)
+        return -ENOMEM;
+
+    for (i = 0; i < driver->op_handlers_count; i++) {
+        type = driver->op_handlers[i].type;
+
+        if (type == GB_INVALID_TYPE || type >= GB_HANDLER_INDEX_SIZE) {
+            gb_error("%s: invalid operation type %u\n",
+                     gb_driver_name(driver), type);
+            goto error;
+        }
+
+        if (index[type]) {
+            gb_error("%s: several handlers for operation type %u\n",
+                     gb_driver_name(driver), type);
+            goto error;
+        }
+
+        index[type] = i + 1;
+    }
+
+    g_cport[cport].handler_index = index;
+    return 0;
+
+error:
+    free(index);
+    return -EINVAL;
+}
+
+static void gb_release_handler_index(unsigned int cport)
 {
-    const struct gb_operation_handler *handler1 = data1;
-    const struct gb_operation_handler *handler2 = data2;
-    return (int)handler1->type - (int)handler2->type;
+    const uint8_t *index = g_cport[cport].handler_index;
+    int i;
+
+    g_cport[cport].handler_index = NULL;
+
+    for (i = 0; i < CPORT_MAX; i++) {
+        if (g_cport[i].handler_index == index)
+            return;
+    }
+
+    free((void *) index);
 }
 
 static struct gb_operation_handler *find_operation_handler(uint8_t type,
                                                            unsigned int cport)
 {
-    struct gb_driver *driver = g_cport[cport].driver;
-    int l,r;
+    const uint8_t *index = g_cport[cport].handler_index;
 
-    if (type == GB_INVALID_TYPE || !driver->op_handlers) {
+    if (!index || type >= GB_HANDLER_INDEX_SIZE || !index[type]) {
         return NULL;
     }
 
-    /* binary search -- bsearch from libc is not implemented by nuttx */
-    l = 0;
-    r = driver->op_handlers_count - 1;
-    while (l <= r) {
-        int m = (l + r) / 2;
-        if (driver->op_handlers[m].type < type)
-            l = m + 1;
-        else if (driver->op_handlers[m].type > type)
-            r = m - 1;
-        else
-            return &driver->op_handlers[m];
-    }
-
-    return NULL;
+    return &g_cport[cport].driver->op_handlers[index[type] - 1];
 }
 
 static void gb_process_request(struct gb_operation_hdr *hdr,
                                struct gb_operation *operation)
 {
-    struct gb_operation_handler *op_handler;
+    struct gb_operation_handler *op_handler = operation->handler;
     uint8_t result;
 
-    op_handler = find_operation_handler(hdr->type, operation->cport);
     if (!op_handler) {
         gb_error("Cport %u: Invalid operation type %u\n",
                  operation->cport, hdr->type);
@@ -187,67 +426,177 @@ static void gb_process_request(struct gb_operation_hdr *hdr,
         gb_operation_send_response(operation, result);
 }
 
-static bool gb_operation_has_timedout(struct gb_operation *operation)
+static unsigned int gb_inflight_hash(unsigned int cport, uint16_t id)
+{
+    return (id ^ (cport << 3)) & (GB_INFLIGHT_BUCKETS - 1);
+}
+
+/**
+ * Start the timeout wheel if it is not already running
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_timeout_wheel_start(void)
 {
-    struct timespec current_time;
-    struct timespec timeout_time;
+    uint32_t now;
 
-    timeout_time.tv_sec = operation->time.tv_sec +
-                          TIMEOUT_IN_MS / ONE_SEC_IN_MSEC;
-    timeout_time.tv_nsec = operation->time.tv_nsec +
-                          (TIMEOUT_IN_MS % ONE_SEC_IN_MSEC) * ONE_MSEC_IN_NSEC;
-    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    if (WDOG_ISACTIVE(&g_timeout_wheel.wd))
+        return;
 
-    if (current_time.tv_sec > timeout_time.tv_sec)
-        return true;
+    now = clock_systimer();
+    g_timeout_wheel.now = now & ~(GB_WHEEL_TICKS - 1);
+    wd_start(&g_timeout_wheel.wd, g_timeout_wheel.now + GB_WHEEL_TICKS - now,
+             gb_timeout_wheel_tick, 0);
+}
 
-    if (current_time.tv_sec < timeout_time.tv_sec)
-        return false;
+/**
+ * Track an outgoing request until it gets its response or times out
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_inflight_add(struct gb_operation *operation, uint16_t id)
+{
+    struct gb_cport_driver *cport = &g_cport[operation->cport];
+    unsigned int slot;
+
+    list_add(&g_inflight[gb_inflight_hash(operation->cport, id)],
+             &operation->list);
+
+    gb_timeout_wheel_start();
+
+    /* Expire on a slot boundary so that the slot is visited after it */
+    operation->timeout = (clock_systimer() + GB_TIMEOUT_TICKS +
+                          GB_WHEEL_TICKS - 1) & ~(GB_WHEEL_TICKS - 1);
+    slot = (operation->timeout / GB_WHEEL_TICKS) & (GB_WHEEL_SLOTS - 1);
+    list_add(&g_timeout_wheel.slots[slot], &operation->timeout_list);
+    g_timeout_wheel.count++;
 
-    return current_time.tv_nsec > timeout_time.tv_nsec;
+    if (++cport->inflight > cport->max_inflight)
+        cport->max_inflight = cport->inflight;
 }
 
 /**
- * Update watchdog state
+ * Stop tracking an outgoing request
  *
- * Cancel cport watchdog if there is no outgoing message waiting for a response,
- * or update the watchdog if there is still outgoing messages.
+ * @note This function must be called from an atomic context
+ */
+static void gb_inflight_del(struct gb_operation *operation)
+{
+    list_del(&operation->list);
+    list_del(&operation->timeout_list);
+    g_cport[operation->cport].inflight--;
+
+    if (--g_timeout_wheel.count == 0)
+        wd_cancel(&g_timeout_wheel.wd);
+}
+
+/**
+ * Find and stop tracking the request a response is for
  *
- * TODO use fine-grain timeout delay when doing the update
+ * @note This function must be called from an atomic context
+ */
+static struct gb_operation *gb_inflight_take(unsigned int cport, __le16 id)
+{
+    struct list_head *bucket;
+    struct list_head *iter;
+    struct gb_operation *op;
+    struct gb_operation_hdr *op_hdr;
+
+    bucket = &g_inflight[gb_inflight_hash(cport, le16_to_cpu(id))];
+    list_foreach(bucket, iter) {
+        op = list_entry(iter, struct gb_operation, list);
+        op_hdr = op->request_buffer;
+
+        if (op->cport == cport && op_hdr->id == id) {
+            gb_inflight_del(op);
+            return op;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Expire the requests of the timeout wheel slots that have elapsed
  *
- * @note This function should be called from an atomic context
+ * Expired requests are moved to the list of their CPort, and the CPort
+ * worker is woken up to run their callbacks.
  */
-static void gb_watchdog_update(unsigned int cport)
+static void gb_timeout_wheel_tick(int argc, uint32_t arg, ...)
 {
+    struct list_head *iter, *iter_next;
+    struct gb_operation *op;
+    struct gb_cport_driver *cport;
+    struct list_head *slot;
+    uint32_t now = clock_systimer();
     irqstate_t flags;
 
     flags = irqsave();
 
-    if (list_is_empty(&g_cport[cport].tx_fifo)) {
-        wd_cancel(&g_cport[cport].timeout_wd);
-    } else {
-        wd_start(&g_cport[cport].timeout_wd, TIMEOUT_WD_DELAY,
-                 gb_operation_timeout, 1, cport);
+    while ((int32_t) (now - g_timeout_wheel.now) >= 0) {
+        slot = &g_timeout_wheel.slots[(g_timeout_wheel.now / GB_WHEEL_TICKS) &
+                                      (GB_WHEEL_SLOTS - 1)];
+
+        list_foreach_safe(slot, iter, iter_next) {
+            op = list_entry(iter, struct gb_operation, timeout_list);
+            /* not for this round of the wheel */
+            if ((int32_t) (now - op->timeout) < 0)
+                continue;
+
+            gb_inflight_del(op);
+            cport = &g_cport[op->cport];
+            cport->timeouts++;
+            list_add(&cport->expired, &op->list);
+
+            /* the timeout marker could already be queued */
+            if (list_is_empty(&cport->timedout_operation.list)) {
+                list_add(&cport->rx_fifo, &cport->timedout_operation.list);
+                gb_rx_fifo_post(op->cport);
+            }
+        }
+
+        g_timeout_wheel.now += GB_WHEEL_TICKS;
+    }
+
+    if (g_timeout_wheel.count) {
+        wd_start(&g_timeout_wheel.wd, g_timeout_wheel.now - now,
+                 gb_timeout_wheel_tick, 0);
     }
 
     irqrestore(flags);
 }
 
+int gb_cport_get_inflight_stats(unsigned int cport,
+                                struct gb_cport_inflight_stats *stats)
+{
+    irqstate_t flags;
+
+    if (cport >= CPORT_MAX || !stats)
+        return -EINVAL;
+
+    flags = irqsave();
+    stats->inflight = g_cport[cport].inflight;
+    stats->max_inflight = g_cport[cport].max_inflight;
+    stats->timeouts = g_cport[cport].timeouts;
+    irqrestore(flags);
+
+    return 0;
+}
+
 static void gb_clean_timedout_operation(unsigned int cport)
 {
     irqstate_t flags;
-    struct list_head *iter, *iter_next;
     struct gb_operation *op;
 
-    list_foreach_safe(&g_cport[cport].tx_fifo, iter, iter_next) {
-        op = list_entry(iter, struct gb_operation, list);
-
-        if (!gb_operation_has_timedout(op)) {
-            continue;
+    while (1) {
+        flags = irqsave();
+        if (list_is_empty(&g_cport[cport].expired)) {
+            irqrestore(flags);
+            break;
         }
 
-        flags = irqsave();
-        list_del(iter);
+        op = list_entry(g_cport[cport].expired.next, struct gb_operation, list);
+        list_del(&op->list);
         irqrestore(flags);
 
         if (op->callback) {
@@ -255,47 +604,239 @@ static void gb_clean_timedout_operation(unsigned int cport)
         }
         gb_operation_unref(op);
     }
-
-    gb_watchdog_update(cport);
 }
 
 static void gb_process_response(struct gb_operation_hdr *hdr,
                                 struct gb_operation *operation)
 {
     irqstate_t flags;
-    struct list_head *iter, *iter_next;
     struct gb_operation *op;
-    struct gb_operation_hdr *op_hdr;
 
-    list_foreach_safe(&g_cport[operation->cport].tx_fifo, iter, iter_next) {
-        op = list_entry(iter, struct gb_operation, list);
-        op_hdr = op->request_buffer;
+    /*
+     * The response can outlive this worker iteration, don't let it hold
+     * the transport RX buffer. If it can't be copied, the request will
+     * time out.
+     */
+    if (gb_operation_detach_request(operation)) {
+        gb_error("Dropping response: out of memory\n");
+        return;
+    }
+    hdr = operation->request_buffer;
+
+    flags = irqsave();
+    op = gb_inflight_take(operation->cport, hdr->id);
+    irqrestore(flags);
+
+    if (!op)
+        return;
 
-        if (hdr->id != op_hdr->id)
+    /* attach this response with the original request */
+    gb_operation_ref(operation);
+    op->response = operation;
+    if (op->callback)
+        op->callback(op);
+    gb_operation_unref(op);
+}
+
+static void gb_process_operation(unsigned int cportid,
+                                 struct gb_operation *operation)
+{
+    struct gb_operation_hdr *hdr = operation->request_buffer;
+
+    if (hdr == &timedout_hdr) {
+        gb_clean_timedout_operation(cportid);
+        return;
+    }
+
+    if (hdr->type & TYPE_RESPONSE_FLAG)
+        gb_process_response(hdr, operation);
+    else
+        gb_process_request(hdr, operation);
+    gb_operation_destroy(operation);
+}
+
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+/**
+ * Put a CPort at the tail of the run queue of its driver class
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_worker_pool_schedule(unsigned int cportid)
+{
+    struct gb_cport_driver *cport = &g_cport[cportid];
+    enum gb_driver_priority priority = GB_DRIVER_PRIORITY_NORMAL;
+    struct gb_worker_class_stats *stats;
+
+    if (cport->driver)
+        priority = cport->driver->priority;
+
+    stats = &g_worker_pool.classes[priority];
+    if (++stats->queued > stats->max_queued)
+        stats->max_queued = stats->queued;
+
+    cport->scheduled = true;
+    list_add(&g_worker_pool.ready[priority], &cport->ready);
+    sem_post(&g_worker_pool.ready_sem);
+}
+
+/**
+ * Signal that a message has been queued in a CPort rx fifo
+ *
+ * A CPort sits at most once in the run queues and is not put back in them
+ * before the worker processing its current message is done with it, so
+ * messages of a CPort are never processed concurrently or out of order.
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_rx_fifo_post(unsigned int cportid)
+{
+    if (++g_worker_pool.pending > g_worker_pool.max_pending)
+        g_worker_pool.max_pending = g_worker_pool.pending;
+
+    if (!g_cport[cportid].scheduled)
+        gb_worker_pool_schedule(cportid);
+}
+
+static void *gb_pool_worker(void *data)
+{
+    irqstate_t flags;
+    struct gb_cport_driver *cport = NULL;
+    struct list_head *head;
+    unsigned int cportid;
+    int priority;
+    int retval;
+    int i;
+
+    while (1) {
+        retval = sem_wait(&g_worker_pool.ready_sem);
+        if (retval < 0)
             continue;
 
         flags = irqsave();
-        list_del(iter);
-        gb_watchdog_update(operation->cport);
+        for (i = 0; i < ARRAY_SIZE(gb_worker_class_order); i++) {
+            priority = gb_worker_class_order[i];
+            if (list_is_empty(&g_worker_pool.ready[priority]))
+                continue;
+
+            cport = list_entry(g_worker_pool.ready[priority].next,
+                               struct gb_cport_driver, ready);
+            list_del(&cport->ready);
+            g_worker_pool.classes[priority].queued--;
+            break;
+        }
+
+        DEBUGASSERT(i < ARRAY_SIZE(gb_worker_class_order));
+
+        cportid = cport - g_cport;
+        head = cport->rx_fifo.next;
+        list_del(head);
+        gb_stats_rx_fifo_pop(cportid, head);
+        g_worker_pool.pending--;
         irqrestore(flags);
 
-        /* attach this response with the original request */
-        gb_operation_ref(operation);
-        op->response = operation;
-        if (op->callback)
-            op->callback(op);
-        gb_operation_unref(op);
-        break;
+        gb_process_operation(cportid,
+                             list_entry(head, struct gb_operation, list));
+
+        flags = irqsave();
+        g_worker_pool.classes[priority].dispatched++;
+        if (list_is_empty(&cport->rx_fifo))
+            cport->scheduled = false;
+        else
+            gb_worker_pool_schedule(cportid);
+        irqrestore(flags);
+    }
+
+    return NULL;
+}
+
+static int gb_worker_pool_init(void)
+{
+    pthread_attr_t thread_attr;
+    int retval;
+    int i;
+
+    sem_init(&g_worker_pool.ready_sem, 0, 0);
+    for (i = 0; i < GB_DRIVER_PRIORITY_COUNT; i++)
+        list_init(&g_worker_pool.ready[i]);
+
+    retval = pthread_attr_init(&thread_attr);
+    if (retval)
+        return -retval;
+
+    retval = pthread_attr_setstacksize(&thread_attr,
+                                       CONFIG_GREYBUS_WORKER_POOL_STACKSIZE);
+    if (retval)
+        goto out;
+
+    for (i = 0; i < CONFIG_GREYBUS_WORKER_POOL_SIZE; i++) {
+        retval = pthread_create(&g_worker_pool.threads[i], &thread_attr,
+                                gb_pool_worker, NULL);
+        if (retval) {
+            gb_error("Can not create greybus worker %d\n", i);
+            break;
+        }
+    }
+
+out:
+    pthread_attr_destroy(&thread_attr);
+    return -retval;
+}
+
+int gb_worker_pool_get_stats(struct gb_worker_pool_stats *stats)
+{
+#if defined(CONFIG_DEBUG) && defined(CONFIG_DEBUG_STACK)
+    struct tcb_s *tcb;
+    size_t used;
+#endif
+    irqstate_t flags;
+    int i;
+
+    if (!stats)
+        return -EINVAL;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->threads = CONFIG_GREYBUS_WORKER_POOL_SIZE;
+    stats->stack_size = CONFIG_GREYBUS_WORKER_POOL_STACKSIZE;
+
+    flags = irqsave();
+
+#if defined(CONFIG_DEBUG) && defined(CONFIG_DEBUG_STACK)
+    for (i = 0; i < CONFIG_GREYBUS_WORKER_POOL_SIZE; i++) {
+        tcb = sched_gettcb((pid_t) g_worker_pool.threads[i]);
+        if (!tcb)
+            continue;
+
+        used = up_check_tcbstack(tcb);
+        if (used > stats->stack_used)
+            stats->stack_used = used;
     }
+#endif
+
+    stats->pending = g_worker_pool.pending;
+    stats->max_pending = g_worker_pool.max_pending;
+    for (i = 0; i < GB_DRIVER_PRIORITY_COUNT; i++)
+        stats->classes[i] = g_worker_pool.classes[i];
+
+    irqrestore(flags);
+
+    return 0;
+}
+#else
+/**
+ * Signal that a message has been queued in a CPort rx fifo
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_rx_fifo_post(unsigned int cportid)
+{
+    sem_post(&g_cport[cportid].rx_fifo_lock);
 }
 
 static void *gb_pending_message_worker(void *data)
 {
     const int cportid = (int) data;
     irqstate_t flags;
-    struct gb_operation *operation;
     struct list_head *head;
-    struct gb_operation_hdr *hdr;
     int retval;
 
     while (1) {
@@ -306,27 +847,63 @@ static void *gb_pending_message_worker(void *data)
         flags = irqsave();
         head = g_cport[cportid].rx_fifo.next;
         list_del(g_cport[cportid].rx_fifo.next);
+        gb_stats_rx_fifo_pop(cportid, head);
         irqrestore(flags);
 
-        operation = list_entry(head, struct gb_operation, list);
-        hdr = operation->request_buffer;
+        gb_process_operation(cportid,
+                             list_entry(head, struct gb_operation, list));
+    }
 
-        if (hdr == &timedout_hdr) {
-            gb_clean_timedout_operation(cportid);
-            continue;
-        }
+    return NULL;
+}
 
-        if (hdr->type & TYPE_RESPONSE_FLAG)
-            gb_process_response(hdr, operation);
-        else
-            gb_process_request(hdr, operation);
-        gb_operation_destroy(operation);
+static int gb_cport_thread_create(unsigned int cport, struct gb_driver *driver)
+{
+    pthread_attr_t thread_attr;
+    int retval;
+
+    retval = pthread_attr_init(&thread_attr);
+    if (retval)
+        return retval;
+
+    retval = pthread_attr_setstacksize(&thread_attr, driver->stack_size);
+    if (!retval) {
+        retval = pthread_create(&g_cport[cport].thread, &thread_attr,
+                                gb_pending_message_worker, (unsigned*) cport);
     }
 
-    return NULL;
+    pthread_attr_destroy(&thread_attr);
+    return retval;
 }
+#endif
 
-int greybus_rx_handler(unsigned int cport, void *data, size_t size)
+static void gb_release_rx_buffer(unsigned int cport, void *data)
+{
+    if (transport_backend && transport_backend->release_rx_buffer)
+        transport_backend->release_rx_buffer(cport, data);
+}
+
+static struct gb_operation *gb_operation_borrow(unsigned int cport,
+                                                void *data)
+{
+    struct gb_operation *operation;
+
+    operation = gb_pool_alloc_operation(0);
+    if (!operation)
+        return NULL;
+
+    operation->cport = cport;
+    operation->request_buffer = data;
+    operation->borrows_rx_buffer = true;
+
+    list_init(&operation->list);
+    atomic_init(&operation->ref_count, 1);
+
+    return operation;
+}
+
+static int gb_rx_handler(unsigned int cport, void *data, size_t size,
+                         bool *borrowed)
 {
     irqstate_t flags;
     struct gb_operation *op;
@@ -357,16 +934,9 @@ int greybus_rx_handler(unsigned int cport, void *data, size_t size)
     }
 
     gb_dump(data, size);
+    gb_stats_rx(cport, hdr_size);
 
-    if (gb_tape && gb_tape_fd >= 0) {
-        struct gb_tape_record_header record_hdr = {
-            .size = size,
-            .cport = cport,
-        };
-
-        gb_tape->write(gb_tape_fd, &record_hdr, sizeof(record_hdr));
-        gb_tape->write(gb_tape_fd, data, size);
-    }
+    gb_tape_record(cport, GB_TAPE_DIR_RX, data, size);
 
     op_handler = find_operation_handler(hdr->type, cport);
     if (op_handler && op_handler->fast_handler) {
@@ -375,24 +945,60 @@ int greybus_rx_handler(unsigned int cport, void *data, size_t size)
         return 0;
     }
 
-    op = gb_operation_create(cport, 0, hdr_size - sizeof(*hdr));
-    if (!op)
-        return -ENOMEM;
+    if (borrowed && g_cport[cport].driver->zero_copy_rx) {
+        op = gb_operation_borrow(cport, data);
+        if (!op)
+            return -ENOMEM;
+        *borrowed = true;
+    } else {
+        op = gb_operation_create(cport, 0, hdr_size - sizeof(*hdr));
+        if (!op)
+            return -ENOMEM;
+
+        memcpy(op->request_buffer, data, hdr_size);
+    }
 
-    memcpy(op->request_buffer, data, hdr_size);
+    op->handler = op_handler;
+
+#ifdef CONFIG_GREYBUS_STATS
+    clock_gettime(CLOCK_MONOTONIC, &op->time);
+#endif
 
     flags = irqsave();
     list_add(&g_cport[cport].rx_fifo, &op->list);
-    sem_post(&g_cport[cport].rx_fifo_lock);
+    gb_stats_rx_fifo_push(cport);
+    gb_rx_fifo_post(cport);
     irqrestore(flags);
 
     return 0;
 }
 
+int greybus_rx_handler(unsigned int cport, void *data, size_t size)
+{
+    return gb_rx_handler(cport, data, size, NULL);
+}
+
+/**
+ * Same as greybus_rx_handler() but the transport lends its buffer to the
+ * greybus core. The buffer is given back through the transport's
+ * release_rx_buffer() callback, either before this function returns or, if
+ * the CPort driver supports zero-copy receive, when the operation using it
+ * as request buffer is destroyed.
+ */
+int greybus_rx_handler_zero_copy(unsigned int cport, void *data, size_t size)
+{
+    bool borrowed = false;
+    int retval;
+
+    retval = gb_rx_handler(cport, data, size, &borrowed);
+    if (!borrowed)
+        gb_release_rx_buffer(cport, data);
+
+    return retval;
+}
+
 int _gb_register_driver(unsigned int cport, struct gb_driver *driver)
 {
-    pthread_attr_t thread_attr;
-    pthread_attr_t *thread_attr_ptr = &thread_attr;
     int retval;
 
     gb_debug("Registering Greybus driver on CP%u\n", cport);
@@ -418,51 +1024,55 @@ int _gb_register_driver(unsigned int cport, struct gb_driver *driver)
         return -EINVAL;
     }
 
+    if (driver->priority >= GB_DRIVER_PRIORITY_COUNT) {
+        gb_error("Invalid priority for %s\n", gb_driver_name(driver));
+        return -EINVAL;
+    }
+
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+    if (driver->stack_size > CONFIG_GREYBUS_WORKER_POOL_STACKSIZE) {
+        gb_error("%s needs a %zu bytes stack, workers only have %d\n",
+                 gb_driver_name(driver), driver->stack_size,
+                 CONFIG_GREYBUS_WORKER_POOL_STACKSIZE);
+        return -EINVAL;
+    }
+#endif
+
+    retval = gb_build_handler_index(cport, driver);
+    if (retval)
+        return retval;
+
     if (driver->init) {
         retval = driver->init(cport);
         if (retval) {
             gb_error("Can not init %s\n", gb_driver_name(driver));
+            gb_release_handler_index(cport);
             return retval;
         }
     }
 
-    if (driver->op_handlers) {
-        qsort(driver->op_handlers, driver->op_handlers_count,
-              sizeof(*driver->op_handlers), gb_compare_handlers);
-    }
-
+#ifndef CONFIG_GREYBUS_WORKER_POOL
     if (!driver->stack_size)
         driver->stack_size = DEFAULT_STACK_SIZE;
 
-    retval = pthread_attr_init(&thread_attr);
-    if (retval)
-        goto pthread_attr_init_error;
-
-    retval = pthread_attr_setstacksize(&thread_attr, driver->stack_size);
-    if (retval)
-        goto pthread_attr_setstacksize_error;
-
-    retval = pthread_create(&g_cport[cport].thread, &thread_attr,
-                            gb_pending_message_worker, (unsigned*) cport);
-    if (retval)
-        goto pthread_create_error;
-
-    pthread_attr_destroy(&thread_attr);
-    thread_attr_ptr = NULL;
+    retval = gb_cport_thread_create(cport, driver);
+    if (retval) {
+        gb_error("Can not create thread for %s\n: ", gb_driver_name(driver));
+        if (driver->exit)
+            driver->exit(cport);
+        gb_release_handler_index(cport);
+        return retval;
+    }
+#endif
 
     g_cport[cport].driver = driver;
 
-    return 0;
+#ifdef CONFIG_GREYBUS_TX_BATCH
+    if (driver->tx_batching && gb_cport_set_tx_batching(cport, true))
+        gb_warning("Can not enable TX batching on CP%u\n", cport);
+#endif
 
-pthread_create_error:
-pthread_attr_setstacksize_error:
-    if (thread_attr_ptr != NULL)
-        pthread_attr_destroy(&thread_attr);
-pthread_attr_init_error:
-    gb_error("Can not create thread for %s\n: ", gb_driver_name(driver));
-    if (driver->exit)
-        driver->exit(cport);
-    return retval;
+    return 0;
 }
 
 int gb_listen(unsigned int cport)
@@ -502,20 +1112,194 @@ int gb_stop_listening(unsigned int cport)
     return transport_backend->stop_listening(cport);
 }
 
-static void gb_operation_timeout(int argc, uint32_t cport, ...)
+#ifdef CONFIG_GREYBUS_TX_BATCH
+/**
+ * Hand all the messages queued on a CPort to the transport
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_tx_batch_flush(unsigned int cport, bool idle)
+{
+    struct gb_tx_batch *batch = g_cport[cport].tx_batch;
+    struct gb_tx_batch_msg *msg;
+    unsigned int i;
+    int retval;
+
+    if (!batch || !batch->count)
+        return;
+
+    work_cancel(HPWORK, &batch->work);
+
+    for (i = 0; i < batch->count; i++) {
+        msg = &batch->msgs[i];
+
+        retval = transport_backend->send(cport, msg->buf, msg->len);
+        if (retval) {
+            /* requests expecting a response will time out */
+            batch->stats.errors++;
+#ifdef CONFIG_GREYBUS_STATS
+            g_cport[cport].stats.send_errors++;
+#endif
+        }
+        gb_operation_unref(msg->operation);
+    }
+
+    batch->stats.messages += batch->count;
+    batch->stats.batches++;
+    if (idle)
+        batch->stats.idle_flushes++;
+    if (batch->count > batch->stats.max_batch)
+        batch->stats.max_batch = batch->count;
+
+    if (batch->count == 1)
+        batch->stats.sizes[0]++;
+    else if (batch->count == 2)
+        batch->stats.sizes[1]++;
+    else if (batch->count <= 4)
+        batch->stats.sizes[2]++;
+    else if (batch->count <= 8)
+        batch->stats.sizes[3]++;
+    else
+        batch->stats.sizes[4]++;
+
+    batch->count = 0;
+    batch->bytes = 0;
+}
+
+static void gb_tx_batch_idle(FAR void *arg)
 {
     irqstate_t flags;
 
     flags = irqsave();
+    gb_tx_batch_flush((unsigned int) arg, true);
+    irqrestore(flags);
+}
 
-    /* timedout operation could potentially already been queued */
-    if (list_is_empty(&g_cport[cport].timedout_operation.list)) {
-        return;
+/**
+ * Queue a message in the CPort batch, flushing the batch first if the
+ * message does not fit. The operation is kept alive until it is sent.
+ *
+ * @note This function must be called from an atomic context
+ */
+static void gb_tx_batch_queue(struct gb_operation *operation,
+                              const void *buf, size_t len)
+{
+    struct gb_tx_batch *batch = g_cport[operation->cport].tx_batch;
+    struct gb_tx_batch_msg *msg;
+
+    if (batch->count == CONFIG_GREYBUS_TX_BATCH_MAX_MSGS ||
+        batch->bytes + len > CONFIG_GREYBUS_TX_BATCH_MAX_BYTES)
+        gb_tx_batch_flush(operation->cport, false);
+
+    gb_operation_ref(operation);
+    msg = &batch->msgs[batch->count++];
+    msg->operation = operation;
+    msg->buf = buf;
+    msg->len = len;
+    batch->bytes += len;
+
+    /* (re)start the idle timer */
+    work_cancel(HPWORK, &batch->work);
+    work_queue(HPWORK, &batch->work, gb_tx_batch_idle,
+               (FAR void *) operation->cport, GB_TX_BATCH_IDLE_TICKS);
+}
+
+int gb_cport_set_tx_batching(unsigned int cport, bool enable)
+{
+    struct gb_tx_batch *batch;
+    irqstate_t flags;
+
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    if (enable) {
+        if (g_cport[cport].tx_batch)
+            return 0;
+
+        batch = zalloc(sizeof(*batch));
+        if (!batch)
+            return -ENOMEM;
+
+        flags = irqsave();
+        if (g_cport[cport].tx_batch) {
+            irqrestore(flags);
+            free(batch);
+            return 0;
+        }
+        g_cport[cport].tx_batch = batch;
+        irqrestore(flags);
+
+        return 0;
     }
 
-    list_add(&g_cport[cport].rx_fifo, &g_cport[cport].timedout_operation.list);
-    sem_post(&g_cport[cport].rx_fifo_lock);
+    flags = irqsave();
+    gb_tx_batch_flush(cport, false);
+    batch = g_cport[cport].tx_batch;
+    g_cport[cport].tx_batch = NULL;
+    irqrestore(flags);
+
+    free(batch);
+    return 0;
+}
+
+int gb_cport_flush_tx(unsigned int cport)
+{
+    irqstate_t flags;
+
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    flags = irqsave();
+    gb_tx_batch_flush(cport, false);
+    irqrestore(flags);
+
+    return 0;
+}
+
+int gb_cport_get_tx_batch_stats(unsigned int cport,
+                                struct gb_tx_batch_stats *stats)
+{
+    irqstate_t flags;
+    int retval = 0;
+
+    if (cport >= CPORT_MAX || !stats)
+        return -EINVAL;
+
+    flags = irqsave();
+    if (g_cport[cport].tx_batch)
+        *stats = g_cport[cport].tx_batch->stats;
+    else
+        retval = -ENODEV;
     irqrestore(flags);
+
+    return retval;
+}
+#endif
+
+/**
+ * Send a message, or queue it if batching is enabled on the CPort
+ *
+ * @note This function must be called from an atomic context
+ */
+static int gb_transport_send(struct gb_operation *operation,
+                             const void *buf, size_t len)
+{
+    int retval;
+
+    gb_tape_record(operation->cport, GB_TAPE_DIR_TX, buf, len);
+
+#ifdef CONFIG_GREYBUS_TX_BATCH
+    if (g_cport[operation->cport].tx_batch) {
+        gb_tx_batch_queue(operation, buf, len);
+        gb_stats_tx(operation->cport, len, 0);
+        return 0;
+    }
+#endif
+
+    retval = transport_backend->send(operation->cport, buf, len);
+    gb_stats_tx(operation->cport, len, retval);
+
+    return retval;
 }
 
 int gb_operation_send_request(struct gb_operation *operation,
@@ -541,20 +1325,14 @@ int gb_operation_send_request(struct gb_operation *operation,
         clock_gettime(CLOCK_MONOTONIC, &operation->time);
         operation->callback = callback;
         gb_operation_ref(operation);
-        list_add(&g_cport[operation->cport].tx_fifo, &operation->list);
-        if (!WDOG_ISACTIVE(&g_cport[operation->cport].timeout_wd)) {
-            wd_start(&g_cport[operation->cport].timeout_wd, TIMEOUT_WD_DELAY,
-                     gb_operation_timeout, 1, operation->cport);
-        }
+        gb_inflight_add(operation, le16_to_cpu(hdr->id));
     }
 
     gb_dump(operation->request_buffer, hdr->size);
-    retval = transport_backend->send(operation->cport,
-                                     operation->request_buffer,
-                                     le16_to_cpu(hdr->size));
+    retval = gb_transport_send(operation, operation->request_buffer,
+                               le16_to_cpu(hdr->size));
     if (need_response && retval) {
-        list_del(&operation->list);
-        gb_watchdog_update(operation->cport);
+        gb_inflight_del(operation);
         gb_operation_unref(operation);
     }
 
@@ -597,8 +1375,19 @@ static int gb_operation_send_oom_response(struct gb_operation *operation)
     oom_hdr.id = req_hdr->id;
     oom_hdr.type = TYPE_RESPONSE_FLAG | req_hdr->type;
 
+#ifdef CONFIG_GREYBUS_TX_BATCH
+    /* oom_hdr is shared, send it right away but after what is queued */
+    gb_tx_batch_flush(operation->cport, false);
+#endif
+
+    gb_tape_record(operation->cport, GB_TAPE_DIR_TX, &oom_hdr,
+                   sizeof(oom_hdr));
     retval = transport_backend->send(operation->cport, &oom_hdr,
                                      sizeof(oom_hdr));
+    gb_stats_tx(operation->cport, sizeof(oom_hdr), retval);
+#ifdef CONFIG_GREYBUS_STATS
+    g_cport[operation->cport].stats.oom_responses++;
+#endif
 
     irqrestore(flags);
 
@@ -608,6 +1397,7 @@ static int gb_operation_send_oom_response(struct gb_operation *operation)
 int gb_operation_send_response(struct gb_operation *operation, uint8_t result)
 {
     struct gb_operation_hdr *resp_hdr;
+    irqstate_t flags;
     int retval;
     bool has_allocated_response = false;
 
@@ -630,20 +1420,22 @@ int gb_operation_send_response(struct gb_operation *operation, uint8_t result)
     resp_hdr->result = result;
 
     gb_dump(operation->response_buffer, resp_hdr->size);
-    retval = transport_backend->send(operation->cport,
-                                     operation->response_buffer,
-                                     le16_to_cpu(resp_hdr->size));
+    flags = irqsave();
+    retval = gb_transport_send(operation, operation->response_buffer,
+                               le16_to_cpu(resp_hdr->size));
+    irqrestore(flags);
     if (retval) {
         gb_error("Greybus backend failed to send: error %d\n", retval);
         if (has_allocated_response) {
             gb_debug("Free the response buffer\n");
-            free(operation->response_buffer);
+            gb_pool_free_buffer(operation->response_buffer);
             operation->response_buffer = NULL;
         }
         return retval;
     }
 
     operation->has_responded = true;
+    gb_stats_latency(operation);
     return retval;
 }
 
@@ -654,14 +1446,12 @@ void *gb_operation_alloc_response(struct gb_operation *operation, size_t size)
 
     DEBUGASSERT(operation);
 
-    operation->response_buffer = malloc(size + sizeof(*resp_hdr));
+    operation->response_buffer = gb_pool_alloc_buffer(size + sizeof(*resp_hdr));
     if (!operation->response_buffer) {
         gb_error("Can not allocate a response_buffer\n");
         return NULL;
     }
 
-    memset(operation->response_buffer, 0, size + sizeof(*resp_hdr));
-
     req_hdr = operation->request_buffer;
     resp_hdr = operation->response_buffer;
 
@@ -694,12 +1484,47 @@ void gb_operation_unref(struct gb_operation *operation)
         return;
     }
 
-    free(operation->request_buffer);
-    free(operation->response_buffer);
     if (operation->response) {
         gb_operation_unref(operation->response);
     }
-    free(operation);
+
+    if (operation->borrows_rx_buffer) {
+        gb_release_rx_buffer(operation->cport, operation->request_buffer);
+        operation->request_buffer = NULL;
+    }
+    gb_pool_free_operation(operation);
+}
+
+/**
+ * Copy a request borrowed from the transport into a buffer owned by the
+ * operation, and give the transport buffer back right away. Handlers that
+ * keep a reference to an operation received with zero-copy must call this
+ * first.
+ */
+int gb_operation_detach_request(struct gb_operation *operation)
+{
+    struct gb_operation_hdr *hdr;
+    void *buffer;
+    size_t size;
+
+    DEBUGASSERT(operation);
+
+    if (!operation->borrows_rx_buffer)
+        return 0;
+
+    hdr = operation->request_buffer;
+    size = le16_to_cpu(hdr->size);
+
+    buffer = gb_pool_alloc_buffer(size);
+    if (!buffer)
+        return -ENOMEM;
+
+    memcpy(buffer, hdr, size);
+    operation->request_buffer = buffer;
+    operation->borrows_rx_buffer = false;
+
+    gb_release_rx_buffer(operation->cport, hdr);
+    return 0;
 }
 
 
@@ -712,18 +1537,12 @@ struct gb_operation *gb_operation_create(unsigned int cport, uint8_t type,
     if (cport >= CPORT_MAX)
         return NULL;
 
-    operation = malloc(sizeof(*operation));
+    operation = gb_pool_alloc_operation(req_size + sizeof(*hdr));
     if (!operation)
         return NULL;
 
-    memset(operation, 0, sizeof(*operation));
     operation->cport = cport;
 
-    operation->request_buffer = malloc(req_size + sizeof(*hdr));
-    if (!operation->request_buffer)
-        goto malloc_error;
-
-    memset(operation->request_buffer, 0, req_size + sizeof(*hdr));
     hdr = operation->request_buffer;
     hdr->size = cpu_to_le16(req_size + sizeof(*hdr));
     hdr->type = type;
@@ -732,9 +1551,6 @@ struct gb_operation *gb_operation_create(unsigned int cport, uint8_t type,
     atomic_init(&operation->ref_count, 1);
 
     return operation;
-malloc_error:
-    free(operation);
-    return NULL;
 }
 
 size_t gb_operation_get_request_payload_size(struct gb_operation *operation)
@@ -775,6 +1591,9 @@ uint8_t gb_operation_get_request_result(struct gb_operation *operation)
 
 int gb_init(struct gb_transport_backend *transport)
 {
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+    int retval;
+#endif
     int i;
 
     if (!transport)
@@ -782,110 +1601,37 @@ int gb_init(struct gb_transport_backend *transport)
 
     memset(&g_cport, 0, sizeof(g_cport));
     for (i = 0; i < CPORT_MAX; i++) {
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+        list_init(&g_cport[i].ready);
+#else
         sem_init(&g_cport[i].rx_fifo_lock, 0, 0);
+#endif
         list_init(&g_cport[i].rx_fifo);
-        list_init(&g_cport[i].tx_fifo);
-        wd_static(&g_cport[i].timeout_wd);
+        list_init(&g_cport[i].expired);
         g_cport[i].timedout_operation.request_buffer = &timedout_hdr;
         list_init(&g_cport[i].timedout_operation.list);
     }
 
-    atomic_init(&request_id, (uint32_t) 0);
-
-    transport_backend = transport;
-    transport_backend->init();
-
-    return 0;
-}
-
-int gb_tape_register_mechanism(struct gb_tape_mechanism *mechanism)
-{
-    if (!mechanism || !mechanism->open || !mechanism->close ||
-        !mechanism->read || !mechanism->write)
-        return -EINVAL;
-
-    if (gb_tape)
-        return -EBUSY;
-
-    gb_tape = mechanism;
+    for (i = 0; i < GB_INFLIGHT_BUCKETS; i++)
+        list_init(&g_inflight[i]);
 
-    return 0;
-}
-
-int gb_tape_communication(const char *pathname)
-{
-    if (!gb_tape)
-        return -EINVAL;
-
-    if (gb_tape_fd >= 0)
-        return -EBUSY;
+    for (i = 0; i < GB_WHEEL_SLOTS; i++)
+        list_init(&g_timeout_wheel.slots[i]);
+    wd_static(&g_timeout_wheel.wd);
+    g_timeout_wheel.count = 0;
 
-    gb_tape_fd = gb_tape->open(pathname, GB_TAPE_WRONLY);
-    if (gb_tape_fd < 0)
-        return gb_tape_fd;
+    atomic_init(&request_id, (uint32_t) 0);
 
-    return 0;
-}
+    gb_pool_init();
 
-int gb_tape_stop(void)
-{
-    if (!gb_tape || gb_tape_fd < 0)
-        return -EINVAL;
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+    retval = gb_worker_pool_init();
+    if (retval)
+        return retval;
+#endif
 
-    gb_tape->close(gb_tape_fd);
-    gb_tape_fd = -EBADFD;
+    transport_backend = transport;
+    transport_backend->init();
 
     return 0;
 }
-
-int gb_tape_replay(const char *pathname)
-{
-    struct gb_tape_record_header hdr;
-    char *buffer;
-    ssize_t nread;
-    int retval = 0;
-    int fd;
-
-    if (!pathname || !gb_tape)
-        return -EINVAL;
-
-    lowsyslog("greybus: replaying '%s'...\n", pathname);
-
-    fd = gb_tape->open(pathname, GB_TAPE_RDONLY);
-    if (fd < 0)
-        return fd;
-
-    buffer = malloc(CPORT_BUF_SIZE);
-    if (!buffer) {
-        retval = -ENOMEM;
-        goto error_buffer_alloc;
-    }
-
-    while (1) {
-        nread = gb_tape->read(fd, &hdr, sizeof(hdr));
-        if (!nread)
-            break;
-
-        if (nread != sizeof(hdr)) {
-            gb_error("gb-tape: invalid byte count read, aborting...\n");
-            retval = -EIO;
-            break;
-        }
-
-        nread = gb_tape->read(fd, buffer, hdr.size);
-        if (hdr.size != nread) {
-            gb_error("gb-tape: invalid byte count read, aborting...\n");
-            retval = -EIO;
-            break;
-        }
-
-        greybus_rx_handler(hdr.cport, buffer, nread);
-    }
-
-    free(buffer);
-
-error_buffer_alloc:
-    gb_tape->close(fd);
-
-    return retval;
-}
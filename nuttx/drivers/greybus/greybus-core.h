@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GREYBUS_CORE_H__
+#define __GREYBUS_CORE_H__
+
+#include <nuttx/config.h>
+#include <nuttx/greybus/greybus.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Internal interfaces shared by the greybus-core files. Nothing in here is
+ * meant to be used by the protocol drivers.
+ */
+
+enum gb_tape_dir {
+    GB_TAPE_DIR_RX,
+    GB_TAPE_DIR_TX,
+};
+
+void gb_tape_record(unsigned int cport, enum gb_tape_dir dir,
+                    const void *data, size_t size);
+
+#ifdef CONFIG_GREYBUS_OPERATION_POOL
+void gb_pool_init(void);
+struct gb_operation *gb_pool_alloc_operation(size_t req_size);
+void gb_pool_free_operation(struct gb_operation *operation);
+void *gb_pool_alloc_buffer(size_t size);
+void gb_pool_free_buffer(void *buffer);
+#else
+static inline void gb_pool_init(void)
+{
+}
+
+static inline void *gb_pool_alloc_buffer(size_t size)
+{
+    void *buffer = malloc(size);
+    if (buffer)
+        memset(buffer, 0, size);
+    return buffer;
+}
+
+static inline void gb_pool_free_buffer(void *buffer)
+{
+    free(buffer);
+}
+
+static inline struct gb_operation *gb_pool_alloc_operation(size_t req_size)
+{
+    struct gb_operation *operation;
+
+    operation = malloc(sizeof(*operation));
+    if (!operation)
+        return NULL;
+
+    memset(operation, 0, sizeof(*operation));
+
+    if (!req_size)
+        return operation;
+
+    operation->request_buffer = gb_pool_alloc_buffer(req_size);
+    if (!operation->request_buffer) {
+        free(operation);
+        return NULL;
+    }
+
+    return operation;
+}
+
+static inline void gb_pool_free_operation(struct gb_operation *operation)
+{
+    free(operation->request_buffer);
+    free(operation->response_buffer);
+    free(operation);
+}
+#endif
+
+#endif /* __GREYBUS_CORE_H__ */
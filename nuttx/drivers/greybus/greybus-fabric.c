@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * In-process Greybus transport, for measuring the protocol drivers without
+ * UniPro hardware.
+ *
+ * Each direction of the link is a queue drained by its own thread. A
+ * message is copied when sent, and is scheduled for delivery once the
+ * link has serialized it at the configured bandwidth, plus the configured
+ * latency. Messages are never reordered.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/list.h>
+#include <nuttx/greybus/greybus.h>
+#include <nuttx/greybus/debug.h>
+#include <nuttx/greybus/fabric.h>
+
+#include <arch/irq.h>
+#include <arch/tsb/unipro.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GB_FABRIC_QUEUE_DEPTH   CONFIG_GREYBUS_FABRIC_QUEUE_DEPTH
+
+struct gb_fabric_msg {
+    struct list_head list;
+    unsigned int cport;
+    size_t len;
+    uint64_t sent;              /* usec */
+    uint64_t deliver;           /* usec */
+    uint8_t data[];
+};
+
+struct gb_fabric_dir {
+    struct list_head queue;
+    sem_t pending;
+    sem_t slots;
+    uint64_t busy_until;        /* usec, end of the last serialization */
+    pthread_t thread;
+    void (*deliver)(struct gb_fabric_msg *msg);
+    struct gb_fabric_dir_stats stats;
+};
+
+struct gb_fabric_peer {
+    gb_fabric_peer_rx rx;
+    void *priv;
+};
+
+static struct gb_fabric_link_cfg g_fabric_cfg = {
+    .bandwidth = CONFIG_GREYBUS_FABRIC_BANDWIDTH,
+    .latency = CONFIG_GREYBUS_FABRIC_LATENCY_USEC,
+};
+
+static struct gb_fabric_peer g_fabric_peers[CPORT_MAX];
+static bool g_fabric_listening[CPORT_MAX];
+static struct gb_fabric_dir g_to_local;
+static struct gb_fabric_dir g_to_peer;
+
+static uint64_t gb_fabric_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int gb_fabric_queue(struct gb_fabric_dir *dir, unsigned int cport,
+                           const void *buf, size_t len, bool can_block)
+{
+    struct gb_fabric_msg *msg;
+    irqstate_t flags;
+    uint64_t start;
+    int retval;
+
+    if (can_block) {
+        while ((retval = sem_wait(&dir->slots)) && errno == EINTR);
+    } else {
+        retval = sem_trywait(&dir->slots);
+    }
+
+    if (retval) {
+        flags = irqsave();
+        dir->stats.dropped++;
+        irqrestore(flags);
+        return -EAGAIN;
+    }
+
+    msg = malloc(sizeof(*msg) + len);
+    if (!msg) {
+        sem_post(&dir->slots);
+        return -ENOMEM;
+    }
+
+    list_init(&msg->list);
+    msg->cport = cport;
+    msg->len = len;
+    memcpy(msg->data, buf, len);
+
+    flags = irqsave();
+
+    msg->sent = gb_fabric_now();
+    start = dir->busy_until > msg->sent ? dir->busy_until : msg->sent;
+    if (g_fabric_cfg.bandwidth)
+        start += (uint64_t) len * 1000000 / g_fabric_cfg.bandwidth;
+    dir->busy_until = start;
+    msg->deliver = start + g_fabric_cfg.latency;
+
+    list_add(&dir->queue, &msg->list);
+    dir->stats.messages++;
+    dir->stats.bytes += len;
+
+    irqrestore(flags);
+
+    sem_post(&dir->pending);
+    return 0;
+}
+
+static void *gb_fabric_thread(void *data)
+{
+    struct gb_fabric_dir *dir = data;
+    struct gb_fabric_msg *msg;
+    irqstate_t flags;
+    uint64_t now;
+    uint32_t delay;
+
+    while (1) {
+        sem_wait(&dir->pending);
+
+        flags = irqsave();
+        msg = list_entry(dir->queue.next, struct gb_fabric_msg, list);
+        list_del(&msg->list);
+        irqrestore(flags);
+
+        now = gb_fabric_now();
+        if (msg->deliver > now) {
+            usleep(msg->deliver - now);
+            now = gb_fabric_now();
+        }
+
+        delay = now - msg->sent;
+        flags = irqsave();
+        if (delay > dir->stats.max_delay)
+            dir->stats.max_delay = delay;
+        irqrestore(flags);
+
+        sem_post(&dir->slots);
+        dir->deliver(msg);
+    }
+
+    return NULL;
+}
+
+static void gb_fabric_unrouted(struct gb_fabric_dir *dir,
+                               struct gb_fabric_msg *msg)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    dir->stats.unrouted++;
+    irqrestore(flags);
+
+    gb_debug("fabric: nobody listening on CP%u\n", msg->cport);
+    free(msg);
+}
+
+static void gb_fabric_deliver_local(struct gb_fabric_msg *msg)
+{
+    if (!g_fabric_listening[msg->cport]) {
+        gb_fabric_unrouted(&g_to_local, msg);
+        return;
+    }
+
+#ifdef CONFIG_GREYBUS_ZERO_COPY_RX
+    /* freed by gb_fabric_release_rx_buffer() */
+    greybus_rx_handler_zero_copy(msg->cport, msg->data, msg->len);
+#else
+    greybus_rx_handler(msg->cport, msg->data, msg->len);
+    free(msg);
+#endif
+}
+
+static void gb_fabric_deliver_peer(struct gb_fabric_msg *msg)
+{
+    struct gb_fabric_peer *peer = &g_fabric_peers[msg->cport];
+    gb_fabric_peer_rx rx;
+    void *priv;
+    irqstate_t flags;
+
+    flags = irqsave();
+    rx = peer->rx;
+    priv = peer->priv;
+    irqrestore(flags);
+
+    if (!rx) {
+        gb_fabric_unrouted(&g_to_peer, msg);
+        return;
+    }
+
+    rx(msg->cport, msg->data, msg->len, priv);
+    free(msg);
+}
+
+#ifdef CONFIG_GREYBUS_ZERO_COPY_RX
+static void gb_fabric_release_rx_buffer(unsigned int cport, void *buf)
+{
+    free(list_entry(buf, struct gb_fabric_msg, data));
+}
+#endif
+
+static void gb_fabric_init_backend(void)
+{
+}
+
+static int gb_fabric_listen(unsigned int cport)
+{
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    g_fabric_listening[cport] = true;
+    return 0;
+}
+
+static int gb_fabric_stop_listening(unsigned int cport)
+{
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    g_fabric_listening[cport] = false;
+    return 0;
+}
+
+/* May be called with interrupts disabled, so never blocks */
+static int gb_fabric_send(unsigned int cport, const void *buf, size_t len)
+{
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    return gb_fabric_queue(&g_to_peer, cport, buf, len, false);
+}
+
+static struct gb_transport_backend gb_fabric_backend = {
+    .init = gb_fabric_init_backend,
+    .listen = gb_fabric_listen,
+    .stop_listening = gb_fabric_stop_listening,
+    .send = gb_fabric_send,
+#ifdef CONFIG_GREYBUS_ZERO_COPY_RX
+    .release_rx_buffer = gb_fabric_release_rx_buffer,
+#endif
+};
+
+int gb_fabric_peer_send(unsigned int cport, const void *buf, size_t len)
+{
+    if (cport >= CPORT_MAX || !buf ||
+        len < sizeof(struct gb_operation_hdr) || len > CPORT_BUF_SIZE)
+        return -EINVAL;
+
+    return gb_fabric_queue(&g_to_local, cport, buf, len, true);
+}
+
+int gb_fabric_attach_peer(unsigned int cport, gb_fabric_peer_rx rx,
+                          void *priv)
+{
+    irqstate_t flags;
+    int retval = 0;
+
+    if (cport >= CPORT_MAX || !rx)
+        return -EINVAL;
+
+    flags = irqsave();
+    if (g_fabric_peers[cport].rx) {
+        retval = -EBUSY;
+    } else {
+        g_fabric_peers[cport].rx = rx;
+        g_fabric_peers[cport].priv = priv;
+    }
+    irqrestore(flags);
+
+    return retval;
+}
+
+int gb_fabric_detach_peer(unsigned int cport)
+{
+    irqstate_t flags;
+
+    if (cport >= CPORT_MAX)
+        return -EINVAL;
+
+    flags = irqsave();
+    g_fabric_peers[cport].rx = NULL;
+    g_fabric_peers[cport].priv = NULL;
+    irqrestore(flags);
+
+    return 0;
+}
+
+int gb_fabric_set_link(const struct gb_fabric_link_cfg *cfg)
+{
+    irqstate_t flags;
+
+    if (!cfg)
+        return -EINVAL;
+
+    flags = irqsave();
+    g_fabric_cfg = *cfg;
+    irqrestore(flags);
+
+    return 0;
+}
+
+void gb_fabric_get_link(struct gb_fabric_link_cfg *cfg)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    *cfg = g_fabric_cfg;
+    irqrestore(flags);
+}
+
+int gb_fabric_get_stats(struct gb_fabric_stats *stats)
+{
+    irqstate_t flags;
+
+    if (!stats)
+        return -EINVAL;
+
+    flags = irqsave();
+    stats->to_local = g_to_local.stats;
+    stats->to_peer = g_to_peer.stats;
+    irqrestore(flags);
+
+    return 0;
+}
+
+void gb_fabric_reset_stats(void)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    memset(&g_to_local.stats, 0, sizeof(g_to_local.stats));
+    memset(&g_to_peer.stats, 0, sizeof(g_to_peer.stats));
+    irqrestore(flags);
+}
+
+static int gb_fabric_dir_init(struct gb_fabric_dir *dir,
+                              void (*deliver)(struct gb_fabric_msg *msg))
+{
+    int retval;
+
+    list_init(&dir->queue);
+    sem_init(&dir->pending, 0, 0);
+    sem_init(&dir->slots, 0, GB_FABRIC_QUEUE_DEPTH);
+    dir->busy_until = 0;
+    dir->deliver = deliver;
+    memset(&dir->stats, 0, sizeof(dir->stats));
+
+    retval = pthread_create(&dir->thread, NULL, gb_fabric_thread, dir);
+    if (retval) {
+        sem_destroy(&dir->pending);
+        sem_destroy(&dir->slots);
+    }
+
+    return -retval;
+}
+
+int gb_fabric_init(void)
+{
+    int retval;
+
+    retval = gb_fabric_dir_init(&g_to_local, gb_fabric_deliver_local);
+    if (retval) {
+        gb_error("fabric: can't start the receive thread: %d\n", retval);
+        return retval;
+    }
+
+    retval = gb_fabric_dir_init(&g_to_peer, gb_fabric_deliver_peer);
+    if (retval) {
+        gb_error("fabric: can't start the transmit thread: %d\n", retval);
+        return retval;
+    }
+
+    gb_debug("Greybus: register fabric backend\n");
+    return gb_init(&gb_fabric_backend);
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Pre-allocated storage for Greybus operations.
+ *
+ * Operations and their buffers are carved out of three statically sized
+ * pools so that the receive and response paths do not have to go through
+ * the heap (and its semaphore) for every message:
+ *
+ *  - operations, each one embedding a small request buffer, so that a small
+ *    message only costs a single pool entry;
+ *  - small buffers, mostly used for responses;
+ *  - large buffers of CPORT_BUF_SIZE bytes, for anything that does not fit
+ *    in a small buffer.
+ *
+ * When a pool is empty, the allocation falls back to the heap and the
+ * exhaustion counter of that pool is incremented.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/list.h>
+#include <nuttx/greybus/greybus.h>
+
+#include <arch/irq.h>
+#include <arch/tsb/unipro.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "greybus-core.h"
+
+#define GB_POOL_INLINE_SIZE     CONFIG_GREYBUS_OPERATION_POOL_INLINE_SIZE
+
+#if GB_POOL_INLINE_SIZE < 8
+#error "CONFIG_GREYBUS_OPERATION_POOL_INLINE_SIZE must hold a Greybus header"
+#endif
+
+struct gb_pool {
+    struct list_head free_list;
+    uint8_t *base;
+    size_t entry_size;
+    struct gb_pool_class_stats stats;
+};
+
+struct gb_pool_operation {
+    struct gb_operation operation;
+    uint8_t buffer[GB_POOL_INLINE_SIZE];
+};
+
+union gb_pool_small_buffer {
+    struct list_head list;
+    uint8_t data[GB_POOL_INLINE_SIZE];
+};
+
+union gb_pool_large_buffer {
+    struct list_head list;
+    uint8_t data[CPORT_BUF_SIZE];
+};
+
+static struct gb_pool_operation
+    g_pool_operations[CONFIG_GREYBUS_OPERATION_POOL_SIZE];
+static union gb_pool_small_buffer
+    g_pool_small_buffers[CONFIG_GREYBUS_OPERATION_POOL_SMALL_BUFFERS];
+static union gb_pool_large_buffer
+    g_pool_large_buffers[CONFIG_GREYBUS_OPERATION_POOL_LARGE_BUFFERS];
+
+static struct gb_pool g_operation_pool;
+static struct gb_pool g_small_pool;
+static struct gb_pool g_large_pool;
+
+static void gb_pool_setup(struct gb_pool *pool, void *base, size_t entry_size,
+                          unsigned int count)
+{
+    unsigned int i;
+
+    list_init(&pool->free_list);
+    pool->base = base;
+    pool->entry_size = entry_size;
+
+    memset(&pool->stats, 0, sizeof(pool->stats));
+    pool->stats.size = count;
+    pool->stats.free = count;
+    pool->stats.min_free = count;
+
+    for (i = 0; i < count; i++) {
+        list_add(&pool->free_list,
+                 (struct list_head *) (pool->base + i * entry_size));
+    }
+}
+
+static bool gb_pool_owns(struct gb_pool *pool, const void *entry)
+{
+    const uint8_t *ptr = entry;
+
+    return ptr >= pool->base &&
+           ptr < pool->base + pool->stats.size * pool->entry_size;
+}
+
+static void *gb_pool_get(struct gb_pool *pool)
+{
+    struct list_head *entry = NULL;
+    irqstate_t flags;
+
+    flags = irqsave();
+
+    if (!list_is_empty(&pool->free_list)) {
+        entry = pool->free_list.next;
+        list_del(entry);
+
+        pool->stats.free--;
+        if (pool->stats.free < pool->stats.min_free)
+            pool->stats.min_free = pool->stats.free;
+    } else {
+        pool->stats.exhausted++;
+    }
+
+    irqrestore(flags);
+
+    return entry;
+}
+
+static void gb_pool_put(struct gb_pool *pool, void *entry)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    list_add(&pool->free_list, entry);
+    pool->stats.free++;
+    irqrestore(flags);
+}
+
+void *gb_pool_alloc_buffer(size_t size)
+{
+    void *buffer = NULL;
+
+    if (size <= GB_POOL_INLINE_SIZE)
+        buffer = gb_pool_get(&g_small_pool);
+
+    if (!buffer && size <= CPORT_BUF_SIZE)
+        buffer = gb_pool_get(&g_large_pool);
+
+    if (!buffer) {
+        buffer = malloc(size);
+        if (!buffer)
+            return NULL;
+    }
+
+    memset(buffer, 0, size);
+    return buffer;
+}
+
+void gb_pool_free_buffer(void *buffer)
+{
+    if (!buffer)
+        return;
+
+    if (gb_pool_owns(&g_small_pool, buffer))
+        gb_pool_put(&g_small_pool, buffer);
+    else if (gb_pool_owns(&g_large_pool, buffer))
+        gb_pool_put(&g_large_pool, buffer);
+    else
+        free(buffer);
+}
+
+struct gb_operation *gb_pool_alloc_operation(size_t req_size)
+{
+    struct gb_pool_operation *entry;
+    struct gb_operation *operation;
+
+    entry = gb_pool_get(&g_operation_pool);
+    if (entry) {
+        operation = &entry->operation;
+    } else {
+        operation = malloc(sizeof(*operation));
+        if (!operation)
+            return NULL;
+    }
+
+    memset(operation, 0, sizeof(*operation));
+
+    if (!req_size)
+        return operation;
+
+    if (entry && req_size <= sizeof(entry->buffer)) {
+        operation->request_buffer = entry->buffer;
+        memset(entry->buffer, 0, req_size);
+        return operation;
+    }
+
+    operation->request_buffer = gb_pool_alloc_buffer(req_size);
+    if (!operation->request_buffer) {
+        if (entry)
+            gb_pool_put(&g_operation_pool, entry);
+        else
+            free(operation);
+        return NULL;
+    }
+
+    return operation;
+}
+
+void gb_pool_free_operation(struct gb_operation *operation)
+{
+    struct gb_pool_operation *entry = NULL;
+
+    if (gb_pool_owns(&g_operation_pool, operation))
+        entry = (struct gb_pool_operation *) operation;
+
+    if (!entry || operation->request_buffer != entry->buffer)
+        gb_pool_free_buffer(operation->request_buffer);
+    gb_pool_free_buffer(operation->response_buffer);
+
+    if (entry)
+        gb_pool_put(&g_operation_pool, entry);
+    else
+        free(operation);
+}
+
+int gb_operation_pool_get_stats(struct gb_operation_pool_stats *stats)
+{
+    irqstate_t flags;
+
+    if (!stats)
+        return -EINVAL;
+
+    flags = irqsave();
+    stats->operations = g_operation_pool.stats;
+    stats->small = g_small_pool.stats;
+    stats->large = g_large_pool.stats;
+    irqrestore(flags);
+
+    return 0;
+}
+
+void gb_pool_init(void)
+{
+    gb_pool_setup(&g_operation_pool, g_pool_operations,
+                  sizeof(g_pool_operations[0]),
+                  ARRAY_SIZE(g_pool_operations));
+    gb_pool_setup(&g_small_pool, g_pool_small_buffers,
+                  sizeof(g_pool_small_buffers[0]),
+                  ARRAY_SIZE(g_pool_small_buffers));
+    gb_pool_setup(&g_large_pool, g_pool_large_buffers,
+                  sizeof(g_pool_large_buffers[0]),
+                  ARRAY_SIZE(g_pool_large_buffers));
+}
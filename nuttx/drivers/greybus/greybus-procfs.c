@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * /proc/greybus: per-CPort Greybus statistics.
+ *
+ *  - stats: message and byte counters, receive fifo depth, timeouts,
+ *    out-of-memory responses and transport send failures;
+ *  - latency: histogram of the time between the reception of a request and
+ *    the sending of its response.
+ *
+ * Only CPorts with a registered driver are listed. The content of a file is
+ * a snapshot taken when it is opened. Writing anything to either file resets
+ * all the counters.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/procfs.h>
+#include <nuttx/greybus/greybus.h>
+
+#include <arch/tsb/unipro.h>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define GB_PROCFS_LINELEN   112
+
+enum gb_procfs_node {
+    GB_PROCFS_STATS,
+    GB_PROCFS_LATENCY,
+};
+
+struct gb_procfs_file {
+    struct procfs_file_s base;  /* must be first */
+    enum gb_procfs_node node;
+    size_t size;
+    char *buf;
+};
+
+static int gb_procfs_node(const char *relpath, enum gb_procfs_node *node)
+{
+    if (!strcmp(relpath, "greybus/stats")) {
+        *node = GB_PROCFS_STATS;
+        return 0;
+    }
+
+    if (!strcmp(relpath, "greybus/latency")) {
+        *node = GB_PROCFS_LATENCY;
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+static size_t gb_procfs_print_stats(char *buf, size_t len)
+{
+    struct gb_cport_stats stats;
+    size_t size;
+    int i;
+
+    size = snprintf(buf, len,
+                    "cport driver           rx_msgs   rx_bytes    tx_msgs "
+                    "  tx_bytes fifo  hwm timeouts   oom send_err\n");
+
+    for (i = 0; i < CPORT_MAX && size < len; i++) {
+        if (gb_cport_get_stats(i, &stats))
+            continue;
+
+        size += snprintf(buf + size, len - size,
+                         "%5d %-12.12s %10lu %10lu %10lu %10lu %4u %4u "
+                         "%8lu %5lu %8lu\n", i, stats.driver,
+                         stats.rx_msgs, stats.rx_bytes,
+                         stats.tx_msgs, stats.tx_bytes,
+                         stats.rx_fifo_depth, stats.rx_fifo_hwm,
+                         stats.timeouts, stats.oom_responses,
+                         stats.send_errors);
+    }
+
+    return size < len ? size : len;
+}
+
+static size_t gb_procfs_print_latency(char *buf, size_t len)
+{
+    struct gb_cport_stats stats;
+    size_t size;
+    int i;
+    int j;
+
+    size = snprintf(buf, len, "cport");
+    for (j = 0; j < GB_LATENCY_BUCKETS - 1 && size < len; j++) {
+        size += snprintf(buf + size, len - size, " <%7luus",
+                         gb_latency_bucket_usec[j]);
+    }
+    if (size < len) {
+        size += snprintf(buf + size, len - size, " >=%6luus\n",
+                         gb_latency_bucket_usec[GB_LATENCY_BUCKETS - 2]);
+    }
+
+    for (i = 0; i < CPORT_MAX && size < len; i++) {
+        if (gb_cport_get_stats(i, &stats))
+            continue;
+
+        size += snprintf(buf + size, len - size, "%5d", i);
+        for (j = 0; j < GB_LATENCY_BUCKETS && size < len; j++) {
+            size += snprintf(buf + size, len - size, " %10lu",
+                             stats.latency[j]);
+        }
+        if (size < len)
+            size += snprintf(buf + size, len - size, "\n");
+    }
+
+    return size < len ? size : len;
+}
+
+static int gb_procfs_open(struct file *filep, const char *relpath,
+                          int oflags, mode_t mode)
+{
+    struct gb_procfs_file *priv;
+    enum gb_procfs_node node;
+    size_t len;
+    int retval;
+
+    retval = gb_procfs_node(relpath, &node);
+    if (retval)
+        return retval;
+
+    priv = kmm_zalloc(sizeof(*priv));
+    if (!priv)
+        return -ENOMEM;
+
+    priv->node = node;
+
+    if (oflags & O_RDOK) {
+        len = (CPORT_MAX + 1) * GB_PROCFS_LINELEN;
+        priv->buf = kmm_malloc(len);
+        if (!priv->buf) {
+            kmm_free(priv);
+            return -ENOMEM;
+        }
+
+        if (node == GB_PROCFS_STATS)
+            priv->size = gb_procfs_print_stats(priv->buf, len);
+        else
+            priv->size = gb_procfs_print_latency(priv->buf, len);
+    }
+
+    filep->f_priv = priv;
+    return 0;
+}
+
+static int gb_procfs_close(struct file *filep)
+{
+    struct gb_procfs_file *priv = filep->f_priv;
+
+    DEBUGASSERT(priv);
+
+    kmm_free(priv->buf);
+    kmm_free(priv);
+    filep->f_priv = NULL;
+    return 0;
+}
+
+static ssize_t gb_procfs_read(struct file *filep, char *buffer, size_t buflen)
+{
+    struct gb_procfs_file *priv = filep->f_priv;
+    off_t offset = filep->f_pos;
+    ssize_t retval;
+
+    DEBUGASSERT(priv);
+
+    if (!priv->buf)
+        return -EACCES;
+
+    retval = procfs_memcpy(priv->buf, priv->size, buffer, buflen, &offset);
+    if (retval > 0)
+        filep->f_pos += retval;
+
+    return retval;
+}
+
+static ssize_t gb_procfs_write(struct file *filep, const char *buffer,
+                               size_t buflen)
+{
+    gb_stats_reset();
+    return buflen;
+}
+
+static int gb_procfs_dup(const struct file *oldp, struct file *newp)
+{
+    struct gb_procfs_file *oldpriv = oldp->f_priv;
+    struct gb_procfs_file *newpriv;
+
+    DEBUGASSERT(oldpriv);
+
+    newpriv = kmm_malloc(sizeof(*newpriv));
+    if (!newpriv)
+        return -ENOMEM;
+
+    memcpy(newpriv, oldpriv, sizeof(*newpriv));
+
+    if (oldpriv->buf) {
+        newpriv->buf = kmm_malloc(oldpriv->size);
+        if (!newpriv->buf) {
+            kmm_free(newpriv);
+            return -ENOMEM;
+        }
+        memcpy(newpriv->buf, oldpriv->buf, oldpriv->size);
+    }
+
+    newp->f_priv = newpriv;
+    return 0;
+}
+
+static int gb_procfs_stat(const char *relpath, struct stat *buf)
+{
+    enum gb_procfs_node node;
+    int retval;
+
+    retval = gb_procfs_node(relpath, &node);
+    if (retval)
+        return retval;
+
+    buf->st_mode    = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR | S_IWUSR;
+    buf->st_size    = 0;
+    buf->st_blksize = 0;
+    buf->st_blocks  = 0;
+    return 0;
+}
+
+const struct procfs_operations gb_procfs_operations = {
+    .open = gb_procfs_open,
+    .close = gb_procfs_close,
+    .read = gb_procfs_read,
+    .write = gb_procfs_write,
+    .dup = gb_procfs_dup,
+    .stat = gb_procfs_stat,
+};
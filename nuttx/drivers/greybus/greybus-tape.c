@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Greybus tape: record the Greybus traffic of a device and replay it later.
+ *
+ * Recording must not disturb the traffic it records, so messages are only
+ * copied into a ring buffer from the RX and TX paths, and a writer thread
+ * drains the ring to the tape mechanism. Producers are serialized by
+ * disabling interrupts, the writer never takes a lock. Records that do not
+ * fit in the ring are dropped and counted. If the tape mechanism fails, the
+ * recording stops there so that the tape stays readable up to that point.
+ *
+ * A tape starts with GB_TAPE_MAGIC followed by records made of a
+ * struct gb_tape_record_header and the message. Tapes without the magic
+ * are from the previous format, where the header only held the size and
+ * the CPort of received messages.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+#include <nuttx/greybus/greybus.h>
+#include <nuttx/greybus/debug.h>
+#include <nuttx/greybus/tape.h>
+
+#include <arch/tsb/unipro.h>
+#include <arch/irq.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "greybus-core.h"
+
+#define GB_TAPE_MAGIC               0x32544247 /* "GBT2" */
+#define GB_TAPE_RECORD_TX           (1 << 0)
+#define GB_TAPE_WRITER_STACK_SIZE   2048
+
+#ifndef CONFIG_GREYBUS_TAPE_RING_SIZE
+#define CONFIG_GREYBUS_TAPE_RING_SIZE 4096
+#endif
+
+#if CONFIG_GREYBUS_TAPE_RING_SIZE & (CONFIG_GREYBUS_TAPE_RING_SIZE - 1)
+#error "CONFIG_GREYBUS_TAPE_RING_SIZE must be a power of two"
+#endif
+
+struct gb_tape_legacy_record_header {
+    uint16_t size;
+    uint16_t cport;
+};
+
+struct gb_tape_record_header {
+    uint16_t size;
+    uint16_t cport;
+    uint8_t flags;
+    uint8_t pad[3];
+    uint32_t sec;           /* CLOCK_MONOTONIC time of the message */
+    uint32_t nsec;
+};
+
+struct gb_tape_recorder {
+    struct gb_tape_mechanism *mechanism;
+    int fd;
+
+    /* Both indexes run freely, they are masked when accessing buf */
+    volatile uint32_t head;     /* written by the producers only */
+    volatile uint32_t tail;     /* written by the writer only */
+    uint8_t buf[CONFIG_GREYBUS_TAPE_RING_SIZE];
+
+    volatile bool recording;
+    volatile bool running;
+    sem_t sem;
+    pthread_t writer;
+
+    unsigned long records;
+    unsigned long dropped;
+    unsigned long lost;         /* bytes that could not be written */
+    int error;
+};
+
+static struct gb_tape_recorder g_tape = {
+    .fd = -EBADFD,
+};
+
+static void gb_tape_ring_put(uint32_t head, const void *data, size_t size)
+{
+    uint32_t offset = head & (CONFIG_GREYBUS_TAPE_RING_SIZE - 1);
+    size_t chunk = CONFIG_GREYBUS_TAPE_RING_SIZE - offset;
+
+    if (chunk > size)
+        chunk = size;
+
+    memcpy(&g_tape.buf[offset], data, chunk);
+    memcpy(g_tape.buf, (const uint8_t *) data + chunk, size - chunk);
+}
+
+void gb_tape_record(unsigned int cport, enum gb_tape_dir dir,
+                    const void *data, size_t size)
+{
+    struct gb_tape_record_header hdr;
+    struct timespec ts;
+    irqstate_t flags;
+    uint32_t head;
+    bool was_empty;
+
+    if (!g_tape.recording)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    hdr.size = size;
+    hdr.cport = cport;
+    hdr.flags = dir == GB_TAPE_DIR_TX ? GB_TAPE_RECORD_TX : 0;
+    memset(hdr.pad, 0, sizeof(hdr.pad));
+    hdr.sec = ts.tv_sec;
+    hdr.nsec = ts.tv_nsec;
+
+    flags = irqsave();
+
+    head = g_tape.head;
+    if (sizeof(hdr) + size >
+        CONFIG_GREYBUS_TAPE_RING_SIZE - (head - g_tape.tail)) {
+        g_tape.dropped++;
+        irqrestore(flags);
+        return;
+    }
+
+    was_empty = head == g_tape.tail;
+
+    gb_tape_ring_put(head, &hdr, sizeof(hdr));
+    gb_tape_ring_put(head + sizeof(hdr), data, size);
+    g_tape.head = head + sizeof(hdr) + size;
+    g_tape.records++;
+
+    /* The writer only sleeps once it has emptied the ring */
+    if (was_empty)
+        sem_post(&g_tape.sem);
+
+    irqrestore(flags);
+}
+
+static void gb_tape_drain(void)
+{
+    irqstate_t flags;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t offset;
+    size_t chunk;
+    ssize_t nwritten;
+
+    while ((head = g_tape.head) != (tail = g_tape.tail)) {
+        if (g_tape.error) {
+            /* Discard what was recorded after the tape mechanism failed */
+            flags = irqsave();
+            g_tape.lost += g_tape.head - tail;
+            g_tape.tail = g_tape.head;
+            irqrestore(flags);
+            return;
+        }
+
+        offset = tail & (CONFIG_GREYBUS_TAPE_RING_SIZE - 1);
+        chunk = head - tail;
+        if (chunk > CONFIG_GREYBUS_TAPE_RING_SIZE - offset)
+            chunk = CONFIG_GREYBUS_TAPE_RING_SIZE - offset;
+
+        nwritten = g_tape.mechanism->write(g_tape.fd, &g_tape.buf[offset],
+                                           chunk);
+        if (nwritten <= 0) {
+            /* The tape ends with the last complete write */
+            g_tape.recording = false;
+            g_tape.error = nwritten < 0 ? nwritten : -EIO;
+            continue;
+        }
+
+        /* Partial writes are resumed where they stopped */
+        g_tape.tail = tail + nwritten;
+    }
+}
+
+static void *gb_tape_writer(void *data)
+{
+    while (g_tape.running) {
+        gb_tape_drain();
+        sem_wait(&g_tape.sem);
+    }
+
+    gb_tape_drain();
+    return NULL;
+}
+
+int gb_tape_register_mechanism(struct gb_tape_mechanism *mechanism)
+{
+    if (!mechanism || !mechanism->open || !mechanism->close ||
+        !mechanism->read || !mechanism->write)
+        return -EINVAL;
+
+    if (g_tape.mechanism)
+        return -EBUSY;
+
+    g_tape.mechanism = mechanism;
+
+    return 0;
+}
+
+int gb_tape_communication(const char *pathname)
+{
+    uint32_t magic = GB_TAPE_MAGIC;
+    pthread_attr_t attr;
+    int retval;
+
+    if (!g_tape.mechanism)
+        return -EINVAL;
+
+    if (g_tape.fd >= 0)
+        return -EBUSY;
+
+    g_tape.fd = g_tape.mechanism->open(pathname, GB_TAPE_WRONLY);
+    if (g_tape.fd < 0)
+        return g_tape.fd;
+
+    if (g_tape.mechanism->write(g_tape.fd, &magic, sizeof(magic)) !=
+        sizeof(magic)) {
+        retval = -EIO;
+        goto error_close;
+    }
+
+    g_tape.head = g_tape.tail = 0;
+    g_tape.records = g_tape.dropped = g_tape.lost = 0;
+    g_tape.error = 0;
+    g_tape.running = true;
+    sem_init(&g_tape.sem, 0, 0);
+
+    retval = pthread_attr_init(&attr);
+    if (retval)
+        goto error_sem;
+
+    retval = pthread_attr_setstacksize(&attr, GB_TAPE_WRITER_STACK_SIZE);
+    if (!retval)
+        retval = pthread_create(&g_tape.writer, &attr, gb_tape_writer, NULL);
+    pthread_attr_destroy(&attr);
+    if (retval)
+        goto error_sem;
+
+    g_tape.recording = true;
+
+    return 0;
+
+error_sem:
+    retval = -retval;
+    sem_destroy(&g_tape.sem);
+error_close:
+    g_tape.mechanism->close(g_tape.fd);
+    g_tape.fd = -EBADFD;
+    return retval;
+}
+
+int gb_tape_stop(void)
+{
+    if (!g_tape.mechanism || g_tape.fd < 0)
+        return -EINVAL;
+
+    g_tape.recording = false;
+    g_tape.running = false;
+    sem_post(&g_tape.sem);
+    pthread_join(g_tape.writer, NULL);
+    sem_destroy(&g_tape.sem);
+
+    g_tape.mechanism->close(g_tape.fd);
+    g_tape.fd = -EBADFD;
+
+    lowsyslog("greybus: %lu messages taped, %lu dropped\n",
+              g_tape.records, g_tape.dropped);
+
+    if (g_tape.error) {
+        gb_error("gb-tape: write error %d, %lu bytes lost\n",
+                 g_tape.error, g_tape.lost);
+    }
+
+    return g_tape.error;
+}
+
+static void gb_tape_wait(const struct timespec *start,
+                         const struct timespec *offset)
+{
+    struct timespec deadline;
+    struct timespec now;
+    long long delay;
+
+    deadline.tv_sec = start->tv_sec + offset->tv_sec;
+    deadline.tv_nsec = start->tv_nsec + offset->tv_nsec;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    delay = (long long) (deadline.tv_sec - now.tv_sec) * 1000000 +
+            (deadline.tv_nsec - now.tv_nsec) / 1000;
+    if (delay > 0)
+        usleep(delay);
+}
+
+int gb_tape_replay(const char *pathname, bool timed)
+{
+    struct gb_tape_legacy_record_header legacy;
+    struct gb_tape_record_header hdr;
+    struct timespec start;
+    struct timespec first;
+    struct timespec offset;
+    bool has_first = false;
+    bool legacy_tape;
+    uint32_t magic;
+    char *buffer;
+    ssize_t nread;
+    int retval = 0;
+    int fd;
+
+    if (!pathname || !g_tape.mechanism)
+        return -EINVAL;
+
+    lowsyslog("greybus: replaying '%s'...\n", pathname);
+
+    fd = g_tape.mechanism->open(pathname, GB_TAPE_RDONLY);
+    if (fd < 0)
+        return fd;
+
+    buffer = malloc(CPORT_BUF_SIZE);
+    if (!buffer) {
+        retval = -ENOMEM;
+        goto error_buffer_alloc;
+    }
+
+    nread = g_tape.mechanism->read(fd, &magic, sizeof(magic));
+    if (!nread)
+        goto out;
+
+    if (nread != sizeof(magic)) {
+        gb_error("gb-tape: invalid byte count read, aborting...\n");
+        retval = -EIO;
+        goto out;
+    }
+
+    /* Legacy tapes start right away with a 4 bytes record header */
+    legacy_tape = magic != GB_TAPE_MAGIC;
+    if (legacy_tape) {
+        memcpy(&legacy, &magic, sizeof(legacy));
+        if (timed)
+            gb_warning("gb-tape: no timing information in '%s'\n", pathname);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (1) {
+        if (legacy_tape) {
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.size = legacy.size;
+            hdr.cport = legacy.cport;
+        } else {
+            nread = g_tape.mechanism->read(fd, &hdr, sizeof(hdr));
+            if (!nread)
+                break;
+
+            if (nread != sizeof(hdr)) {
+                gb_error("gb-tape: invalid byte count read, aborting...\n");
+                retval = -EIO;
+                break;
+            }
+        }
+
+        if (hdr.size > CPORT_BUF_SIZE) {
+            gb_error("gb-tape: invalid record size, aborting...\n");
+            retval = -EIO;
+            break;
+        }
+
+        nread = g_tape.mechanism->read(fd, buffer, hdr.size);
+        if (hdr.size != nread) {
+            gb_error("gb-tape: invalid byte count read, aborting...\n");
+            retval = -EIO;
+            break;
+        }
+
+        /* Only what the device received is replayed */
+        if (!(hdr.flags & GB_TAPE_RECORD_TX)) {
+            if (timed && !legacy_tape) {
+                if (!has_first) {
+                    first.tv_sec = hdr.sec;
+                    first.tv_nsec = hdr.nsec;
+                    has_first = true;
+                }
+
+                offset.tv_sec = hdr.sec - first.tv_sec;
+                offset.tv_nsec = (long) hdr.nsec - first.tv_nsec;
+                gb_tape_wait(&start, &offset);
+            }
+
+            greybus_rx_handler(hdr.cport, buffer, nread);
+        }
+
+        if (legacy_tape) {
+            nread = g_tape.mechanism->read(fd, &legacy, sizeof(legacy));
+            if (!nread)
+                break;
+
+            if (nread != sizeof(legacy)) {
+                gb_error("gb-tape: invalid byte count read, aborting...\n");
+                retval = -EIO;
+                break;
+            }
+        }
+    }
+
+out:
+    free(buffer);
+
+error_buffer_alloc:
+    g_tape.mechanism->close(fd);
+
+    return retval;
+}
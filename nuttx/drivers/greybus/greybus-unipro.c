@@ -33,6 +33,18 @@
 #include <nuttx/greybus/debug.h>
 #include <nuttx/greybus/greybus.h>
 
+#ifdef CONFIG_GREYBUS_ZERO_COPY_RX
+static int gb_unipro_rx_handler(unsigned int cport, void *data, size_t size)
+{
+    /* RX is unpaused once greybus gives the buffer back */
+    return greybus_rx_handler_zero_copy(cport, data, size);
+}
+
+static void gb_unipro_release_rx_buffer(unsigned int cport, void *data)
+{
+    unipro_unpause_rx(cport);
+}
+#else
 static int gb_unipro_rx_handler(unsigned int cport, void *data, size_t size)
 {
     int retval;
@@ -42,6 +54,7 @@ static int gb_unipro_rx_handler(unsigned int cport, void *data, size_t size)
 
     return retval;
 }
+#endif
 
 static struct unipro_driver greybus_driver = {
     .name = "greybus",
@@ -81,6 +94,9 @@ struct gb_transport_backend gb_unipro_backend = {
     .send = unipro_send,
     .listen = gb_unipro_listen,
     .stop_listening = gb_unipro_stop_listening,
+#ifdef CONFIG_GREYBUS_ZERO_COPY_RX
+    .release_rx_buffer = gb_unipro_release_rx_buffer,
+#endif
 };
 
 int gb_unipro_init(void)
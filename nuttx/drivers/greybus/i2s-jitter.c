@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/util.h>
+#include <nuttx/greybus/i2s.h>
+
+#include <limits.h>
+#include <string.h>
+
+/* Messages kept queued besides the one being played */
+#define GB_I2S_JITTER_LOW_WATER     2
+
+#ifndef CONFIG_GREYBUS_I2S_JITTER_ADJUST_INTERVAL
+#define CONFIG_GREYBUS_I2S_JITTER_ADJUST_INTERVAL   16
+#endif
+
+static void gb_i2s_jitter_update_target(struct gb_i2s_jitter *jb)
+{
+    unsigned int target;
+
+    /*
+     * The target is the lowest depth the buffer should reach before being
+     * refilled: enough to absorb one average deviation on top of the low
+     * water mark. Bursts are covered by the depth they bring in.
+     */
+    target = GB_I2S_JITTER_LOW_WATER + (jb->jitter16 + 15) / 16;
+
+    jb->target = MIN(MAX(target, jb->min_depth), jb->max_depth - 1);
+}
+
+/**
+ * @brief Initialize a jitter buffer
+ * @param jb jitter buffer
+ * @param period length of the audio carried by one message (usec)
+ * @param min_depth lowest target depth (messages)
+ * @param max_depth number of messages the buffer can hold
+ */
+void gb_i2s_jitter_init(struct gb_i2s_jitter *jb, uint32_t period,
+                        unsigned int min_depth, unsigned int max_depth)
+{
+    memset(jb, 0, sizeof(*jb));
+
+    jb->period = period;
+    jb->max_depth = max_depth;
+    jb->min_depth = MIN(MAX(min_depth, GB_I2S_JITTER_LOW_WATER), max_depth);
+    jb->adjust_interval = CONFIG_GREYBUS_I2S_JITTER_ADJUST_INTERVAL;
+    jb->window = jb->adjust_interval;
+    jb->low_depth = UINT_MAX;
+    jb->target = jb->min_depth;
+}
+
+/**
+ * @brief Account for a message received from the link
+ * @param jb jitter buffer
+ * @param depth number of messages queued before this one
+ * @return true if the message must be queued, false if it must be dropped
+ */
+bool gb_i2s_jitter_arrived(struct gb_i2s_jitter *jb, unsigned int depth)
+{
+    uint32_t elapsed;
+    unsigned int dev;
+
+    jb->stats.messages++;
+
+    if (jb->playing) {
+        /* One message is expected per period played */
+        elapsed = jb->played - jb->last_arrival;
+        dev = elapsed > 1 ? elapsed - 1 : 1 - elapsed;
+        jb->last_arrival = jb->played;
+
+        jb->jitter16 += dev - (jb->jitter16 + 8) / 16;
+        if (dev * 16 > jb->peak16)
+            jb->peak16 = dev * 16;
+        else
+            jb->peak16 -= jb->peak16 / 256;
+
+        gb_i2s_jitter_update_target(jb);
+    }
+
+    if (depth >= jb->max_depth) {
+        jb->stats.overruns++;
+        return false;
+    }
+
+    if (jb->compress) {
+        jb->compress = false;
+        jb->stats.compressions++;
+        return false;
+    }
+
+    jb->stats.depth = depth + 1;
+    if (jb->stats.depth > jb->stats.max_depth)
+        jb->stats.max_depth = jb->stats.depth;
+
+    return true;
+}
+
+/**
+ * @brief Check whether playback can start
+ * @param jb jitter buffer
+ * @param depth number of messages queued
+ * @return true once the buffer has been filled up to its target depth
+ */
+bool gb_i2s_jitter_ready(struct gb_i2s_jitter *jb, unsigned int depth)
+{
+    if (!jb->playing && depth >= jb->target) {
+        jb->playing = true;
+        jb->last_arrival = jb->played;
+    }
+
+    return jb->playing;
+}
+
+/**
+ * @brief Account for a message played
+ * @param jb jitter buffer
+ * @param depth number of messages still queued
+ * @return number of silence messages to queue
+ */
+unsigned int gb_i2s_jitter_played(struct gb_i2s_jitter *jb,
+                                  unsigned int depth)
+{
+    unsigned int low;
+
+    jb->played++;
+    jb->stats.depth = depth;
+
+    if (depth < jb->low_depth)
+        jb->low_depth = depth;
+
+    if (depth < GB_I2S_JITTER_LOW_WATER) {
+        jb->stats.underruns++;
+        return 1;
+    }
+
+    if (--jb->window)
+        return 0;
+
+    /*
+     * End of a window: move its lowest depth one step towards the target.
+     * The window spans at least two of the longest gaps seen, so that it
+     * always includes the bottom of a burst cycle.
+     */
+    low = jb->low_depth;
+    jb->low_depth = UINT_MAX;
+    jb->window = MAX(jb->adjust_interval, (jb->peak16 + 15) / 8);
+
+    if (low > jb->target) {
+        jb->compress = true;
+    } else if (low < jb->target) {
+        jb->stats.expansions++;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get the counters of a jitter buffer
+ * @param jb jitter buffer
+ * @param stats counters, with the jitter and latency in microseconds
+ */
+void gb_i2s_jitter_get_stats(struct gb_i2s_jitter *jb,
+                             struct gb_i2s_jitter_stats *stats)
+{
+    *stats = jb->stats;
+
+    stats->jitter = (jb->jitter16 * jb->period) / 16;
+    stats->peak_jitter = (jb->peak16 * jb->period) / 16;
+    stats->target = jb->target;
+    stats->latency = stats->depth * jb->period;
+    stats->max_latency = stats->max_depth * jb->period;
+}
+
+/**
+ * @brief Reset the counters of a jitter buffer
+ *
+ * The jitter estimate and the target depth are kept.
+ *
+ * @param jb jitter buffer
+ */
+void gb_i2s_jitter_reset_stats(struct gb_i2s_jitter *jb)
+{
+    uint32_t depth = jb->stats.depth;
+
+    memset(&jb->stats, 0, sizeof(jb->stats));
+    jb->stats.depth = depth;
+    jb->stats.max_depth = depth;
+}
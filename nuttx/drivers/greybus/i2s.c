@@ -65,6 +65,7 @@
 #include <nuttx/wdog.h>
 #include <nuttx/greybus/types.h>
 #include <nuttx/greybus/greybus.h>
+#include <nuttx/greybus/i2s.h>
 
 #include <arch/byteorder.h>
 #include <arch/tsb/unipro.h>
@@ -79,7 +80,19 @@
 #define GB_I2S_BUNDLE_0_ID              0
 #define GB_I2S_BUNDLE_0_DEV_ID          0
 
+#ifdef CONFIG_GREYBUS_I2S_SAMPLES_PER_MSG
+#define GB_I2S_SAMPLES_PER_MSG_DEFAULT  CONFIG_GREYBUS_I2S_SAMPLES_PER_MSG
+#else
 #define GB_I2S_SAMPLES_PER_MSG_DEFAULT  1
+#endif
+
+#ifndef CONFIG_GREYBUS_I2S_JITTER_MIN_DEPTH
+#define CONFIG_GREYBUS_I2S_JITTER_MIN_DEPTH     2
+#endif
+
+#ifndef CONFIG_GREYBUS_I2S_JITTER_MAX_DEPTH
+#define CONFIG_GREYBUS_I2S_JITTER_MAX_DEPTH     32
+#endif
 
 #define GB_I2S_TX_SEND_DOWNSTREAM       8
 #define GB_I2S_TX_TIMER_FUDGE_NS        (5 * 1000)
@@ -137,6 +150,7 @@ struct gb_i2s_info { /* One per I2S Bundle */
     struct list_head    cport_list;
     struct ring_buf     *rx_rb;
     uint32_t            rx_rb_count;
+    struct gb_i2s_jitter rx_jb;
     struct ring_buf     *tx_rb;
     sem_t               active_cports_lock;
     sem_t               tx_rb_sem;
@@ -274,13 +288,15 @@ static void gb_i2s_ll_tx_cb(struct ring_buf *rb,
 {
     struct gb_i2s_info *info = arg;
     uint32_t gb_event = 0;
+    unsigned int silence;
 
     switch (event) {
     case DEVICE_I2S_EVENT_TX_COMPLETE:
         info->rx_rb_count--;
 
-        /* TODO: Replace with smarter underrun prevention */
-        if (info->rx_rb_count < 2)
+        /* Play silence when running dry or growing the jitter buffer */
+        silence = gb_i2s_jitter_played(&info->rx_jb, info->rx_rb_count);
+        while (silence-- && ring_buf_is_producers(info->rx_rb))
             gb_i2s_ll_tx(info, info->dummy_data);
 
         break;
@@ -313,6 +329,7 @@ static void gb_i2s_ll_tx_cb(struct ring_buf *rb,
 static int gb_i2s_prepare_receiver(struct gb_i2s_info *info)
 {
     unsigned int entries;
+    uint32_t period;
     int ret;
 
     if (info->flags & GB_I2S_FLAG_RX_PREPARED)
@@ -320,8 +337,16 @@ static int gb_i2s_prepare_receiver(struct gb_i2s_info *info)
 
     /* (sample_freq / samples_per_msg) * (delay_in_us / 1,000,000) */
     entries = ((info->sample_frequency * info->delay) /
-               (info->samples_per_message * 1000000)) +
-               GB_I2S_RX_RING_BUF_PAD;
+               (info->samples_per_message * 1000000));
+
+    /* Leave room for the jitter buffer to grow */
+    entries = MAX(entries, CONFIG_GREYBUS_I2S_JITTER_MAX_DEPTH) +
+              GB_I2S_RX_RING_BUF_PAD;
+
+    period = ((uint64_t) info->samples_per_message * 1000000) /
+             info->sample_frequency;
+    gb_i2s_jitter_init(&info->rx_jb, period,
+                       CONFIG_GREYBUS_I2S_JITTER_MIN_DEPTH, entries - 1);
 
     info->rx_rb = ring_buf_alloc_ring(entries,
                                       sizeof(struct gb_operation_hdr) +
@@ -383,8 +408,21 @@ static uint8_t gb_i2s_receiver_send_data_req_handler(
            (le32_to_cpu(request->sample_number) > info->next_rx_sample))
         gb_i2s_ll_tx(info, info->dummy_data);
 
+    if (!gb_i2s_jitter_arrived(&info->rx_jb, info->rx_rb_count)) {
+        /* Dropped to shrink the jitter buffer, or no room left for it */
+        info->next_rx_sample += info->samples_per_message;
+        irqrestore(flags);
+        goto err_exit;
+    }
+
     gb_i2s_ll_tx(info, request->data);
 
+    /* Hold playback back until the jitter buffer is filled */
+    if (!gb_i2s_jitter_ready(&info->rx_jb, info->rx_rb_count)) {
+        irqrestore(flags);
+        goto err_exit;
+    }
+
     irqrestore(flags);
 
     ret = device_i2s_start_transmitter(info->dev);
@@ -840,6 +878,7 @@ static uint8_t gb_i2s_set_samples_per_message_req_handler(
     struct gb_i2s_set_samples_per_message_request *request =
                 gb_operation_get_request_payload(operation);
     struct gb_i2s_info *info;
+    uint16_t samples_per_message;
 
     info = gb_i2s_get_info(operation->cport);
     if (!info)
@@ -848,7 +887,19 @@ static uint8_t gb_i2s_set_samples_per_message_req_handler(
     if ((info->active_tx_cports + info->active_rx_cports) > 0)
         return GB_OP_PROTOCOL_BAD;
 
-    info->samples_per_message = le16_to_cpu(request->samples_per_message);
+    samples_per_message = le16_to_cpu(request->samples_per_message);
+    if (!samples_per_message)
+        return GB_OP_INVALID;
+
+    /* A Send Data request must fit in a single UniPro message */
+    if ((info->flags & GB_I2S_FLAG_CONFIGURED) &&
+        (sizeof(struct gb_operation_hdr) +
+         sizeof(struct gb_i2s_send_data_request) +
+         info->sample_size * samples_per_message > CPORT_BUF_SIZE)) {
+        return GB_OP_INVALID;
+    }
+
+    info->samples_per_message = samples_per_message;
 
     return GB_OP_SUCCESS;
 }
@@ -954,6 +1005,12 @@ static uint8_t gb_i2s_activate_cport_req_handler(struct gb_operation *operation)
     if ((info->active_tx_cports + info->active_rx_cports) == 0) {
         info->msg_data_size = info->sample_size * info->samples_per_message;
 
+        /* The configuration may have changed since Set Samples per Message */
+        if (sizeof(struct gb_operation_hdr) +
+            sizeof(struct gb_i2s_send_data_request) +
+            info->msg_data_size > CPORT_BUF_SIZE)
+            return GB_OP_INVALID;
+
         info->dummy_data = zalloc(info->msg_data_size);
         if (!info->dummy_data)
             return GB_OP_NO_MEMORY;
@@ -1060,6 +1117,49 @@ static uint8_t gb_i2s_deactivate_cport_req_handler(
     return gb_i2s_errno2gb(ret);
 }
 
+/**
+ * @brief Get the receive jitter buffer counters of an I2S bundle
+ * @param bundle_id I2S bundle
+ * @param stats counters
+ * @return 0 on success, -ENODEV if the bundle is not initialized
+ */
+int gb_i2s_get_rx_stats(uint16_t bundle_id, struct gb_i2s_jitter_stats *stats)
+{
+    struct gb_i2s_dev_info *dev_info;
+    irqstate_t flags;
+
+    dev_info = gb_i2s_get_dev_info(bundle_id);
+    if (!dev_info || !dev_info->info)
+        return -ENODEV;
+
+    flags = irqsave();
+    gb_i2s_jitter_get_stats(&dev_info->info->rx_jb, stats);
+    irqrestore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief Reset the receive jitter buffer counters of an I2S bundle
+ * @param bundle_id I2S bundle
+ * @return 0 on success, -ENODEV if the bundle is not initialized
+ */
+int gb_i2s_reset_rx_stats(uint16_t bundle_id)
+{
+    struct gb_i2s_dev_info *dev_info;
+    irqstate_t flags;
+
+    dev_info = gb_i2s_get_dev_info(bundle_id);
+    if (!dev_info || !dev_info->info)
+        return -ENODEV;
+
+    flags = irqsave();
+    gb_i2s_jitter_reset_stats(&dev_info->info->rx_jb);
+    irqrestore(flags);
+
+    return 0;
+}
+
 /* TODO: Fix rx or tx init/exit called before/after mgmt init/exit */
 static int gb_i2s_mgmt_init(unsigned int cport)
 {
@@ -1250,6 +1350,7 @@ static struct gb_driver i2s_receiver_driver = {
     .exit               = gb_i2s_receiver_exit,
     .op_handlers        = gb_i2s_receiver_handlers,
     .op_handlers_count  = ARRAY_SIZE(gb_i2s_receiver_handlers),
+    .zero_copy_rx       = true,
 };
 
 void gb_i2s_receiver_register(int cport)
@@ -29,6 +29,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "loopback-gb.h"
 
@@ -47,6 +48,9 @@ struct gb_loopback {
     int cport;
     int err;
     unsigned recv;
+    unsigned outstanding;
+    gb_loopback_resp_cb resp_cb;
+    void *resp_data;
 };
 
 struct list_head gb_loopback_list = LIST_INIT(gb_loopback_list);
@@ -133,17 +137,6 @@ int gb_loopback_get_error_count(int cport)
     return err;
 }
 
-static void loopback_error_notify(int cport)
-{
-    struct gb_loopback *loopback = loopback_from_cport(cport);
-
-    if (loopback != NULL) {
-        loopback_lock(loopback);
-        loopback->err++;
-        loopback_unlock(loopback);
-    }
-}
-
 /**
  * @brief Get the number of received responses on given cport
  * @param cport cport number
@@ -163,41 +156,112 @@ unsigned gb_loopback_get_recv_count(int cport)
     return recv;
 }
 
-static void loopback_recv_inc(int cport)
+/**
+ * @brief Reset statistics acquisition for given cport.
+ * @param cport cport number
+ */
+void gb_loopback_reset(int cport)
 {
     struct gb_loopback *loopback = loopback_from_cport(cport);
 
     if (loopback != NULL) {
         loopback_lock(loopback);
-        loopback->recv++;
+        loopback->err = 0;
+        loopback->recv = 0;
+        loopback->outstanding = 0;
         loopback_unlock(loopback);
     }
 }
 
 /**
- * @brief Reset statistics acquisition for given cport.
+ * @brief Check if given cport has been registered in the loopback driver
  * @param cport cport number
+ * @return 1 if there's a loopback instance for this cport, 0 otherwise
  */
-void gb_loopback_reset(int cport)
+int gb_loopback_cport_valid(int cport)
+{
+    return loopback_from_cport(cport) != NULL;
+}
+
+/**
+ * @brief Get the number of requests still waiting for a response
+ * @param cport cport number
+ * @return Number of requests sent and not yet completed or timed out
+ */
+unsigned gb_loopback_get_outstanding(int cport)
 {
     struct gb_loopback *loopback = loopback_from_cport(cport);
+    unsigned outstanding = 0;
 
     if (loopback != NULL) {
         loopback_lock(loopback);
-        loopback->err = 0;
-        loopback->recv = 0;
+        outstanding = loopback->outstanding;
         loopback_unlock(loopback);
     }
+
+    return outstanding;
 }
 
 /**
- * @brief Check if given cport has been registered in the loopback driver
+ * @brief Set the function called on completion of each request of a cport
+ *
+ * The callback is called from the greybus worker of the cport, once per
+ * request sent with gb_loopback_send_req(), whether the request succeeded,
+ * failed or timed out. It must not block.
+ *
  * @param cport cport number
- * @return 1 if there's a loopback instance for this cport, 0 otherwise
+ * @param cb completion callback, NULL to remove it
+ * @param data additional private data to be passed to cb
+ * @return 0 on success, -EINVAL if the cport is not a loopback cport
  */
-int gb_loopback_cport_valid(int cport)
+int gb_loopback_set_resp_cb(int cport, gb_loopback_resp_cb cb, void *data)
 {
-    return loopback_from_cport(cport) != NULL;
+    struct gb_loopback *loopback = loopback_from_cport(cport);
+
+    if (loopback == NULL)
+        return -EINVAL;
+
+    loopback_lock(loopback);
+    loopback->resp_cb = cb;
+    loopback->resp_data = data;
+    loopback_unlock(loopback);
+
+    return 0;
+}
+
+static uint32_t loopback_rtt_usec(struct gb_operation *operation)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - operation->time.tv_sec) * 1000000 +
+           (now.tv_nsec - operation->time.tv_nsec) / 1000;
+}
+
+static void loopback_complete(struct gb_operation *operation, int status)
+{
+    struct gb_loopback *loopback = loopback_from_cport(operation->cport);
+    uint32_t rtt = loopback_rtt_usec(operation);
+    gb_loopback_resp_cb cb;
+    void *data;
+
+    if (loopback == NULL)
+        return;
+
+    loopback_lock(loopback);
+    if (status != OK)
+        loopback->err++;
+    else
+        loopback->recv++;
+    if (loopback->outstanding > 0)
+        loopback->outstanding--;
+    cb = loopback->resp_cb;
+    data = loopback->resp_data;
+    loopback_unlock(loopback);
+
+    if (cb)
+        cb(operation->cport, status, rtt, data);
 }
 
 /* Callbacks for gb_operation_send_request(). */
@@ -207,10 +271,7 @@ static void gb_loopback_ping_sink_resp_cb(struct gb_operation *operation)
     int ret;
 
     ret = gb_operation_get_request_result(operation);
-    if (ret != OK)
-        loopback_error_notify(operation->cport);
-    else
-        loopback_recv_inc(operation->cport);
+    loopback_complete(operation, ret == GB_OP_SUCCESS ? OK : -EIO);
 }
 
 static void gb_loopback_transfer_resp_cb(struct gb_operation *operation)
@@ -218,13 +279,28 @@ static void gb_loopback_transfer_resp_cb(struct gb_operation *operation)
     struct gb_loopback_transfer_response *response;
     struct gb_loopback_transfer_request *request;
 
+    if (gb_operation_get_request_result(operation) != GB_OP_SUCCESS) {
+        loopback_complete(operation, -EIO);
+        return;
+    }
+
     request = gb_operation_get_request_payload(operation);
     response = gb_operation_get_request_payload(operation->response);
 
     if (memcmp(request->data, response->data, le32_to_cpu(request->len)))
-        loopback_error_notify(operation->cport);
+        loopback_complete(operation, -EIO);
     else
-        loopback_recv_inc(operation->cport);
+        loopback_complete(operation, OK);
+}
+
+/**
+ * @brief Get the largest payload a transfer or sink request can carry
+ * @return Maximum value of the size argument of gb_loopback_send_req()
+ */
+size_t gb_loopback_get_max_size(void)
+{
+    return CPORT_BUF_SIZE - sizeof(struct gb_operation_hdr) -
+           sizeof(struct gb_loopback_transfer_request);
 }
 
 /**
@@ -236,6 +312,7 @@ static void gb_loopback_transfer_resp_cb(struct gb_operation *operation)
  */
 int gb_loopback_send_req(int cport, size_t size, uint8_t type)
 {
+    struct gb_loopback *loopback = loopback_from_cport(cport);
     struct gb_loopback_transfer_request *request;
     struct gb_operation *operation;
     int i, status, retval = OK;
@@ -255,6 +332,13 @@ int gb_loopback_send_req(int cport, size_t size, uint8_t type)
     if (!operation)
         return -ENOMEM;
 
+    /* The response can come back before gb_operation_send_request() returns */
+    if (loopback != NULL) {
+        loopback_lock(loopback);
+        loopback->outstanding++;
+        loopback_unlock(loopback);
+    }
+
     switch(type) {
     case GB_LOOPBACK_TYPE_PING:
         status = gb_operation_send_request(operation,
@@ -287,8 +371,14 @@ int gb_loopback_send_req(int cport, size_t size, uint8_t type)
 
     }
 
-    if (status != OK)
+    if (status != OK) {
+        if (loopback != NULL) {
+            loopback_lock(loopback);
+            loopback->outstanding--;
+            loopback_unlock(loopback);
+        }
         retval = ERROR;
+    }
 
     gb_operation_destroy(operation);
     return retval;
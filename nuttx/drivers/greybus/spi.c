@@ -353,6 +353,7 @@ static struct gb_driver gb_spi_driver = {
     .exit = gb_spi_exit,
     .op_handlers = gb_spi_handlers,
     .op_handlers_count = ARRAY_SIZE(gb_spi_handlers),
+    .zero_copy_rx = true,
 };
 
 /**
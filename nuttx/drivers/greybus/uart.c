@@ -32,6 +32,7 @@
 #include <queue.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <nuttx/device.h>
 #include <nuttx/device_uart.h>
@@ -39,6 +40,7 @@
 #include <nuttx/config.h>
 #include <nuttx/greybus/types.h>
 #include <nuttx/greybus/greybus.h>
+#include <nuttx/greybus/uart.h>
 #include <arch/tsb/unipro.h>
 #include <apps/greybus-utils/utils.h>
 #include <arch/byteorder.h>
@@ -48,9 +50,22 @@
 #define GB_UART_VERSION_MAJOR   0
 #define GB_UART_VERSION_MINOR   1
 
+#ifndef CONFIG_GREYBUS_UART_RX_BUFFERS
+#define CONFIG_GREYBUS_UART_RX_BUFFERS      5
+#endif
+
+#ifndef CONFIG_GREYBUS_UART_RX_BUF_SIZE
+#define CONFIG_GREYBUS_UART_RX_BUF_SIZE     256
+#endif
+
+#ifndef CONFIG_GREYBUS_UART_RX_FLUSH_USEC
+#define CONFIG_GREYBUS_UART_RX_FLUSH_USEC   0
+#endif
+
 /* Reserved operations for rx data buffer. */
-#define MAX_RX_OPERATION        5
-#define MAX_RX_BUF_SIZE         256
+#define MAX_RX_OPERATION        CONFIG_GREYBUS_UART_RX_BUFFERS
+#define MAX_RX_BUF_SIZE         CONFIG_GREYBUS_UART_RX_BUF_SIZE
+#define RX_FLUSH_USEC           CONFIG_GREYBUS_UART_RX_FLUSH_USEC
 
 /* The id of error in protocol operating. */
 #define GB_UART_EVENT_PROTOCOL_ERROR    1
@@ -68,6 +83,8 @@ struct op_node {
     uint16_t            *data_size;
     /** pointer to buffer of request in operation */
     uint8_t             *buffer;
+    /** when the data was received */
+    struct timespec     time;
 };
 
 /**
@@ -110,6 +127,8 @@ struct gb_uart_info {
     int                 thread_stop;
     /** uart driver handle */
     struct device   *dev;
+    /** receive statistics */
+    struct gb_uart_rx_stats rx_stats;
 };
 
 /* The structure for keeping protocol global data. */
@@ -295,6 +314,12 @@ static void uart_rx_callback(uint8_t *buffer, int length, int error)
     struct op_node *node;
     int ret;
 
+    info->rx_stats.chunks++;
+    if (error & LSR_OE) {
+        info->rx_stats.overruns++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &info->rx_node->time);
     *info->rx_node->data_size = cpu_to_le16(length);
     put_node_back(&info->data_queue, info->rx_node);
 
@@ -304,15 +329,17 @@ static void uart_rx_callback(uint8_t *buffer, int length, int error)
          * there is no free buffer, inform the rx thread to engage another uart
          * receiver.
          */
+        info->rx_stats.starved++;
+        info->rx_node = NULL;
         info->require_node = 1;
-        return;
-    }
-
-    info->rx_node = node;
-    ret = device_uart_start_receiver(info->dev, node->buffer, info->rx_buf_size,
-                                     NULL, NULL, uart_rx_callback);
-    if (ret) {
-        uart_report_error(GB_UART_EVENT_PROTOCOL_ERROR, __func__);
+    } else {
+        info->rx_node = node;
+        ret = device_uart_start_receiver(info->dev, node->buffer,
+                                         info->rx_buf_size, NULL, NULL,
+                                         uart_rx_callback);
+        if (ret) {
+            uart_report_error(GB_UART_EVENT_PROTOCOL_ERROR, __func__);
+        }
     }
 
     sem_post(&info->rx_sem);
@@ -399,6 +426,108 @@ static void *uart_status_thread(void *data)
     return NULL;
 }
 
+/**
+ * @brief Restart the receiver if it was left without a buffer
+ *
+ * @return None.
+ */
+static void uart_rx_restart(void)
+{
+    struct op_node *node = NULL;
+    irqstate_t flags;
+    int ret;
+
+    flags = irqsave();
+    if (info->require_node) {
+        node = get_node_from(&info->free_queue);
+        if (node) {
+            info->rx_node = node;
+            info->require_node = 0;
+        }
+    }
+    irqrestore(flags);
+
+    if (!node) {
+        return;
+    }
+
+    ret = device_uart_start_receiver(info->dev, node->buffer,
+                                     info->rx_buf_size, NULL, NULL,
+                                     uart_rx_callback);
+    if (ret) {
+        uart_report_error(GB_UART_EVENT_DEVICE_ERROR, __func__);
+    }
+}
+
+/**
+ * @brief Send received data to the peer
+ *
+ * Sends the Receive Data request of the node and gives the node back to the
+ * receiver.
+ *
+ * @param node The node holding the received data.
+ * @return None.
+ */
+static void uart_rx_send(struct op_node *node)
+{
+    struct timespec now;
+    uint32_t latency;
+    int ret;
+
+    ret = gb_operation_send_request(node->operation, NULL, false);
+    if (ret) {
+        info->rx_stats.send_errors++;
+        uart_report_error(GB_UART_EVENT_PROTOCOL_ERROR, __func__);
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        latency = (now.tv_sec - node->time.tv_sec) * 1000000 +
+                  (now.tv_nsec - node->time.tv_nsec) / 1000;
+
+        info->rx_stats.requests++;
+        info->rx_stats.bytes += le16_to_cpu(*node->data_size);
+        info->rx_stats.total_latency += latency;
+        if (latency > info->rx_stats.max_latency) {
+            info->rx_stats.max_latency = latency;
+        }
+    }
+
+    put_node_back(&info->free_queue, node);
+    uart_rx_restart();
+}
+
+/**
+ * @brief Check whether a partially filled node must be sent now
+ *
+ * @param node The node holding the received data.
+ * @param abstime Filled with the time at which the node must be sent.
+ * @return true if the node has been held for long enough.
+ */
+static bool uart_rx_flush_due(struct op_node *node, struct timespec *abstime)
+{
+    struct timespec now;
+    uint32_t age;
+
+    if (RX_FLUSH_USEC == 0 ||
+        le16_to_cpu(*node->data_size) == info->rx_buf_size) {
+        return true;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    age = (now.tv_sec - node->time.tv_sec) * 1000000 +
+          (now.tv_nsec - node->time.tv_nsec) / 1000;
+    if (age >= RX_FLUSH_USEC) {
+        return true;
+    }
+
+    /* sem_timedwait() takes a CLOCK_REALTIME deadline */
+    clock_gettime(CLOCK_REALTIME, abstime);
+    abstime->tv_nsec += (RX_FLUSH_USEC - age) * 1000;
+    abstime->tv_sec += abstime->tv_nsec / 1000000000;
+    abstime->tv_nsec %= 1000000000;
+
+    return false;
+}
+
 /**
  * @brief Data receiving process thread
  *
@@ -407,49 +536,109 @@ static void *uart_status_thread(void *data)
  * If protocol is running out of operation, once it gets a free operation,
  * it passes to driver for continuing the receiving.
  *
+ * Short chunks, which the UART reports on character timeout, are appended to
+ * a pending node as long as they fit and the first byte of the node was
+ * received less than RX_FLUSH_USEC ago. This keeps the number of requests
+ * low at high rates without delaying the data for long at low rates.
+ *
  * @param data The regular thread data.
  * @return None.
  */
 static void *uart_rx_thread(void *data)
 {
+    struct op_node *pending = NULL;
     struct op_node *node = NULL;
-    int ret;
+    struct timespec abstime;
+    uint16_t pending_size, size;
 
     while (1) {
-        sem_wait(&info->rx_sem);
+        if (pending) {
+            sem_timedwait(&info->rx_sem, &abstime);
+        } else {
+            sem_wait(&info->rx_sem);
+        }
 
         if (info->thread_stop) {
             break;
         }
 
-        node = get_node_from(&info->data_queue);
-        if (node) {
-            ret = gb_operation_send_request(node->operation, NULL, false);
-            if (ret) {
-                uart_report_error(GB_UART_EVENT_PROTOCOL_ERROR, __func__);
+        while ((node = get_node_from(&info->data_queue))) {
+            if (!pending) {
+                pending = node;
+                continue;
             }
+
+            pending_size = le16_to_cpu(*pending->data_size);
+            size = le16_to_cpu(*node->data_size);
+            if (pending_size + size > info->rx_buf_size) {
+                uart_rx_send(pending);
+                pending = node;
+                continue;
+            }
+
+            memcpy(pending->buffer + pending_size, node->buffer, size);
+            *pending->data_size = cpu_to_le16(pending_size + size);
             put_node_back(&info->free_queue, node);
+            uart_rx_restart();
         }
 
         /*
          * In case there is no free node in callback.
          */
-        if (info->require_node) {
-            node = get_node_from(&info->free_queue);
-            info->rx_node = node;
-            ret = device_uart_start_receiver(info->dev, node->buffer,
-                                             info->rx_buf_size, NULL, NULL,
-                                             uart_rx_callback);
-            if (ret) {
-                uart_report_error(GB_UART_EVENT_DEVICE_ERROR, __func__);
-            }
-            info->require_node = 0;
+        uart_rx_restart();
+
+        if (pending && uart_rx_flush_due(pending, &abstime)) {
+            uart_rx_send(pending);
+            pending = NULL;
         }
     }
 
+    if (pending) {
+        put_node_back(&info->free_queue, pending);
+    }
+
     return NULL;
 }
 
+/**
+ * @brief Get the receive statistics of the UART protocol
+ *
+ * @param stats Filled with the statistics.
+ * @return 0 on success, -ENODEV if the protocol is not initialized.
+ */
+int gb_uart_get_rx_stats(struct gb_uart_rx_stats *stats)
+{
+    irqstate_t flags;
+
+    if (!info) {
+        return -ENODEV;
+    }
+
+    flags = irqsave();
+    memcpy(stats, &info->rx_stats, sizeof(*stats));
+    irqrestore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief Reset the receive statistics of the UART protocol
+ *
+ * @return None.
+ */
+void gb_uart_reset_rx_stats(void)
+{
+    irqstate_t flags;
+
+    if (!info) {
+        return;
+    }
+
+    flags = irqsave();
+    memset(&info->rx_stats, 0, sizeof(info->rx_stats));
+    irqrestore(flags);
+}
+
 /**
  * @brief Releases resources for status change thread
  *
@@ -844,6 +1033,7 @@ err_status_cb_deinit:
     uart_status_cb_deinit();
 err_free_info:
     free(info);
+    info = NULL;
 
     return ret;
 }
@@ -869,6 +1059,7 @@ static void gb_uart_exit(unsigned int cport)
     uart_status_cb_deinit();
 
     free(info);
+    info = NULL;
 }
 
 static struct gb_operation_handler gb_uart_handlers[] = {
@@ -885,6 +1076,7 @@ struct gb_driver uart_driver = {
     .exit = gb_uart_exit,
     .op_handlers = (struct gb_operation_handler*) gb_uart_handlers,
     .op_handlers_count = ARRAY_SIZE(gb_uart_handlers),
+    .zero_copy_rx = true,
 };
 
 /**
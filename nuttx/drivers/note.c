@@ -0,0 +1,235 @@
+/****************************************************************************
+ * drivers/note.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/sched_note.h>
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Each open file first returns a NOTE_INFO note and a NOTE_TASK note for
+ * each task that exists when it is opened, so that the notes can be
+ * interpreted even if the tasks were started before the oldest note.
+ */
+
+struct note_file_s
+{
+  size_t  nf_length;   /* Number of bytes in nf_prelude */
+  size_t  nf_offset;   /* Number of bytes of nf_prelude already read */
+  uint8_t nf_prelude[sizeof(struct note_info_s) +
+                     CONFIG_MAX_TASKS * sizeof(struct note_start_s)];
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     note_open(FAR struct file *filep);
+static int     note_close(FAR struct file *filep);
+static ssize_t note_read(FAR struct file *filep, FAR char *buffer,
+                         size_t buflen);
+static ssize_t note_write(FAR struct file *filep, FAR const char *buffer,
+                          size_t buflen);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct file_operations note_fops =
+{
+  note_open,     /* open */
+  note_close,    /* close */
+  note_read,     /* read */
+  note_write,    /* write */
+  0,             /* seek */
+  0              /* ioctl */
+#ifndef CONFIG_DISABLE_POLL
+  , 0            /* poll */
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: note_describe
+ *
+ * Description:
+ *   sched_foreach() callback adding the NOTE_TASK note of a task to the
+ *   prelude.
+ *
+ ****************************************************************************/
+
+static void note_describe(FAR struct tcb_s *tcb, FAR void *arg)
+{
+  FAR struct note_file_s *file = arg;
+  FAR struct note_start_s *note;
+  size_t namelen = 0;
+
+  if (file->nf_length + sizeof(struct note_start_s) >
+      sizeof(file->nf_prelude))
+    {
+      return;
+    }
+
+  note = (FAR struct note_start_s *)&file->nf_prelude[file->nf_length];
+
+#if CONFIG_TASK_NAME_SIZE > 0
+  namelen = strnlen(tcb->name, CONFIG_TASK_NAME_SIZE);
+  memcpy(note->nst_name, tcb->name, namelen);
+#endif
+
+  sched_note_common(&note->nst_cmn, SIZEOF_NOTE_START(namelen), NOTE_TASK,
+                    tcb->pid);
+  note->nst_priority = tcb->sched_priority;
+
+  file->nf_length += SIZEOF_NOTE_START(namelen);
+}
+
+/****************************************************************************
+ * Name: note_open
+ ****************************************************************************/
+
+static int note_open(FAR struct file *filep)
+{
+  FAR struct note_file_s *file;
+  FAR struct note_info_s *info;
+  uint32_t freq;
+
+  file = (FAR struct note_file_s *)kmm_malloc(sizeof(struct note_file_s));
+  if (!file)
+    {
+      return -ENOMEM;
+    }
+
+  info = (FAR struct note_info_s *)file->nf_prelude;
+  freq = sched_note_getfreq();
+
+  sched_note_common(&info->ni_cmn, sizeof(struct note_info_s), NOTE_INFO, 0);
+  info->ni_freq[0] = (uint8_t)freq;
+  info->ni_freq[1] = (uint8_t)(freq >> 8);
+  info->ni_freq[2] = (uint8_t)(freq >> 16);
+  info->ni_freq[3] = (uint8_t)(freq >> 24);
+
+  file->nf_length = sizeof(struct note_info_s);
+  file->nf_offset = 0;
+  sched_foreach(note_describe, file);
+
+  filep->f_priv = file;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: note_close
+ ****************************************************************************/
+
+static int note_close(FAR struct file *filep)
+{
+  kmm_free(filep->f_priv);
+  filep->f_priv = NULL;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: note_read
+ *
+ * Description:
+ *   Return the prelude, then the notes recorded since the last read.
+ *   Returns zero (end of file) when there is no more note, so that the
+ *   notes can be saved with a simple copy.
+ *
+ ****************************************************************************/
+
+static ssize_t note_read(FAR struct file *filep, FAR char *buffer,
+                         size_t buflen)
+{
+  FAR struct note_file_s *file = filep->f_priv;
+  size_t count = 0;
+
+  if (file->nf_offset < file->nf_length)
+    {
+      count = file->nf_length - file->nf_offset;
+      if (count > buflen)
+        {
+          count = buflen;
+        }
+
+      memcpy(buffer, &file->nf_prelude[file->nf_offset], count);
+      file->nf_offset += count;
+    }
+
+  return count + sched_note_get((FAR uint8_t *)buffer + count,
+                                buflen - count);
+}
+
+/****************************************************************************
+ * Name: note_write
+ ****************************************************************************/
+
+static ssize_t note_write(FAR struct file *filep, FAR const char *buffer,
+                          size_t buflen)
+{
+  sched_note_mark(buffer, buflen);
+  return buflen;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: note_register
+ *
+ * Description:
+ *   Register /dev/note
+ *
+ ****************************************************************************/
+
+void note_register(void)
+{
+  (void)register_driver("/dev/note", &note_fops, 0666, NULL);
+}
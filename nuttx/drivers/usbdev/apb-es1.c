@@ -121,7 +121,11 @@
 #define BULKEP_TO_N(ep) \
   ((USB_EPNO(ep->eplog) - CONFIG_APBRIDGE_EPBULKOUT) >> 1)
 
+#ifdef CONFIG_APBRIDGE_NREQS
+#define APBRIDGE_NREQS               CONFIG_APBRIDGE_NREQS
+#else
 #define APBRIDGE_NREQS               (1)
+#endif
 #define APBRIDGE_REQ_SIZE            (2048)
 
 #define APBRIDGE_CONFIG_ATTR \
@@ -189,6 +193,7 @@ struct apbridge_req_s {
     struct list_head list;
     struct usbdev_req_s *req;   /* The contained request */
     void *priv;
+    struct list_head throttled; /* Bulk OUT request waiting for UniPro */
 };
 
 struct apbridge_msg_s {
@@ -215,6 +220,9 @@ struct apbridge_dev_s {
 
     struct list_head msg_queue;
 
+    /* Bulk OUT requests the CPorts could not take yet, oldest first */
+    struct list_head throttled;
+
     int cport_to_epin_n[CPORT_MAX];
     int epout_to_cport_n[APBRIDGE_NBULKS];
 
@@ -492,36 +500,53 @@ static int apbridge_queue(struct apbridge_dev_s *priv, struct usbdev_ep_s *ep,
     return OK;
 }
 
-static struct apbridge_msg_s *apbridge_dequeue(struct apbridge_dev_s *priv)
+/*
+ * Dequeue the oldest message that can be sent with a request from the
+ * given request list.
+ */
+static struct apbridge_msg_s *apbridge_dequeue(struct apbridge_dev_s *priv,
+                                               struct list_head *reqlist)
 {
     irqstate_t flags;
-    struct list_head *list;
+    struct list_head *iter;
+    struct apbridge_msg_s *info;
 
     flags = irqsave();
-    if (list_is_empty(&priv->msg_queue)) {
-        irqrestore(flags);
-        return NULL;
+    list_foreach(&priv->msg_queue, iter) {
+        info = list_entry(iter, struct apbridge_msg_s, list);
+        if (epno_to_req_list(priv, USB_EPNO(info->ep->eplog)) == reqlist) {
+            list_del(iter);
+            irqrestore(flags);
+            return info;
+        }
     }
-
-    list = priv->msg_queue.next;
-    list_del(list);
     irqrestore(flags);
-    return list_entry(list, struct apbridge_msg_s, list);
+
+    return NULL;
 }
 
 static int _to_usb_submit(struct usbdev_ep_s *ep, struct usbdev_req_s *req,
                           const void *payload, size_t len)
 {
     int ret;
-    unsigned int cportid;
 
     req->len = len;
-    memcpy(req->buf, payload, len);
 
-    /* Unpause unipro only if the request come from unipro */
-    if (USB_EPNO(ep->eplog) != CONFIG_APBRIDGE_EPINTIN) {
-        cportid = get_cportid(payload);
-        unipro_unpause_rx(cportid);
+    if (USB_EPNO(ep->eplog) == CONFIG_APBRIDGE_EPINTIN) {
+        memcpy(req->buf, payload, len);
+    } else {
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+        /*
+         * Send the CPort RX buffer as is: the CPort stays paused until
+         * usbclass_wrcomplete() gives the buffer back.
+         */
+        req->buf = (uint8_t *) payload;
+#else
+        memcpy(req->buf, payload, len);
+
+        /* Unpause unipro only if the request come from unipro */
+        unipro_unpause_rx(get_cportid(payload));
+#endif
     }
 
     /* Then submit the request to the endpoint */
@@ -529,6 +554,18 @@ static int _to_usb_submit(struct usbdev_ep_s *ep, struct usbdev_req_s *req,
     ret = EP_SUBMIT(ep, req);
     if (ret != OK) {
         usbtrace(TRACE_CLSERROR(USBSER_TRACEERR_SUBMITFAIL), (uint16_t) - ret);
+
+        /*
+         * No completion will come for this request: give it back, and
+         * with zero copy, the CPort RX buffer too.
+         */
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+        if (USB_EPNO(ep->eplog) != CONFIG_APBRIDGE_EPINTIN) {
+            req->buf = NULL;
+            unipro_unpause_rx(get_cportid(payload));
+        }
+#endif
+        put_request(epno_to_req_list(ep->priv, USB_EPNO(ep->eplog)), req);
         return ret;
     }
 
@@ -611,6 +648,93 @@ int usb_release_buffer(struct apbridge_dev_s *priv, const void *buf)
     return -EINVAL;
 }
 
+static bool cport_is_throttled(struct apbridge_dev_s *priv,
+                               unsigned int cportid)
+{
+    struct apbridge_req_s *reqcontainer;
+    struct gb_operation_hdr *hdr;
+    struct list_head *iter;
+
+    list_foreach(&priv->throttled, iter) {
+        reqcontainer = list_entry(iter, struct apbridge_req_s, throttled);
+        hdr = (struct gb_operation_hdr *) reqcontainer->req->buf;
+        if (get_cportid(hdr) == cportid)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Hand a bulk OUT request over to UniPro
+ *
+ * When the CPort cannot queue any more data, or when older requests for the
+ * same CPort are still waiting, the request is put on the throttled list
+ * instead of being resubmitted. Once all the requests of an endpoint are
+ * throttled, the host gets NAKed until usb_unthrottle() releases them.
+ */
+static void usb_out_to_unipro(struct apbridge_dev_s *priv,
+                              struct usbdev_req_s *req)
+{
+    struct apbridge_req_s *reqcontainer = req->priv;
+    struct gb_operation_hdr *hdr = (struct gb_operation_hdr *) req->buf;
+    irqstate_t flags;
+    int ret;
+
+    flags = irqsave();
+
+    if (cport_is_throttled(priv, get_cportid(hdr))) {
+        list_add(&priv->throttled, &reqcontainer->throttled);
+        irqrestore(flags);
+        return;
+    }
+
+    ret = priv->driver->usb_to_unipro(priv, req->buf, req->xfrd);
+    if (ret == -EAGAIN) {
+        list_add(&priv->throttled, &reqcontainer->throttled);
+    } else if (ret < 0) {
+        /* The message has been dropped, give the request back to the host */
+        usb_release_buffer(priv, req->buf);
+    }
+
+    irqrestore(flags);
+}
+
+/**
+ * @brief Retry the throttled bulk OUT requests of a CPort
+ * priv usb device.
+ * param cportid CPort that can accept data again
+ */
+void usb_unthrottle(struct apbridge_dev_s *priv, unsigned int cportid)
+{
+    struct apbridge_req_s *reqcontainer;
+    struct list_head *iter, *next;
+    struct usbdev_req_s *req;
+    struct gb_operation_hdr *hdr;
+    irqstate_t flags;
+    int ret;
+
+    flags = irqsave();
+
+    list_foreach_safe(&priv->throttled, iter, next) {
+        reqcontainer = list_entry(iter, struct apbridge_req_s, throttled);
+        req = reqcontainer->req;
+        hdr = (struct gb_operation_hdr *) req->buf;
+        if (get_cportid(hdr) != cportid)
+            continue;
+
+        ret = priv->driver->usb_to_unipro(priv, req->buf, req->xfrd);
+        if (ret == -EAGAIN)
+            break;
+
+        list_del(iter);
+        if (ret < 0)
+            usb_release_buffer(priv, req->buf);
+    }
+
+    irqrestore(flags);
+}
+
 /**
  * @brief Send data that come from SVC to AP module
  * priv usb device.
@@ -894,6 +1018,9 @@ static void usbclass_resetconfig(struct apbridge_dev_s *priv)
 
         for (i = 1; i < APBRIDGE_MAX_ENDPOINTS; i++)
             EP_DISABLE(priv->ep[i]);
+
+        /* The bulk OUT requests all get resubmitted on the next config */
+        list_init(&priv->throttled);
     }
 }
 
@@ -1041,7 +1168,6 @@ static void usbclass_rdcomplete(struct usbdev_ep_s *ep,
                                 struct usbdev_req_s *req)
 {
     struct apbridge_dev_s *priv;
-    struct apbridge_usb_driver *drv;
     struct gb_operation_hdr *hdr;
     int ep_n;
     unsigned int cportid;
@@ -1058,7 +1184,6 @@ static void usbclass_rdcomplete(struct usbdev_ep_s *ep,
     /* Extract references to private data */
 
     priv = (struct apbridge_dev_s *) ep->priv;
-    drv = priv->driver;
 
     /* Process the received data unless this is some unusual condition */
 
@@ -1074,7 +1199,7 @@ static void usbclass_rdcomplete(struct usbdev_ep_s *ep,
             hdr->pad[1] = (cportid >> 8) & 0xff;
         }
 
-        drv->usb_to_unipro(priv, req->buf , req->xfrd);
+        usb_out_to_unipro(priv, req);
         break;
 
     case -ESHUTDOWN:           /* Disconnection */
@@ -1094,6 +1219,9 @@ static void usbclass_wrcomplete(struct usbdev_ep_s *ep,
     struct list_head *list;
     struct apbridge_msg_s *info;
     struct apbridge_dev_s *priv;
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+    int cportid = -1;
+#endif
 
     /* Sanity check */
 #ifdef CONFIG_DEBUG
@@ -1104,15 +1232,29 @@ static void usbclass_wrcomplete(struct usbdev_ep_s *ep,
 #endif
 
     priv = (struct apbridge_dev_s *) ep->priv;
-    info = apbridge_dequeue(priv);
+
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+    /* Detach the CPort RX buffer, it is unpaused once the request is reused */
+    if (USB_EPNO(ep->eplog) != CONFIG_APBRIDGE_EPINTIN) {
+        cportid = get_cportid((struct gb_operation_hdr *) req->buf);
+        req->buf = NULL;
+    }
+#endif
+
+    list = epno_to_req_list(priv, USB_EPNO(ep->eplog));
+    info = apbridge_dequeue(priv, list);
     if (info) {
         _to_usb_submit(info->ep, req, info->buf, info->len);
         free(info);
     } else {
-        list = epno_to_req_list(priv, USB_EPNO(ep->eplog));
         put_request(list, req);
     }
 
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+    if (cportid >= 0)
+        unipro_unpause_rx(cportid);
+#endif
+
     switch (req->result) {
     case OK:                   /* Normal completion */
         usbtrace(TRACE_CLASSWRCOMPLETE, 0);
@@ -1292,9 +1434,18 @@ static int usbclass_bind(struct usbdevclass_driver_s *driver,
                      APBRIDGE_NREQS * APBRIDGE_NBULKS);
 
     list_init(&priv->wrreq);
+#ifdef CONFIG_APBRIDGE_ZERO_COPY
+    /*
+     * Bulk IN requests borrow the CPort RX buffers, and a CPort has only
+     * one of them in flight: one request per CPort, without any buffer.
+     */
+    prealloc_request(priv->ep[CONFIG_APBRIDGE_EPBULKIN],
+                     usbclass_wrcomplete, 0, CPORT_MAX);
+#else
     prealloc_request(priv->ep[CONFIG_APBRIDGE_EPBULKIN],
                      usbclass_wrcomplete, APBRIDGE_REQ_SIZE,
                      APBRIDGE_NREQS * APBRIDGE_NBULKS);
+#endif
 
     /* Report if we are selfpowered */
 
@@ -1753,6 +1904,7 @@ int usbdev_apbinitialize(struct apbridge_usb_driver *driver)
     }
     sem_init(&priv->config_sem, 0, 0);
     list_init(&priv->msg_queue);
+    list_init(&priv->throttled);
 
     /* Initialize the USB class driver structure */
 
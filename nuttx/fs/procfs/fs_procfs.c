@@ -96,6 +96,12 @@ extern const struct procfs_operations smartfs_procfsoperations;
 extern const struct procfs_operations ccm_procfsoperations;
 #endif
 
+/* Implemented in drivers/greybus */
+
+#if defined(CONFIG_GREYBUS_STATS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_GREYBUS)
+extern const struct procfs_operations gb_procfs_operations;
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -117,6 +123,11 @@ static const struct procfs_entry_s g_procfsentries[] =
   { "fs/smartfs**",     &smartfs_procfsoperations },
 #endif
 
+#if defined(CONFIG_GREYBUS_STATS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_GREYBUS)
+  { "greybus/latency",  &gb_procfs_operations },
+  { "greybus/stats",    &gb_procfs_operations },
+#endif
+
 #if defined(CONFIG_MTD) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MTD)
   { "mtd",              &mtd_procfsoperations },
 #endif
@@ -151,6 +162,8 @@ static int     procfs_open(FAR struct file *filep, FAR const char *relpath,
 static int     procfs_close(FAR struct file *filep);
 static ssize_t procfs_read(FAR struct file *filep, FAR char *buffer,
                  size_t buflen);
+static ssize_t procfs_write(FAR struct file *filep, FAR const char *buffer,
+                 size_t buflen);
 static int     procfs_ioctl(FAR struct file *filep, int cmd,
                  unsigned long arg);
 
@@ -193,7 +206,7 @@ const struct mountpt_operations procfs_operations =
   procfs_open,       /* open */
   procfs_close,      /* close */
   procfs_read,       /* read */
-  NULL,              /* write */
+  procfs_write,      /* write */
   NULL,              /* seek */
   procfs_ioctl,      /* ioctl */
 
@@ -360,6 +373,32 @@ static ssize_t procfs_read(FAR struct file *filep, FAR char *buffer,
   return ret;
 }
 
+/****************************************************************************
+ * Name: procfs_write
+ ****************************************************************************/
+
+static ssize_t procfs_write(FAR struct file *filep, FAR const char *buffer,
+                            size_t buflen)
+{
+  FAR struct procfs_file_s *handler;
+
+  fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+  /* Recover our private data from the struct file instance */
+
+  handler = (FAR struct procfs_file_s *)filep->f_priv;
+  DEBUGASSERT(handler);
+
+  /* Most entries are read-only */
+
+  if (!handler->procfsentry->ops->write)
+    {
+      return -EACCES;
+    }
+
+  return handler->procfsentry->ops->write(filep, buffer, buflen);
+}
+
 /****************************************************************************
  * Name: procfs_ioctl
  ****************************************************************************/
@@ -92,6 +92,9 @@ enum proc_node_e
   PROC_CMDLINE,                       /* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
   PROC_LOADAVG,                       /* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+  PROC_CPUACCT,                       /* CPU accounting */
 #endif
   PROC_STACK,                         /* Task stack info */
   PROC_GROUP,                         /* Group directory */
@@ -148,6 +151,11 @@ static ssize_t proc_loadavg(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
 #endif
+#ifdef CONFIG_SCHED_CPUACCT
+static ssize_t proc_cpuacct(FAR struct proc_file_s *procfile,
+                 FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
+                 off_t offset);
+#endif
 static ssize_t proc_stack(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
@@ -230,6 +238,13 @@ static const struct proc_node_s g_loadavg =
 };
 #endif
 
+#ifdef CONFIG_SCHED_CPUACCT
+static const struct proc_node_s g_cpuacct =
+{
+  "cpuacct",      "cpuacct", (uint8_t)PROC_CPUACCT,      DTYPE_FILE        /* CPU accounting */
+};
+#endif
+
 static const struct proc_node_s g_stack =
 {
   "stack",        "stack",   (uint8_t)PROC_STACK,        DTYPE_FILE        /* Task stack info */
@@ -258,6 +273,9 @@ static FAR const struct proc_node_s * const g_nodeinfo[] =
   &g_cmdline,      /* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
   &g_loadavg,      /* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+  &g_cpuacct,      /* CPU accounting */
 #endif
   &g_stack,        /* Task stack info */
   &g_group,        /* Group directory */
@@ -274,6 +292,9 @@ static const struct proc_node_s * const g_level0info[] =
   &g_cmdline,      /* Task command line */
 #ifdef CONFIG_SCHED_CPULOAD
   &g_loadavg,      /* Average CPU utilization */
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+  &g_cpuacct,      /* CPU accounting */
 #endif
   &g_stack,        /* Task stack info */
   &g_group,        /* Group directory */
@@ -590,6 +611,88 @@ static ssize_t proc_loadavg(FAR struct proc_file_s *procfile,
 }
 #endif
 
+/****************************************************************************
+ * Name: proc_cpuacct
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CPUACCT
+static ssize_t proc_cpuacct(FAR struct proc_file_s *procfile,
+                            FAR struct tcb_s *tcb, FAR char *buffer,
+                            size_t buflen, off_t offset)
+{
+  struct cpuacct_s cpuacct;
+  FAR const char *label[3];
+  uint64_t usec[3];
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  int i;
+
+  /* Sample the accounting for the thread.  This fails only if the thread
+   * exited after the procfs entry was opened.
+   */
+
+  if (sched_cpuacct(procfile->pid, &cpuacct) < 0)
+    {
+      return 0;
+    }
+
+  remaining = buflen;
+  totalsize = 0;
+
+  /* Show the times in seconds, with microsecond resolution */
+
+  label[0] = "RunTime:";
+  usec[0]  = cpuacct.runtime;
+  label[1] = "WaitTime:";
+  usec[1]  = cpuacct.waittime;
+  label[2] = "IrqTime:";
+  usec[2]  = cpuacct.irqtime;
+
+  for (i = 0; i < 3; i++)
+    {
+      linesize   = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu.%06lu\n",
+                            label[i], (unsigned long)(usec[i] / 1000000),
+                            (unsigned long)(usec[i] % 1000000));
+      copysize   = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+      totalsize += copysize;
+      buffer    += copysize;
+      remaining -= copysize;
+
+      if (totalsize >= buflen)
+        {
+          return totalsize;
+        }
+    }
+
+  /* Show the number of context switches to this thread */
+
+  linesize   = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu\n",
+                        "Switches:", (unsigned long)cpuacct.nswitches);
+  copysize   = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+  totalsize += copysize;
+  buffer    += copysize;
+  remaining -= copysize;
+
+  if (totalsize >= buflen)
+    {
+      return totalsize;
+    }
+
+  /* Show the worst scheduling latency, in microseconds */
+
+  linesize   = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu\n",
+                        "MaxLatency:", (unsigned long)cpuacct.maxlatency);
+  copysize   = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+  totalsize += copysize;
+  return totalsize;
+}
+#endif
+
 /****************************************************************************
  * Name: proc_stack
  ****************************************************************************/
@@ -1063,6 +1166,11 @@ static ssize_t proc_read(FAR struct file *filep, FAR char *buffer,
     case PROC_LOADAVG: /* Average CPU utilization */
       ret = proc_loadavg(procfile, tcb, buffer, buflen, filep->f_pos);
       break;
+#endif
+#ifdef CONFIG_SCHED_CPUACCT
+    case PROC_CPUACCT: /* CPU accounting */
+      ret = proc_cpuacct(procfile, tcb, buffer, buflen, filep->f_pos);
+      break;
 #endif
     case PROC_STACK: /* Task stack info */
       ret = proc_stack(procfile, tcb, buffer, buflen, filep->f_pos);
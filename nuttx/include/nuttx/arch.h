@@ -1590,6 +1590,25 @@ char up_romgetc(FAR const char *ptr);
 void up_mdelay(unsigned int milliseconds);
 void up_udelay(useconds_t microseconds);
 
+/****************************************************************************
+ * Name: up_perf_init, up_perf_gettime and up_perf_getfreq
+ *
+ * Description:
+ *   If CONFIG_ARCH_HAVE_PERF is selected, the platform-specific logic
+ *   provides a free running 32-bit counter with a resolution much finer
+ *   than the system timer, typically the CPU cycle counter, to timestamp
+ *   events.  up_perf_init() starts it and is called from up_initialize(),
+ *   up_perf_gettime() returns its current value and up_perf_getfreq() its
+ *   frequency in Hz.
+ *
+ ***************************************************************************/
+
+#ifdef CONFIG_ARCH_HAVE_PERF
+void up_perf_init(void);
+uint32_t up_perf_gettime(void);
+uint32_t up_perf_getfreq(void);
+#endif
+
 /****************************************************************************
  * Name: up_cxxinitialize
  *
@@ -44,6 +44,7 @@ enum device_state {
     DEVICE_STATE_REMOVING,
 };
 
+struct device_dma_type_ops;
 struct device_i2s_type_ops;
 struct device_usb_hcd_type_ops;
 struct device_hsic_type_ops;
@@ -58,6 +59,7 @@ struct device_driver_ops {
     int     (*open)(struct device *dev);
     void    (*close)(struct device *dev);
     union {
+        struct device_dma_type_ops     *dma;
         struct device_pll_type_ops     *pll;
         struct device_i2s_type_ops     *i2s;
         struct device_usb_hcd_type_ops *usb_hcd;
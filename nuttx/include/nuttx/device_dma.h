@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @brief DMA engine device type
+ */
+
+#ifndef __INCLUDE_NUTTX_DEVICE_DMA_H
+#define __INCLUDE_NUTTX_DEVICE_DMA_H
+
+#include <errno.h>
+#include <stddef.h>
+
+#include <nuttx/util.h>
+#include <nuttx/device.h>
+
+#define DEVICE_TYPE_DMA_HW                 "dma"
+
+/**
+ * @brief DMA transfer completion callback
+ * @param dev DMA device that performed the transfer
+ * @param status 0 if the transfer completed, -errno otherwise
+ * @param arg argument given when the transfer was started
+ *
+ * @note The callback may be called from interrupt context.
+ */
+typedef void (*device_dma_callback)(struct device *dev, int status,
+                                    void *arg);
+
+struct device_dma_type_ops {
+    int (*memcpy)(struct device *dev, void *dst, const void *src, size_t len,
+                  device_dma_callback callback, void *arg);
+};
+
+/**
+ * @brief Start an asynchronous memory to memory copy
+ *
+ * The source and destination buffers must stay valid until the completion
+ * callback is called.
+ *
+ * @param dev DMA device to use
+ * @param dst destination buffer
+ * @param src source buffer
+ * @param len number of bytes to copy
+ * @param callback function called once the copy is complete
+ * @param arg argument passed to the callback
+ * @return 0: Copy started, the callback will be called on completion
+ *         -EBUSY: No DMA channel or descriptor available right now
+ *         -errno: Cause of failure
+ */
+static inline int device_dma_memcpy(struct device *dev, void *dst,
+                                    const void *src, size_t len,
+                                    device_dma_callback callback, void *arg)
+{
+    DEBUGASSERT(dev && dev->driver && dev->driver->ops &&
+                dev->driver->ops->type_ops.dma);
+
+    if (dev->state != DEVICE_STATE_OPEN)
+        return -ENODEV;
+
+    if (dev->driver->ops->type_ops.dma->memcpy)
+        return dev->driver->ops->type_ops.dma->memcpy(dev, dst, src, len,
+                                                      callback, arg);
+
+    return -ENOSYS;
+}
+
+#ifdef CONFIG_DMA_SW
+/**
+ * @brief Register the software DMA engine device and driver
+ *
+ * The software engine implements the DMA device type with memcpy() done by
+ * a dedicated thread. It lets DMA clients run on targets without a DMA
+ * controller, such as the simulator.
+ *
+ * @return 0: Software DMA engine registered
+ *         -errno: Cause of failure
+ */
+int sw_dma_register(void);
+#endif
+
+#endif /* __INCLUDE_NUTTX_DEVICE_DMA_H */
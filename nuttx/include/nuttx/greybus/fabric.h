@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GREYBUS_FABRIC_H__
+#define __GREYBUS_FABRIC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * In-process Greybus transport.
+ *
+ * The local Greybus core talks to peers registered per CPort, through a
+ * simulated link with a configurable bandwidth and latency. A peer sends
+ * messages with gb_fabric_peer_send() and receives the messages sent by
+ * the local drivers through its callback, called from the link thread.
+ */
+
+typedef void (*gb_fabric_peer_rx)(unsigned int cport, const void *buf,
+                                  size_t len, void *priv);
+
+struct gb_fabric_link_cfg {
+    /** bytes per second in each direction, 0 for no limit */
+    uint32_t bandwidth;
+    /** propagation delay added to every message (usec) */
+    uint32_t latency;
+};
+
+struct gb_fabric_dir_stats {
+    uint32_t messages;
+    uint32_t bytes;
+    /** messages dropped because the link queue was full */
+    uint32_t dropped;
+    /** messages delivered to a CPort nobody listens to */
+    uint32_t unrouted;
+    /** longest time between a send and the delivery (usec) */
+    uint32_t max_delay;
+};
+
+struct gb_fabric_stats {
+    /** peer to local Greybus core */
+    struct gb_fabric_dir_stats to_local;
+    /** local Greybus core to peer */
+    struct gb_fabric_dir_stats to_peer;
+};
+
+int gb_fabric_init(void);
+int gb_fabric_set_link(const struct gb_fabric_link_cfg *cfg);
+void gb_fabric_get_link(struct gb_fabric_link_cfg *cfg);
+
+int gb_fabric_attach_peer(unsigned int cport, gb_fabric_peer_rx rx,
+                          void *priv);
+int gb_fabric_detach_peer(unsigned int cport);
+int gb_fabric_peer_send(unsigned int cport, const void *buf, size_t len);
+
+int gb_fabric_get_stats(struct gb_fabric_stats *stats);
+void gb_fabric_reset_stats(void);
+
+#endif /* __GREYBUS_FABRIC_H__ */
@@ -31,6 +31,7 @@
 #ifndef _GREYBUS_H_
 #define _GREYBUS_H_
 
+#include <errno.h>
 #include <stddef.h>
 #include <pthread.h>
 
@@ -87,13 +88,22 @@ struct gb_transport_backend {
     int (*listen)(unsigned int cport);
     int (*stop_listening)(unsigned int cport);
     int (*send)(unsigned int cport, const void *buf, size_t len);
+
+    /*
+     * Optional. Give back a buffer that was passed to
+     * greybus_rx_handler_zero_copy(). Called exactly once per buffer.
+     */
+    void (*release_rx_buffer)(unsigned int cport, void *buf);
 };
 
 struct gb_operation {
     unsigned int cport;
     bool has_responded;
+    bool borrows_rx_buffer;
     atomic_t ref_count;
     struct timespec time;
+    uint32_t timeout;               /* tick at which the request expires */
+    struct list_head timeout_list;  /* entry in the timeout wheel */
 
     void *request_buffer;
     void *response_buffer;
@@ -105,6 +115,20 @@ struct gb_operation {
     struct list_head list;
 
     struct gb_operation *response;
+
+    /* handler of a received request, looked up when it was received */
+    struct gb_operation_handler *handler;
+};
+
+/*
+ * Scheduling class of a driver when greybus messages are dispatched by the
+ * shared worker pool. Ignored with one thread per CPort.
+ */
+enum gb_driver_priority {
+    GB_DRIVER_PRIORITY_NORMAL,
+    GB_DRIVER_PRIORITY_HIGH,
+    GB_DRIVER_PRIORITY_LOW,
+    GB_DRIVER_PRIORITY_COUNT,
 };
 
 struct gb_driver {
@@ -115,6 +139,17 @@ struct gb_driver {
     size_t stack_size;
     size_t op_handlers_count;
     const char *name;
+    enum gb_driver_priority priority;
+    bool tx_batching;
+
+    /*
+     * Let operations use the transport receive buffer as request buffer
+     * instead of a copy. The transport does not receive anything else on
+     * the CPort until the operation is destroyed or
+     * gb_operation_detach_request() is called, so handlers should not hold
+     * on to the operation.
+     */
+    bool zero_copy_rx;
 };
 
 struct gb_operation_hdr {
@@ -125,6 +160,67 @@ struct gb_operation_hdr {
     __u8 pad[2];
 };
 
+struct gb_pool_class_stats {
+    unsigned int size;      /* number of entries in the pool */
+    unsigned int free;      /* entries currently available */
+    unsigned int min_free;  /* low-water mark of available entries */
+    unsigned int exhausted; /* allocations that fell back to the heap */
+};
+
+struct gb_operation_pool_stats {
+    struct gb_pool_class_stats operations;
+    struct gb_pool_class_stats small;
+    struct gb_pool_class_stats large;
+};
+
+struct gb_cport_inflight_stats {
+    unsigned int inflight;      /* requests waiting for a response */
+    unsigned int max_inflight;  /* high-water mark of inflight */
+    unsigned long timeouts;     /* requests that never got a response */
+};
+
+struct gb_tx_batch_stats {
+    unsigned long messages;     /* messages sent through the batch */
+    unsigned long batches;      /* bursts handed to the transport */
+    unsigned long idle_flushes; /* bursts sent by the idle timer */
+    unsigned long errors;       /* messages the transport failed to send */
+    unsigned int max_batch;     /* largest burst, in messages */
+    unsigned long sizes[5];     /* bursts of 1, 2, 3-4, 5-8, 9+ messages */
+};
+
+#define GB_LATENCY_BUCKETS  8
+
+struct gb_cport_stats {
+    const char *driver;             /* name of the CPort driver */
+    unsigned long rx_msgs;
+    unsigned long rx_bytes;
+    unsigned long tx_msgs;
+    unsigned long tx_bytes;
+    unsigned int rx_fifo_depth;     /* messages waiting for the worker */
+    unsigned int rx_fifo_hwm;       /* high-water mark of rx_fifo_depth */
+    unsigned long timeouts;         /* requests without a response */
+    unsigned long oom_responses;    /* GB_OP_NO_MEMORY responses sent */
+    unsigned long send_errors;      /* messages the transport failed to send */
+
+    /* requests by handler latency, see gb_latency_bucket_usec */
+    unsigned long latency[GB_LATENCY_BUCKETS];
+};
+
+struct gb_worker_class_stats {
+    unsigned int queued;        /* CPorts waiting for a worker */
+    unsigned int max_queued;    /* high-water mark of queued */
+    unsigned long dispatched;   /* messages processed */
+};
+
+struct gb_worker_pool_stats {
+    unsigned int threads;       /* number of worker threads */
+    size_t stack_size;          /* stack size of each worker */
+    size_t stack_used;          /* deepest stack use of all workers, or 0 */
+    unsigned int pending;       /* messages waiting in the CPort fifos */
+    unsigned int max_pending;   /* high-water mark of pending */
+    struct gb_worker_class_stats classes[GB_DRIVER_PRIORITY_COUNT];
+};
+
 enum gb_operation_result {
     GB_OP_SUCCESS       = 0x00,
     GB_OP_INTERRUPTED   = 0x01,
@@ -191,9 +287,73 @@ struct gb_operation *gb_operation_create(unsigned int cport, uint8_t type,
                                          uint32_t req_size);
 void gb_operation_ref(struct gb_operation *operation);
 void gb_operation_unref(struct gb_operation *operation);
+int gb_operation_detach_request(struct gb_operation *operation);
 size_t gb_operation_get_request_payload_size(struct gb_operation *operation);
 uint8_t gb_operation_get_request_result(struct gb_operation *operation);
 int greybus_rx_handler(unsigned int, void*, size_t);
+int greybus_rx_handler_zero_copy(unsigned int, void*, size_t);
+int gb_cport_get_inflight_stats(unsigned int cport,
+                                struct gb_cport_inflight_stats *stats);
+
+#ifdef CONFIG_GREYBUS_OPERATION_POOL
+int gb_operation_pool_get_stats(struct gb_operation_pool_stats *stats);
+#else
+static inline int
+gb_operation_pool_get_stats(struct gb_operation_pool_stats *stats)
+{
+    return -ENOSYS;
+}
+#endif
+
+#ifdef CONFIG_GREYBUS_STATS
+/* Upper bound of each latency bucket but the last, in microseconds */
+extern const unsigned long gb_latency_bucket_usec[GB_LATENCY_BUCKETS - 1];
+
+int gb_cport_get_stats(unsigned int cport, struct gb_cport_stats *stats);
+void gb_stats_reset(void);
+#else
+static inline int gb_cport_get_stats(unsigned int cport,
+                                     struct gb_cport_stats *stats)
+{
+    return -ENOSYS;
+}
+
+static inline void gb_stats_reset(void)
+{
+}
+#endif
+
+#ifdef CONFIG_GREYBUS_TX_BATCH
+int gb_cport_set_tx_batching(unsigned int cport, bool enable);
+int gb_cport_flush_tx(unsigned int cport);
+int gb_cport_get_tx_batch_stats(unsigned int cport,
+                                struct gb_tx_batch_stats *stats);
+#else
+static inline int gb_cport_set_tx_batching(unsigned int cport, bool enable)
+{
+    return enable ? -ENOSYS : 0;
+}
+
+static inline int gb_cport_flush_tx(unsigned int cport)
+{
+    return 0;
+}
+
+static inline int gb_cport_get_tx_batch_stats(unsigned int cport,
+                                              struct gb_tx_batch_stats *stats)
+{
+    return -ENOSYS;
+}
+#endif
+
+#ifdef CONFIG_GREYBUS_WORKER_POOL
+int gb_worker_pool_get_stats(struct gb_worker_pool_stats *stats);
+#else
+static inline int gb_worker_pool_get_stats(struct gb_worker_pool_stats *stats)
+{
+    return -ENOSYS;
+}
+#endif
 
 void gb_control_register(int cport);
 void gb_gpio_register(int cport);
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GREYBUS_I2S_H__
+#define __GREYBUS_I2S_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct gb_i2s_jitter_stats {
+    /** audio messages received */
+    uint32_t messages;
+    /** silence played because the buffer was about to run dry */
+    uint32_t underruns;
+    /** messages dropped because the buffer was full */
+    uint32_t overruns;
+    /** silence inserted to grow the buffer up to its target depth */
+    uint32_t expansions;
+    /** messages dropped to shrink the buffer down to its target depth */
+    uint32_t compressions;
+    /** inter-arrival jitter estimate and its recent peak (usec) */
+    uint32_t jitter;
+    uint32_t peak_jitter;
+    /** target depth, current depth and highest depth (messages) */
+    uint32_t target;
+    uint32_t depth;
+    uint32_t max_depth;
+    /** audio buffered ahead of the playback (usec) */
+    uint32_t latency;
+    uint32_t max_latency;
+};
+
+/*
+ * Adaptive jitter buffer policy for audio messages played at a constant
+ * rate. Time is counted in message periods, as played by the consumer, so
+ * that the jitter is measured against the clock that actually matters and
+ * the policy can be driven by a simulated timeline.
+ *
+ * The buffer only starts playing once it holds its target depth, and the
+ * target follows the measured inter-arrival jitter: it grows by playing
+ * silence, and shrinks by dropping incoming messages, at most once every
+ * 'adjust_interval' played messages.
+ */
+struct gb_i2s_jitter {
+    unsigned int min_depth;
+    unsigned int max_depth;
+    unsigned int adjust_interval;
+    uint32_t period;            /* length of a message (usec) */
+
+    bool playing;
+    uint32_t played;            /* messages played since the start */
+    uint32_t last_arrival;      /* value of 'played' at the last arrival */
+    unsigned int jitter16;      /* smoothed deviation, in periods / 16 */
+    unsigned int peak16;        /* decaying peak deviation, periods / 16 */
+    unsigned int target;        /* lowest depth wanted before a refill */
+    unsigned int window;        /* messages left in the adjust window */
+    unsigned int low_depth;     /* lowest depth seen in the window */
+    bool compress;              /* drop the next message */
+
+    struct gb_i2s_jitter_stats stats;
+};
+
+void gb_i2s_jitter_init(struct gb_i2s_jitter *jb, uint32_t period,
+                        unsigned int min_depth, unsigned int max_depth);
+bool gb_i2s_jitter_arrived(struct gb_i2s_jitter *jb, unsigned int depth);
+bool gb_i2s_jitter_ready(struct gb_i2s_jitter *jb, unsigned int depth);
+unsigned int gb_i2s_jitter_played(struct gb_i2s_jitter *jb,
+                                  unsigned int depth);
+void gb_i2s_jitter_get_stats(struct gb_i2s_jitter *jb,
+                             struct gb_i2s_jitter_stats *stats);
+void gb_i2s_jitter_reset_stats(struct gb_i2s_jitter *jb);
+
+int gb_i2s_get_rx_stats(uint16_t bundle_id, struct gb_i2s_jitter_stats *stats);
+int gb_i2s_reset_rx_stats(uint16_t bundle_id);
+
+#endif /* __GREYBUS_I2S_H__ */
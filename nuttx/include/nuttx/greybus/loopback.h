@@ -29,6 +29,8 @@
 #ifndef __LOOPBACK__H__
 #define __LOOPBACK__H__
 
+#include <stddef.h>
+#include <stdint.h>
 #include <nuttx/list.h>
 
 /* Greybus loopback request types */
@@ -40,11 +42,25 @@
 
 typedef int (*gb_loopback_cport_cb)(int, void *);
 
+/**
+ * Called on completion of a loopback request
+ *
+ * @param cport cport the request was sent on
+ * @param status OK if the request succeeded, -EIO on error or timeout
+ * @param rtt_usec round-trip time of the request in microseconds
+ * @param data private data given to gb_loopback_set_resp_cb()
+ */
+typedef void (*gb_loopback_resp_cb)(int cport, int status, uint32_t rtt_usec,
+                                    void *data);
+
 int gb_loopback_get_cports(gb_loopback_cport_cb cb, void *data);
 int gb_loopback_send_req(int cport, size_t size, uint8_t type);
 int gb_loopback_get_error_count(int cport);
 unsigned gb_loopback_get_recv_count(int cport);
 void gb_loopback_reset(int cport);
 int gb_loopback_cport_valid(int cport);
+unsigned gb_loopback_get_outstanding(int cport);
+int gb_loopback_set_resp_cb(int cport, gb_loopback_resp_cb cb, void *data);
+size_t gb_loopback_get_max_size(void);
 
 #endif
@@ -32,6 +32,7 @@
 #define __GREYBUS_TAPE_H__
 
 #include <sys/types.h>
+#include <stdbool.h>
 
 enum {
     GB_TAPE_RDONLY,
@@ -48,10 +49,11 @@ struct gb_tape_mechanism {
 
 int gb_tape_register_mechanism(struct gb_tape_mechanism *mechanism);
 int gb_tape_arm_semihosting_register(void);
+int gb_tape_file_register(void);
 
 int gb_tape_communication(const char *pathname);
 int gb_tape_stop(void);
-int gb_tape_replay(const char *pathname);
+int gb_tape_replay(const char *pathname, bool timed);
 
 #endif /* __GREYBUS_TAPE_H__ */
 
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __GREYBUS_UART_H__
+#define __GREYBUS_UART_H__
+
+#include <stdint.h>
+
+struct gb_uart_rx_stats {
+    /** chunks of data reported by the UART */
+    uint32_t chunks;
+    /** Receive Data requests sent */
+    uint32_t requests;
+    /** bytes sent in Receive Data requests */
+    uint32_t bytes;
+    /** overruns reported by the UART */
+    uint32_t overruns;
+    /** times the UART was left without a receive buffer */
+    uint32_t starved;
+    /** requests that could not be sent */
+    uint32_t send_errors;
+    /** delay between the reception of the first byte and the send (usec) */
+    uint32_t max_latency;
+    uint64_t total_latency;
+};
+
+int gb_uart_get_rx_stats(struct gb_uart_rx_stats *stats);
+void gb_uart_reset_rx_stats(void);
+
+#endif /* __GREYBUS_UART_H__ */
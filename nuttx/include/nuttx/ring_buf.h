@@ -51,11 +51,26 @@
  * there can be only one accessor at a time, no locking is required to
  * access a ring buffer entry's data area (again, just like a network
  * controller's ring buffer interface).  ring_buf_pass() change ownership.
+ *
+ * Ownership changes are ordered with memory barriers, so a producer and a
+ * consumer running in different contexts (e.g., an interrupt handler and a
+ * thread) can share a ring without masking interrupts.
+ *
+ * For a single producer and a single consumer that want to move several
+ * entries at once or to know how full the ring is, struct ring_buf_spsc
+ * keeps a cursor and a free-running counter for each side on top of a ring
+ * allocated with ring_buf_alloc_ring().  Entries are then reserved and
+ * committed by the producer, and peeked and released by the consumer, in
+ * batches.  Each counter is only written by its own side, so no lock is
+ * needed either.
  */
 
 #ifndef __INCLUDE_NUTTX_RING_BUF_H
 #define __INCLUDE_NUTTX_RING_BUF_H
 
+/* Order the accesses to an entry with the change of its owner */
+#define ring_buf_barrier()  __sync_synchronize()
+
 enum ring_buf_owner {
     RING_BUF_OWNER_INVALID,
     RING_BUF_OWNER_PRODUCER,
@@ -64,7 +79,7 @@ enum ring_buf_owner {
 
 struct ring_buf {
     struct ring_buf     *next;
-    enum ring_buf_owner owner;
+    volatile enum ring_buf_owner owner;
     void                *priv;
     void                *headroom;
     void                *data;
@@ -102,7 +117,10 @@ static inline void ring_buf_set_owner(struct ring_buf *rb,
  */
 static inline int ring_buf_is_producers(struct ring_buf *rb)
 {
-    return rb->owner == RING_BUF_OWNER_PRODUCER;
+    int ret = rb->owner == RING_BUF_OWNER_PRODUCER;
+
+    ring_buf_barrier();
+    return ret;
 }
 
 /**
@@ -113,7 +131,10 @@ static inline int ring_buf_is_producers(struct ring_buf *rb)
  */
 static inline int ring_buf_is_consumers(struct ring_buf *rb)
 {
-    return rb->owner == RING_BUF_OWNER_CONSUMER;
+    int ret = rb->owner == RING_BUF_OWNER_CONSUMER;
+
+    ring_buf_barrier();
+    return ret;
 }
 
 /**
@@ -122,7 +143,10 @@ static inline int ring_buf_is_consumers(struct ring_buf *rb)
  */
 static inline void ring_buf_pass(struct ring_buf *rb)
 {
-    if (ring_buf_is_producers(rb))
+    /* Publish the entry's contents before handing it over */
+    ring_buf_barrier();
+
+    if (rb->owner == RING_BUF_OWNER_PRODUCER)
         ring_buf_set_owner(rb, RING_BUF_OWNER_CONSUMER);
     else
         ring_buf_set_owner(rb, RING_BUF_OWNER_PRODUCER);
@@ -273,6 +297,158 @@ static inline void *ring_buf_pull(struct ring_buf *rb, unsigned int len)
     return rb->head;
 }
 
+struct ring_buf_spsc {
+    struct ring_buf         *prod;      /* next entry for the producer */
+    struct ring_buf         *cons;      /* next entry for the consumer */
+    unsigned int            entries;
+    volatile unsigned int   produced;   /* only written by the producer */
+    volatile unsigned int   consumed;   /* only written by the consumer */
+};
+
+/**
+ * All the entries of the ring are given to the producer.  The ring must not
+ * be used through ring_buf_pass() at the same time.
+ *
+ * @brief Initialize a single producer, single consumer ring
+ * @param q Ring state to initialize
+ * @param rb Address of a ring buffer entry of a ring
+ * @return Number of entries in the ring
+ */
+static inline unsigned int ring_buf_spsc_init(struct ring_buf_spsc *q,
+                                              struct ring_buf *rb)
+{
+    struct ring_buf *iter = rb;
+
+    q->prod = rb;
+    q->cons = rb;
+    q->entries = 0;
+    q->produced = 0;
+    q->consumed = 0;
+
+    do {
+        ring_buf_set_owner(iter, RING_BUF_OWNER_PRODUCER);
+        q->entries++;
+        iter = ring_buf_get_next(iter);
+    } while (iter != rb);
+
+    ring_buf_barrier();
+
+    return q->entries;
+}
+
+/**
+ * May be called from either side; the value is exact for the caller's own
+ * side and a lower bound of what the other side will see.
+ *
+ * @brief Get the number of entries filled and not yet released
+ * @param q Ring state
+ * @return Number of entries owned by the consumer
+ */
+static inline unsigned int ring_buf_spsc_count(struct ring_buf_spsc *q)
+{
+    return q->produced - q->consumed;
+}
+
+/**
+ * @brief Get the number of entries available to the producer
+ * @param q Ring state
+ * @return Number of entries owned by the producer
+ */
+static inline unsigned int ring_buf_spsc_space(struct ring_buf_spsc *q)
+{
+    return q->entries - ring_buf_spsc_count(q);
+}
+
+/**
+ * The reserved entries are the returned one and the ones following it,
+ * reachable with ring_buf_get_next().  Only the producer may call this.
+ *
+ * @brief Reserve free entries
+ * @param q Ring state
+ * @param count In: number of entries wanted; out: number of entries reserved
+ * @return First reserved entry, or NULL if the ring is full
+ */
+static inline struct ring_buf *ring_buf_spsc_reserve(struct ring_buf_spsc *q,
+                                                     unsigned int *count)
+{
+    unsigned int space = q->entries - (q->produced - q->consumed);
+
+    /* Don't touch the entries before the consumer is done with them */
+    ring_buf_barrier();
+
+    if (*count > space)
+        *count = space;
+
+    return *count ? q->prod : NULL;
+}
+
+/**
+ * Only the producer may call this.
+ *
+ * @brief Hand reserved entries over to the consumer
+ * @param q Ring state
+ * @param count Number of entries filled, at most the number reserved
+ */
+static inline void ring_buf_spsc_commit(struct ring_buf_spsc *q,
+                                        unsigned int count)
+{
+    unsigned int i;
+
+    ring_buf_barrier();
+
+    for (i = 0; i < count; i++) {
+        ring_buf_set_owner(q->prod, RING_BUF_OWNER_CONSUMER);
+        q->prod = ring_buf_get_next(q->prod);
+    }
+
+    q->produced += count;
+}
+
+/**
+ * The entries are the returned one and the ones following it, reachable
+ * with ring_buf_get_next().  Only the consumer may call this.
+ *
+ * @brief Get filled entries
+ * @param q Ring state
+ * @param count In: number of entries wanted; out: number of entries returned
+ * @return First filled entry, or NULL if the ring is empty
+ */
+static inline struct ring_buf *ring_buf_spsc_peek(struct ring_buf_spsc *q,
+                                                  unsigned int *count)
+{
+    unsigned int filled = q->produced - q->consumed;
+
+    /* Don't read the entries before the producer has published them */
+    ring_buf_barrier();
+
+    if (*count > filled)
+        *count = filled;
+
+    return *count ? q->cons : NULL;
+}
+
+/**
+ * Only the consumer may call this.
+ *
+ * @brief Give consumed entries back to the producer
+ * @param q Ring state
+ * @param count Number of entries consumed, at most the number peeked
+ */
+static inline void ring_buf_spsc_release(struct ring_buf_spsc *q,
+                                         unsigned int count)
+{
+    unsigned int i;
+
+    ring_buf_barrier();
+
+    for (i = 0; i < count; i++) {
+        ring_buf_set_owner(q->cons, RING_BUF_OWNER_PRODUCER);
+        q->cons = ring_buf_get_next(q->cons);
+    }
+
+    q->consumed += count;
+}
+
 void ring_buf_init(struct ring_buf *rb, void *buf, unsigned int headroom,
                    unsigned int data_len);
 struct ring_buf *ring_buf_alloc(unsigned int headroom, unsigned int data_len,
@@ -434,6 +434,22 @@ struct task_group_s
 };
 #endif
 
+/* struct cpuacct_s **************************************************************/
+/* Per-thread CPU accounting.  Times are in units of the accounting clock (see
+ * sched_cpuacct()) while held in the TCB and in microseconds when returned.
+ */
+
+#ifdef CONFIG_SCHED_CPUACCT
+struct cpuacct_s
+{
+  uint64_t runtime;                      /* Time spent running                  */
+  uint64_t waittime;                     /* Time spent waiting for the CPU      */
+  uint64_t irqtime;                      /* Interrupt time while running        */
+  uint32_t nswitches;                    /* Number of times switched in         */
+  uint32_t maxlatency;                   /* Longest ready-to-run to running     */
+};
+#endif
+
 /* struct tcb_s ******************************************************************/
 /* This is the common part of the task control block (TCB).  The TCB is the heart
  * of the NuttX task-control logic.  Each task or thread is represented by a TCB
@@ -508,6 +524,7 @@ struct tcb_s
   /* POSIX Semaphore Control Fields *********************************************/
 
   sem_t *waitsem;                        /* Semaphore ID waiting on             */
+  FAR struct tcb_s *semflink;            /* Next task in waitsem->waitq         */
 
   /* POSIX Signal Control Fields ************************************************/
 
@@ -530,6 +547,13 @@ struct tcb_s
 
   int pterrno;                           /* Current per-thread errno            */
 
+#ifdef CONFIG_SCHED_CPUACCT
+  /* CPU accounting *************************************************************/
+
+  struct cpuacct_s cpuacct;              /* Accumulated CPU accounting          */
+  uint64_t cpustamp;                     /* Time of last state change           */
+#endif
+
   /* State save areas ***********************************************************/
   /* The form and content of these fields are platform-specific.                */
 
@@ -641,6 +665,14 @@ void sched_foreach(sched_foreach_t handler, FAR void *arg);
 
 FAR struct tcb_s *sched_gettcb(pid_t pid);
 
+/* Return the CPU accounting for a thread, converted to microseconds.  Returns
+ * OK on success or -ESRCH if the pid does not refer to a valid thread.
+ */
+
+#ifdef CONFIG_SCHED_CPUACCT
+int sched_cpuacct(pid_t pid, FAR struct cpuacct_s *cpuacct);
+#endif
+
 /* File system helpers **********************************************************/
 /* These functions all extract lists from the group structure assocated with the
  * currently executing task.
@@ -0,0 +1,270 @@
+/****************************************************************************
+ * include/nuttx/sched_note.h
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_SCHED_NOTE_H
+#define __INCLUDE_NUTTX_SCHED_NOTE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <semaphore.h>
+
+#include <nuttx/sched.h>
+
+#ifdef CONFIG_SCHED_NOTE_BUFFER
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Maximum length of the text of a NOTE_MARK note */
+
+#define NOTE_MARK_MAX 64
+
+/* Length of the notes that end with text */
+
+#define SIZEOF_NOTE_START(n) (sizeof(struct note_common_s) + 1 + (n))
+#define SIZEOF_NOTE_MARK(n)  (sizeof(struct note_common_s) + (n))
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* The notes are recorded in a ring buffer and read by the host as a stream
+ * of bytes, so they are only made of bytes: the multi-byte values are
+ * little endian.
+ */
+
+enum note_type_e
+{
+  NOTE_INFO = 0,       /* Frequency of the timestamps */
+  NOTE_START,          /* A task was started */
+  NOTE_STOP,           /* A task was stopped */
+  NOTE_SWITCH,         /* Context switch */
+  NOTE_IRQ_ENTER,      /* Interrupt handler entry */
+  NOTE_IRQ_LEAVE,      /* Interrupt handler exit */
+  NOTE_SEM_WAIT,       /* A task blocked on a semaphore */
+  NOTE_SEM_WAKE,       /* A task waiting on a semaphore was woken up */
+  NOTE_MARK,           /* User-defined marker */
+  NOTE_TASK            /* Name of an existing task, emitted by /dev/note */
+};
+
+/* All the notes start with this header */
+
+struct note_common_s
+{
+  uint8_t nc_length;   /* Length of the note, in bytes */
+  uint8_t nc_type;     /* See enum note_type_e */
+  uint8_t nc_pid[2];   /* ID of the task concerned by the note */
+  uint8_t nc_time[4];  /* Timestamp */
+};
+
+/* NOTE_INFO */
+
+struct note_info_s
+{
+  struct note_common_s ni_cmn;
+  uint8_t ni_freq[4];  /* Frequency of the timestamps in Hz */
+};
+
+/* NOTE_START and NOTE_TASK: nc_pid is the task */
+
+struct note_start_s
+{
+  struct note_common_s nst_cmn;
+  uint8_t nst_priority;
+#if CONFIG_TASK_NAME_SIZE > 0
+  char nst_name[CONFIG_TASK_NAME_SIZE]; /* Not NUL terminated */
+#endif
+};
+
+/* NOTE_STOP has no data: nc_pid is the task */
+
+/* NOTE_SWITCH: nc_pid is the task that now runs */
+
+struct note_switch_s
+{
+  struct note_common_s nsw_cmn;
+  uint8_t nsw_prev[2]; /* ID of the task that ran before */
+};
+
+/* NOTE_IRQ_ENTER and NOTE_IRQ_LEAVE: nc_pid is the interrupted task */
+
+struct note_irq_s
+{
+  struct note_common_s nirq_cmn;
+  uint8_t nirq_irq[2];
+};
+
+/* NOTE_SEM_WAIT and NOTE_SEM_WAKE: nc_pid is the waiting task */
+
+struct note_sem_s
+{
+  struct note_common_s nsem_cmn;
+  uint8_t nsem_sem[4]; /* Address of the semaphore */
+};
+
+/* NOTE_MARK: nc_pid is the running task */
+
+struct note_mark_s
+{
+  struct note_common_s nmk_cmn;
+  char nmk_text[NOTE_MARK_MAX]; /* Not NUL terminated */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/* sched_note_start(), sched_note_stop() and sched_note_switch() are
+ * prototyped in include/sched.h.
+ */
+
+/****************************************************************************
+ * Name: sched_note_irqhandler
+ *
+ * Description:
+ *   Record the entry in or the exit from an interrupt handler.  This is
+ *   called by irq_dispatch() if CONFIG_SCHED_NOTE_IRQHANDLER is selected.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_NOTE_IRQHANDLER
+void sched_note_irqhandler(int irq, bool enter);
+#else
+#  define sched_note_irqhandler(i,e)
+#endif
+
+/****************************************************************************
+ * Name: sched_note_semwait and sched_note_semwake
+ *
+ * Description:
+ *   Record that a task blocks on a semaphore, or that a task blocked on a
+ *   semaphore is woken up by sem_post().  These are called by the
+ *   semaphore logic if CONFIG_SCHED_NOTE_SEMAPHORE is selected.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_NOTE_SEMAPHORE
+void sched_note_semwait(FAR struct tcb_s *tcb, FAR sem_t *sem);
+void sched_note_semwake(FAR struct tcb_s *tcb, FAR sem_t *sem);
+#else
+#  define sched_note_semwait(t,s)
+#  define sched_note_semwake(t,s)
+#endif
+
+/****************************************************************************
+ * Name: sched_note_mark
+ *
+ * Description:
+ *   Record a user-defined marker.  The text is truncated to NOTE_MARK_MAX
+ *   bytes.
+ *
+ ****************************************************************************/
+
+void sched_note_mark(FAR const char *text, size_t len);
+
+/****************************************************************************
+ * Name: sched_note_common
+ *
+ * Description:
+ *   Fill the header of a note, with the current time.
+ *
+ ****************************************************************************/
+
+void sched_note_common(FAR struct note_common_s *note, size_t length,
+                       uint8_t type, pid_t pid);
+
+/****************************************************************************
+ * Name: sched_note_get
+ *
+ * Description:
+ *   Remove the oldest notes from the buffer and copy them to 'buffer'.
+ *   Only whole notes are copied.
+ *
+ * Return Value:
+ *   The number of bytes copied, zero if there is no note or if the first
+ *   one does not fit.
+ *
+ ****************************************************************************/
+
+ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen);
+
+/****************************************************************************
+ * Name: sched_note_getfreq
+ *
+ * Description:
+ *   Return the frequency of the timestamps of the notes, in Hz.
+ *
+ ****************************************************************************/
+
+uint32_t sched_note_getfreq(void);
+
+/****************************************************************************
+ * Name: note_register
+ *
+ * Description:
+ *   Register /dev/note, from which the notes can be read.  Writing to it
+ *   records a NOTE_MARK note.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DRIVER_NOTE
+void note_register(void);
+#endif
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#else /* CONFIG_SCHED_NOTE_BUFFER */
+
+#  define sched_note_irqhandler(i,e)
+#  define sched_note_semwait(t,s)
+#  define sched_note_semwake(t,s)
+
+#endif /* CONFIG_SCHED_NOTE_BUFFER */
+#endif /* __INCLUDE_NUTTX_SCHED_NOTE_H */
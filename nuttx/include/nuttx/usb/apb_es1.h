@@ -47,5 +47,6 @@ void usb_wait(struct apbridge_dev_s *dev);
 int usbdev_apbinitialize(struct apbridge_usb_driver *driver);
 
 int usb_release_buffer(struct apbridge_dev_s *priv, const void *buf);
+void usb_unthrottle(struct apbridge_dev_s *priv, unsigned int cportid);
 
 #endif /* _APB_ES1_H_ */
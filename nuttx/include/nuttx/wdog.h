@@ -126,6 +126,10 @@ typedef CODE void (*wdentry_t)(int argc, uint32_t arg1, ...);
 
 /* This is the internal representation of the watchdog timer structure.  The
  * WDOG_ID is a pointer to a watchdog structure.
+ *
+ * With CONFIG_WDOG_TIMING_WHEEL, lag holds the expiration time of an active
+ * watchdog instead of the delay from the previous one, and next, prev and
+ * slot link it in its slot of the timing wheel.
  */
 
 struct wdog_s
@@ -138,7 +142,13 @@ struct wdog_s
   int                lag;        /* Timer associated with the delay */
   uint8_t            flags;      /* See WDOGF_* definitions above */
   uint8_t            argc;       /* The number of parameters to pass */
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+  uint8_t            slot;       /* Slot of the timing wheel */
+#endif
   uint32_t           parm[CONFIG_MAX_WDOGPARMS];
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+  FAR struct wdog_s *prev;       /* Previous watchdog in the slot */
+#endif
 };
 
 /* Watchdog 'handle' */
@@ -63,8 +63,9 @@ extern "C"
 
 /* This structure contains information about the holder of a semaphore */
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
 struct tcb_s; /* Forward reference */
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
 struct semholder_s
 {
 #if CONFIG_SEM_PREALLOCHOLDERS > 0
@@ -98,6 +99,12 @@ struct sem_s
   struct semholder_s holder;     /* Single holder */
 # endif
 #endif
+
+  /* Tasks blocked on the semaphore, highest priority first and FIFO among
+   * tasks of the same priority.  They are linked through tcb_s::semflink.
+   */
+
+  FAR struct tcb_s *waitq;
 };
 
 typedef struct sem_s sem_t;
@@ -106,12 +113,12 @@ typedef struct sem_s sem_t;
 
 #ifdef CONFIG_PRIORITY_INHERITANCE
 # if CONFIG_SEM_PREALLOCHOLDERS > 0
-#  define SEM_INITIALIZER(c) {(c), NULL}  /* semcount, hhead */
+#  define SEM_INITIALIZER(c) {(c), NULL, NULL}  /* semcount, hhead, waitq */
 # else
-#  define SEM_INITIALIZER(c) {(c), SEMHOLDER_INITIALIZER} /* semcount, holder */
+#  define SEM_INITIALIZER(c) {(c), SEMHOLDER_INITIALIZER, NULL} /* semcount, holder, waitq */
 # endif
 #else
-#  define SEM_INITIALIZER(c) {(c)} /* semcount */
+#  define SEM_INITIALIZER(c) {(c), NULL} /* semcount, waitq */
 #endif
 
 /****************************************************************************
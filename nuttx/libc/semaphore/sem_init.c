@@ -115,6 +115,10 @@ int sem_init(FAR sem_t *sem, int pshared, unsigned int value)
       sem->holder.counts = 0;
 #  endif
 #endif
+
+      /* No task is waiting for the semaphore yet */
+
+      sem->waitq         = NULL;
       return OK;
     }
   else
@@ -486,6 +486,12 @@ void os_start(void)
 
   up_initialize();
 
+#if defined(CONFIG_SCHED_CPUACCT) && defined(CONFIG_SCHED_TICKLESS)
+  /* Make sure that CPU accounting does not miss a wrap of its clock */
+
+  sched_cpuacct_initialize();
+#endif
+
 #ifdef CONFIG_MM_SHM
   /* Initialize shared memory support */
 
@@ -42,8 +42,10 @@
 #include <debug.h>
 #include <nuttx/arch.h>
 #include <nuttx/irq.h>
+#include <nuttx/sched_note.h>
 
 #include "irq/irq.h"
+#include "sched/sched.h"
 
 /****************************************************************************
  * Definitions
@@ -100,6 +102,10 @@ void irq_dispatch(int irq, FAR void *context)
 
   /* Then dispatch to the interrupt handler */
 
+  sched_note_irqhandler(irq, true);
+  sched_cpuacct_irqenter();
   vector(irq, context);
+  sched_cpuacct_irqleave();
+  sched_note_irqhandler(irq, false);
 }
 
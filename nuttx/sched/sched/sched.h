@@ -224,6 +224,21 @@ bool sched_addreadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_removereadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_addprioritized(FAR struct tcb_s *newTcb, DSEG dq_queue_t *list);
 bool sched_mergepending(void);
+
+/* Insertion in and removal from the g_readytorun list, without changing the
+ * state of the task.  sched_rtrinsert() returns true if the task was added at
+ * the head of the list.
+ */
+
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+bool sched_rtrinsert(FAR struct tcb_s *tcb);
+void sched_rtrremove(FAR struct tcb_s *tcb);
+#else
+#  define sched_rtrinsert(tcb) \
+     sched_addprioritized(tcb, (FAR dq_queue_t*)&g_readytorun)
+#  define sched_rtrremove(tcb) \
+     dq_rem((FAR dq_entry_t*)(tcb), (FAR dq_queue_t*)&g_readytorun)
+#endif
 void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state);
 void sched_removeblocked(FAR struct tcb_s *btcb);
 int  sched_setpriority(FAR struct tcb_s *tcb, int sched_priority);
@@ -250,6 +265,21 @@ void sched_timer_reassess(void);
 void weak_function sched_process_cpuload(void);
 #endif
 
+#ifdef CONFIG_SCHED_CPUACCT
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_cpuacct_initialize(void);
+#endif
+void sched_cpuacct_ready(FAR struct tcb_s *tcb);
+void sched_cpuacct_switch(FAR struct tcb_s *from, FAR struct tcb_s *to);
+void sched_cpuacct_irqenter(void);
+void sched_cpuacct_irqleave(void);
+#else
+#  define sched_cpuacct_ready(t)
+#  define sched_cpuacct_switch(f,t)
+#  define sched_cpuacct_irqenter()
+#  define sched_cpuacct_irqleave()
+#endif
+
 bool sched_verifytcb(FAR struct tcb_s *tcb);
 int  sched_releasetcb(FAR struct tcb_s *tcb, uint8_t ttype);
 
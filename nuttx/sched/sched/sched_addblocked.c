@@ -43,6 +43,7 @@
 #include <assert.h>
 
 #include "sched/sched.h"
+#include "semaphore/semaphore.h"
 
 /************************************************************************
  * Definitions
@@ -115,6 +116,15 @@ void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state)
                  (FAR dq_queue_t*)g_tasklisttable[task_state].list);
     }
 
+  /* A task waiting for a semaphore is also queued on the semaphore itself,
+   * so that sem_post() does not have to search g_waitingforsemaphore.
+   */
+
+  if (task_state == TSTATE_WAIT_SEM)
+    {
+      sem_addwaiter(btcb);
+    }
+
   /* Make sure the TCB's state corresponds to the list */
 
   btcb->task_state = task_state;
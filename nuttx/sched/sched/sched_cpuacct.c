@@ -0,0 +1,377 @@
+/****************************************************************************
+ * sched/sched/sched_cpuacct.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sched.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/wdog.h>
+#include <arch/irq.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_CPUACCT
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The accounting clock is the 32-bit performance counter (or the system
+ * timer when there is none), extended to 64 bits here so that long running
+ * or long waiting threads are accounted for correctly.  It is sampled at
+ * each interrupt and context switch, and must be sampled at least once per
+ * wrap of the counter (about 44 seconds for a 96MHz cycle counter).  The
+ * timer tick guarantees it; without one, a watchdog is kept running for
+ * that purpose.
+ */
+
+static uint64_t g_cpuacct_time;
+static uint32_t g_cpuacct_last;
+
+#ifdef CONFIG_SCHED_TICKLESS
+static WDOG_ID g_cpuacct_wdog;
+static int g_cpuacct_period;
+#endif
+
+/* Interrupt time is charged to the thread that was running when the
+ * outermost interrupt handler was entered.
+ */
+
+static FAR struct tcb_s *g_cpuacct_irqtcb;
+static uint64_t g_cpuacct_irqstart;
+static uint8_t g_cpuacct_irqnest;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cpuacct_gettime
+ *
+ * Description:
+ *   Return the current value of the 64-bit accounting clock.  Must be
+ *   called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+static uint64_t cpuacct_gettime(void)
+{
+  uint32_t now;
+
+#ifdef CONFIG_ARCH_HAVE_PERF
+  now = up_perf_gettime();
+#else
+  now = (uint32_t)clock_systimer();
+#endif
+
+  g_cpuacct_time += (uint32_t)(now - g_cpuacct_last);
+  g_cpuacct_last  = now;
+  return g_cpuacct_time;
+}
+
+/****************************************************************************
+ * Name: cpuacct_getfreq
+ ****************************************************************************/
+
+static inline uint32_t cpuacct_getfreq(void)
+{
+#ifdef CONFIG_ARCH_HAVE_PERF
+  return up_perf_getfreq();
+#else
+  return CLK_TCK;
+#endif
+}
+
+/****************************************************************************
+ * Name: cpuacct_timeout
+ *
+ * Description:
+ *   Watchdog handler sampling the accounting clock, every half wrap of the
+ *   counter.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+static void cpuacct_timeout(int argc, uint32_t arg1, ...)
+{
+  irqstate_t flags;
+
+  flags = irqsave();
+  (void)cpuacct_gettime();
+  irqrestore(flags);
+
+  (void)wd_start(g_cpuacct_wdog, g_cpuacct_period, cpuacct_timeout, 0);
+}
+#endif
+
+/****************************************************************************
+ * Name: cpuacct_usec
+ *
+ * Description:
+ *   Convert a duration from accounting clock units to microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t cpuacct_usec(uint64_t value, uint32_t freq)
+{
+  /* Convert the whole seconds and the remainder separately so that the
+   * intermediate product never overflows.
+   */
+
+  return (value / freq) * 1000000 + ((value % freq) * 1000000) / freq;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_cpuacct_initialize
+ *
+ * Description:
+ *   With CONFIG_SCHED_TICKLESS, there may be no interrupt for longer than
+ *   the accounting clock takes to wrap:  start the watchdog sampling it.
+ *   Called once the timers are running.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_cpuacct_initialize(void)
+{
+  uint64_t period;
+
+  period = ((uint64_t)1 << 31) * CLK_TCK / cpuacct_getfreq();
+  if (period > INT_MAX)
+    {
+      period = INT_MAX;
+    }
+  else if (period == 0)
+    {
+      period = 1;
+    }
+
+  g_cpuacct_period = (int)period;
+  g_cpuacct_wdog   = wd_create();
+  DEBUGASSERT(g_cpuacct_wdog != NULL);
+
+  (void)wd_start(g_cpuacct_wdog, g_cpuacct_period, cpuacct_timeout, 0);
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_cpuacct_ready
+ *
+ * Description:
+ *   Called when a thread becomes ready-to-run: the time until it is
+ *   switched in is accounted for as wait time.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sched_cpuacct_ready(FAR struct tcb_s *tcb)
+{
+  tcb->cpustamp = cpuacct_gettime();
+}
+
+/****************************************************************************
+ * Name: sched_cpuacct_switch
+ *
+ * Description:
+ *   Called on each context switch, from the same places as
+ *   sched_note_switch().  The time since 'from' was switched in is added
+ *   to its run time (unless the switch happens in an interrupt handler, in
+ *   which case it has already been accounted for on entry) and the time
+ *   'to' spent waiting for the CPU to its wait time.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sched_cpuacct_switch(FAR struct tcb_s *from, FAR struct tcb_s *to)
+{
+  uint64_t now = cpuacct_gettime();
+  uint64_t elapsed;
+
+  if (g_cpuacct_irqnest == 0)
+    {
+      from->cpuacct.runtime += now - from->cpustamp;
+    }
+
+  from->cpustamp = now;
+
+  elapsed = now - to->cpustamp;
+  to->cpuacct.waittime += elapsed;
+  if (elapsed > UINT32_MAX)
+    {
+      elapsed = UINT32_MAX;
+    }
+
+  if ((uint32_t)elapsed > to->cpuacct.maxlatency)
+    {
+      to->cpuacct.maxlatency = (uint32_t)elapsed;
+    }
+
+  to->cpuacct.nswitches++;
+  to->cpustamp = now;
+}
+
+/****************************************************************************
+ * Name: sched_cpuacct_irqenter and sched_cpuacct_irqleave
+ *
+ * Description:
+ *   Called by irq_dispatch() around the interrupt handler.  The time spent
+ *   in the outermost handler is not counted as run time of the interrupted
+ *   thread but as its interrupt time.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sched_cpuacct_irqenter(void)
+{
+  FAR struct tcb_s *rtcb;
+  uint64_t now;
+
+  if (g_cpuacct_irqnest++ > 0)
+    {
+      return;
+    }
+
+  now  = cpuacct_gettime();
+  rtcb = (FAR struct tcb_s *)g_readytorun.head;
+
+  rtcb->cpuacct.runtime += now - rtcb->cpustamp;
+  rtcb->cpustamp         = now;
+
+  g_cpuacct_irqtcb   = rtcb;
+  g_cpuacct_irqstart = now;
+}
+
+void sched_cpuacct_irqleave(void)
+{
+  FAR struct tcb_s *rtcb;
+  uint64_t now;
+
+  DEBUGASSERT(g_cpuacct_irqnest > 0);
+  if (--g_cpuacct_irqnest > 0)
+    {
+      return;
+    }
+
+  now = cpuacct_gettime();
+  g_cpuacct_irqtcb->cpuacct.irqtime += now - g_cpuacct_irqstart;
+
+  /* The thread that the handler returns to, possibly not the one that was
+   * interrupted, starts running now.
+   */
+
+  rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  rtcb->cpustamp = now;
+}
+
+/****************************************************************************
+ * Name: sched_cpuacct
+ *
+ * Description:
+ *   Return the CPU accounting of a thread, in microseconds.  The run time
+ *   of the running thread and the wait time of a ready-to-run thread
+ *   include the current, not yet accounted for, interval.
+ *
+ * Parameters:
+ *   pid - The task ID of the thread of interest.  pid == 0 is the IDLE
+ *         thread.
+ *   cpuacct - The location to return the CPU accounting.
+ *
+ * Return Value:
+ *   OK (0) on success; -ESRCH if 'pid' does not refer to a valid thread.
+ *
+ ****************************************************************************/
+
+int sched_cpuacct(pid_t pid, FAR struct cpuacct_s *cpuacct)
+{
+  FAR struct tcb_s *tcb;
+  irqstate_t flags;
+  uint64_t elapsed;
+  uint32_t freq;
+
+  DEBUGASSERT(cpuacct);
+
+  /* Disable interrupts so that the TCB stays valid and the counts are
+   * consistent while they are read.
+   */
+
+  flags = irqsave();
+  tcb = sched_gettcb(pid);
+  if (tcb == NULL)
+    {
+      irqrestore(flags);
+      return -ESRCH;
+    }
+
+  *cpuacct = tcb->cpuacct;
+  elapsed  = cpuacct_gettime() - tcb->cpustamp;
+
+  if (tcb->task_state == TSTATE_TASK_RUNNING)
+    {
+      cpuacct->runtime += elapsed;
+    }
+  else if (tcb->task_state == TSTATE_TASK_READYTORUN ||
+           tcb->task_state == TSTATE_TASK_PENDING)
+    {
+      cpuacct->waittime += elapsed;
+    }
+
+  irqrestore(flags);
+
+  freq = cpuacct_getfreq();
+  cpuacct->runtime    = cpuacct_usec(cpuacct->runtime, freq);
+  cpuacct->waittime   = cpuacct_usec(cpuacct->waittime, freq);
+  cpuacct->irqtime    = cpuacct_usec(cpuacct->irqtime, freq);
+  cpuacct->maxlatency = (uint32_t)cpuacct_usec(cpuacct->maxlatency, freq);
+  return OK;
+}
+
+#endif /* CONFIG_SCHED_CPUACCT */
@@ -0,0 +1,336 @@
+/****************************************************************************
+ * sched/sched/sched_note.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/sched_note.h>
+#include <arch/irq.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_NOTE_BUFFER
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SCHED_NOTE_BUFSIZE
+#  define CONFIG_SCHED_NOTE_BUFSIZE 2048
+#endif
+
+#if (CONFIG_SCHED_NOTE_BUFSIZE & (CONFIG_SCHED_NOTE_BUFSIZE - 1)) != 0
+#  error CONFIG_SCHED_NOTE_BUFSIZE must be a power of two
+#endif
+
+#define NOTE_MASK (CONFIG_SCHED_NOTE_BUFSIZE - 1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The notes are stored back to back in g_note_buffer.  g_note_head and
+ * g_note_tail are free running byte counts: the notes between them are
+ * the ones that have not been read yet.  When there is no room for a new
+ * note, the oldest ones are dropped, so that the buffer always holds the
+ * most recent history.
+ *
+ * The notes are added from any context, interrupt handlers included, with
+ * interrupts disabled for the short time needed to copy them; no lock is
+ * ever taken.
+ */
+
+static uint8_t g_note_buffer[CONFIG_SCHED_NOTE_BUFSIZE];
+static unsigned int g_note_head;
+static unsigned int g_note_tail;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline void note_put16(FAR uint8_t *dest, uint16_t value)
+{
+  dest[0] = (uint8_t)value;
+  dest[1] = (uint8_t)(value >> 8);
+}
+
+static inline void note_put32(FAR uint8_t *dest, uint32_t value)
+{
+  dest[0] = (uint8_t)value;
+  dest[1] = (uint8_t)(value >> 8);
+  dest[2] = (uint8_t)(value >> 16);
+  dest[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t note_gettime(void)
+{
+#ifdef CONFIG_ARCH_HAVE_PERF
+  return up_perf_gettime();
+#else
+  return clock_systimer();
+#endif
+}
+
+/****************************************************************************
+ * Name: note_add
+ *
+ * Description:
+ *   Timestamp a note and add it to the buffer, dropping the oldest notes if
+ *   needed.  The timestamp is taken with interrupts disabled so that the
+ *   notes are always in chronological order.
+ *
+ ****************************************************************************/
+
+static void note_add(FAR struct note_common_s *note)
+{
+  FAR const uint8_t *src = (FAR const uint8_t *)note;
+  unsigned int length = note->nc_length;
+  unsigned int head;
+  irqstate_t flags;
+  unsigned int i;
+
+  flags = irqsave();
+
+  note_put32(note->nc_time, note_gettime());
+
+  while (CONFIG_SCHED_NOTE_BUFSIZE - (g_note_head - g_note_tail) < length)
+    {
+      g_note_tail += g_note_buffer[g_note_tail & NOTE_MASK];
+    }
+
+  head = g_note_head;
+  for (i = 0; i < length; i++)
+    {
+      g_note_buffer[head++ & NOTE_MASK] = *src++;
+    }
+
+  g_note_head = head;
+  irqrestore(flags);
+}
+
+static void note_sem(FAR struct tcb_s *tcb, FAR sem_t *sem, uint8_t type)
+{
+  struct note_sem_s note;
+
+  sched_note_common(&note.nsem_cmn, sizeof(note), type, tcb->pid);
+  note_put32(note.nsem_sem, (uint32_t)(uintptr_t)sem);
+  note_add(&note.nsem_cmn);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_note_common
+ *
+ * Description:
+ *   See include/nuttx/sched_note.h.
+ *
+ ****************************************************************************/
+
+void sched_note_common(FAR struct note_common_s *note, size_t length,
+                       uint8_t type, pid_t pid)
+{
+  DEBUGASSERT(length >= sizeof(struct note_common_s) && length <= UINT8_MAX);
+
+  note->nc_length = (uint8_t)length;
+  note->nc_type   = type;
+  note_put16(note->nc_pid, (uint16_t)pid);
+  note_put32(note->nc_time, note_gettime());
+}
+
+/****************************************************************************
+ * Name: sched_note_start, sched_note_stop and sched_note_switch
+ *
+ * Description:
+ *   The scheduler instrumentation hooks, see include/sched.h.
+ *
+ ****************************************************************************/
+
+void sched_note_start(FAR struct tcb_s *tcb)
+{
+  struct note_start_s note;
+  size_t namelen = 0;
+
+#if CONFIG_TASK_NAME_SIZE > 0
+  namelen = strnlen(tcb->name, CONFIG_TASK_NAME_SIZE);
+  memcpy(note.nst_name, tcb->name, namelen);
+#endif
+
+  sched_note_common(&note.nst_cmn, SIZEOF_NOTE_START(namelen), NOTE_START,
+                    tcb->pid);
+  note.nst_priority = tcb->sched_priority;
+  note_add(&note.nst_cmn);
+}
+
+void sched_note_stop(FAR struct tcb_s *tcb)
+{
+  struct note_common_s note;
+
+  sched_note_common(&note, sizeof(note), NOTE_STOP, tcb->pid);
+  note_add(&note);
+}
+
+void sched_note_switch(FAR struct tcb_s *pFromTcb, FAR struct tcb_s *pToTcb)
+{
+  struct note_switch_s note;
+
+  sched_note_common(&note.nsw_cmn, sizeof(note), NOTE_SWITCH, pToTcb->pid);
+  note_put16(note.nsw_prev, (uint16_t)pFromTcb->pid);
+  note_add(&note.nsw_cmn);
+}
+
+/****************************************************************************
+ * Name: sched_note_irqhandler, sched_note_semwait and sched_note_semwake
+ *
+ * Description:
+ *   See include/nuttx/sched_note.h.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_NOTE_IRQHANDLER
+void sched_note_irqhandler(int irq, bool enter)
+{
+  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  struct note_irq_s note;
+
+  sched_note_common(&note.nirq_cmn, sizeof(note),
+                    enter ? NOTE_IRQ_ENTER : NOTE_IRQ_LEAVE, rtcb->pid);
+  note_put16(note.nirq_irq, (uint16_t)irq);
+  note_add(&note.nirq_cmn);
+}
+#endif
+
+#ifdef CONFIG_SCHED_NOTE_SEMAPHORE
+void sched_note_semwait(FAR struct tcb_s *tcb, FAR sem_t *sem)
+{
+  note_sem(tcb, sem, NOTE_SEM_WAIT);
+}
+
+void sched_note_semwake(FAR struct tcb_s *tcb, FAR sem_t *sem)
+{
+  note_sem(tcb, sem, NOTE_SEM_WAKE);
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_note_mark
+ *
+ * Description:
+ *   See include/nuttx/sched_note.h.
+ *
+ ****************************************************************************/
+
+void sched_note_mark(FAR const char *text, size_t len)
+{
+  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  struct note_mark_s note;
+
+  if (len > NOTE_MARK_MAX)
+    {
+      len = NOTE_MARK_MAX;
+    }
+
+  memcpy(note.nmk_text, text, len);
+  sched_note_common(&note.nmk_cmn, SIZEOF_NOTE_MARK(len), NOTE_MARK,
+                    rtcb->pid);
+  note_add(&note.nmk_cmn);
+}
+
+/****************************************************************************
+ * Name: sched_note_get
+ *
+ * Description:
+ *   See include/nuttx/sched_note.h.
+ *
+ ****************************************************************************/
+
+ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen)
+{
+  unsigned int length;
+  unsigned int tail;
+  irqstate_t flags;
+  size_t count = 0;
+
+  flags = irqsave();
+
+  tail = g_note_tail;
+  while (tail != g_note_head)
+    {
+      length = g_note_buffer[tail & NOTE_MASK];
+      if (count + length > buflen)
+        {
+          break;
+        }
+
+      while (length-- > 0)
+        {
+          buffer[count++] = g_note_buffer[tail++ & NOTE_MASK];
+        }
+    }
+
+  g_note_tail = tail;
+  irqrestore(flags);
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: sched_note_getfreq
+ *
+ * Description:
+ *   See include/nuttx/sched_note.h.
+ *
+ ****************************************************************************/
+
+uint32_t sched_note_getfreq(void)
+{
+#ifdef CONFIG_ARCH_HAVE_PERF
+  return up_perf_getfreq();
+#else
+  return CLK_TCK;
+#endif
+}
+
+#endif /* CONFIG_SCHED_NOTE_BUFFER */
@@ -43,6 +43,7 @@
 #include <assert.h>
 
 #include "sched/sched.h"
+#include "semaphore/semaphore.h"
 
 /************************************************************************
  * Definitions
@@ -102,10 +103,24 @@ void sched_removeblocked(FAR struct tcb_s *btcb)
 
   dq_rem((FAR dq_entry_t*)btcb, (dq_queue_t*)g_tasklisttable[task_state].list);
 
+  /* And from the wait queue of the semaphore.  Whatever the reason for
+   * being unblocked, the task is no longer waiting for the semaphore.
+   */
+
+  if (task_state == TSTATE_WAIT_SEM)
+    {
+      sem_removewaiter(btcb);
+      btcb->waitsem = NULL;
+    }
+
   /* Make sure the TCB's state corresponds to not being in
    * any list
    */
 
   btcb->task_state = TSTATE_TASK_INVALID;
+
+  /* From now on, the time until the task runs is counted as wait time */
+
+  sched_cpuacct_ready(btcb);
 }
 
@@ -0,0 +1,220 @@
+/****************************************************************************
+ * sched/sched/sched_rtrbitmap.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <queue.h>
+#include <assert.h>
+
+#include "sched/sched.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RTR_NWORDS ((SCHED_PRIORITY_MAX + 32) / 32)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The g_readytorun list is kept sorted by decreasing priority, and tasks of
+ * the same priority are in FIFO order.  g_rtrbitmap has one bit set for each
+ * priority that has ready-to-run tasks, and g_rtrlast points to the last of
+ * them in the list, which is where the next task of that priority goes.
+ *
+ * The IDLE task is not accounted for: it is always at the end of the list
+ * and never leaves it.
+ */
+
+static uint32_t g_rtrbitmap[RTR_NWORDS];
+static FAR struct tcb_s *g_rtrlast[SCHED_PRIORITY_MAX + 1];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_rtrabove
+ *
+ * Description:
+ *   Find the lowest priority above 'priority' that has ready-to-run tasks.
+ *
+ * Return Value:
+ *   That priority, or -1 if there is none.
+ *
+ ****************************************************************************/
+
+static int sched_rtrabove(int priority)
+{
+  uint32_t bits;
+  int word;
+
+  if (priority >= SCHED_PRIORITY_MAX)
+    {
+      return -1;
+    }
+
+  priority++;
+  word = priority >> 5;
+  bits = g_rtrbitmap[word] & ~(((uint32_t)1 << (priority & 31)) - 1);
+
+  while (!bits)
+    {
+      if (++word >= RTR_NWORDS)
+        {
+          return -1;
+        }
+
+      bits = g_rtrbitmap[word];
+    }
+
+  return (word << 5) + __builtin_ctz(bits);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_rtrinsert
+ *
+ * Description:
+ *   Insert a TCB in the g_readytorun list, after all the tasks of higher or
+ *   equal priority, in constant time.  This is the same position that
+ *   sched_addprioritized() would find by walking the list.
+ *
+ * Inputs:
+ *   tcb - Points to the TCB to add to the ready-to-run list
+ *
+ * Return Value:
+ *   true if the TCB was added at the head of the list.
+ *
+ * Assumptions:
+ * - The caller has established a critical section.
+ * - The caller sets the task_state field of the TCB and handles the
+ *   condition that occurs if the head of the list is changed.
+ *
+ ****************************************************************************/
+
+bool sched_rtrinsert(FAR struct tcb_s *tcb)
+{
+  int priority = tcb->sched_priority;
+  FAR struct tcb_s *prev;
+  FAR struct tcb_s *next;
+  int above;
+
+  ASSERT(priority >= SCHED_PRIORITY_MIN);
+
+  prev = g_rtrlast[priority];
+  if (!prev)
+    {
+      /* First task of this priority: it goes after the tasks of the lowest
+       * priority above it, if any.
+       */
+
+      above = sched_rtrabove(priority);
+      prev  = above < 0 ? NULL : g_rtrlast[above];
+
+      g_rtrbitmap[priority >> 5] |= (uint32_t)1 << (priority & 31);
+    }
+
+  g_rtrlast[priority] = tcb;
+
+  next = prev ? prev->flink : (FAR struct tcb_s *)g_readytorun.head;
+
+  tcb->flink = next;
+  tcb->blink = prev;
+
+  if (next)
+    {
+      next->blink = tcb;
+    }
+  else
+    {
+      g_readytorun.tail = (FAR dq_entry_t *)tcb;
+    }
+
+  if (prev)
+    {
+      prev->flink = tcb;
+      return false;
+    }
+
+  g_readytorun.head = (FAR dq_entry_t *)tcb;
+  return true;
+}
+
+/****************************************************************************
+ * Name: sched_rtrremove
+ *
+ * Description:
+ *   Remove a TCB from the g_readytorun list.
+ *
+ * Inputs:
+ *   tcb - Points to the TCB to remove from the ready-to-run list
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section.
+ * - The priority of the task has not changed since it was inserted.
+ *
+ ****************************************************************************/
+
+void sched_rtrremove(FAR struct tcb_s *tcb)
+{
+  int priority = tcb->sched_priority;
+  FAR struct tcb_s *prev = tcb->blink;
+
+  if (g_rtrlast[priority] == tcb)
+    {
+      if (prev && prev->sched_priority == priority)
+        {
+          g_rtrlast[priority] = prev;
+        }
+      else
+        {
+          g_rtrlast[priority] = NULL;
+          g_rtrbitmap[priority >> 5] &= ~((uint32_t)1 << (priority & 31));
+        }
+    }
+
+  dq_rem((FAR dq_entry_t *)tcb, (FAR dq_queue_t *)&g_readytorun);
+}
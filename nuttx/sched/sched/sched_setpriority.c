@@ -45,6 +45,7 @@
 #include <nuttx/arch.h>
 
 #include "sched/sched.h"
+#include "semaphore/semaphore.h"
 
 /****************************************************************************
  * Definitions
@@ -149,9 +150,20 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 
         else
           {
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+            /* The ready-to-run bitmap is indexed by priority:  the task
+             * must be removed and inserted again around the change.  It
+             * remains at the head of the list.
+             */
+
+            sched_rtrremove(tcb);
+            tcb->sched_priority = (uint8_t)sched_priority;
+            ASSERT(sched_rtrinsert(tcb));
+#else
             /* Change the task priority */
 
             tcb->sched_priority = (uint8_t)sched_priority;
+#endif
           }
         break;
 
@@ -206,6 +218,13 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 
             dq_rem((FAR dq_entry_t*)tcb, (FAR dq_queue_t*)g_tasklisttable[task_state].list);
 
+            /* The wait queue of a semaphore is prioritized too */
+
+            if (task_state == TSTATE_WAIT_SEM)
+              {
+                sem_removewaiter(tcb);
+              }
+
             /* Change the task priority */
 
             tcb->sched_priority = (uint8_t)sched_priority;
@@ -215,6 +234,11 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
              */
 
             sched_addprioritized(tcb, (FAR dq_queue_t*)g_tasklisttable[task_state].list);
+
+            if (task_state == TSTATE_WAIT_SEM)
+              {
+                sem_addwaiter(tcb);
+              }
           }
 
         /* CASE 3b. The task resides in a non-prioritized list. */
@@ -43,6 +43,7 @@
 #include <semaphore.h>
 #include <sched.h>
 #include <nuttx/arch.h>
+#include <nuttx/sched_note.h>
 
 #include "sched/sched.h"
 #include "semaphore/semaphore.h"
@@ -140,24 +141,19 @@ int sem_post(FAR sem_t *sem)
 
       if (sem->semcount <= 0)
         {
-          /* Check if there are any tasks in the waiting for semaphore
-           * task list that are waiting for this semaphore. This is a
-           * prioritized list so the first one we encounter is the one
-           * that we want.
+          /* The tasks waiting for this semaphore are queued on it, in
+           * priority order, so the first one is the one that we want.
            */
 
-          for (stcb = (FAR struct tcb_s*)g_waitingforsemaphore.head;
-               (stcb && stcb->waitsem != sem);
-               stcb = stcb->flink);
-
+          stcb = sem->waitq;
           if (stcb)
             {
-              /* It is, let the task take the semaphore */
-
-              stcb->waitsem = NULL;
-
-              /* Restart the waiting task. */
+              /* Restart the waiting task and let it take the semaphore.
+               * Unblocking the task removes it from the semaphore wait
+               * queue and clears stcb->waitsem.
+               */
 
+              sched_note_semwake(stcb, sem);
               up_unblock_task(stcb);
             }
         }
@@ -44,6 +44,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <nuttx/arch.h>
+#include <nuttx/sched_note.h>
 
 #include "sched/sched.h"
 #include "semaphore/semaphore.h"
@@ -169,6 +170,7 @@ int sem_wait(FAR sem_t *sem)
           /* Add the TCB to the prioritized semaphore wait queue */
 
           set_errno(0);
+          sched_note_semwait(rtcb, sem);
           up_block_task(rtcb, TSTATE_WAIT_SEM);
 
           /* When we resume at this point, either (1) the semaphore has been
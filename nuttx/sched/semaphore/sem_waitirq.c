@@ -125,15 +125,14 @@ void sem_waitirq(FAR struct tcb_s *wtcb, int errcode)
 
       sem->semcount++;
 
-      /* Indicate that the semaphore wait is over. */
-
-      wtcb->waitsem = NULL;
-
       /* Mark the errno value for the thread. */
 
       wtcb->pterrno = errcode;
 
-      /* Restart the task. */
+      /* Restart the task.  This also removes it from the wait queue of the
+       * semaphore and indicates that the semaphore wait is over
+       * (wtcb->waitsem is cleared).
+       */
 
       up_unblock_task(wtcb);
     }
@@ -0,0 +1,164 @@
+/****************************************************************************
+ * sched/semaphore/sem_waitq.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <semaphore.h>
+#include <sched.h>
+#include <assert.h>
+
+#include <arch/irq.h>
+
+#include "sched/sched.h"
+#include "semaphore/semaphore.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sem_addwaiter
+ *
+ * Description:
+ *   Add a task to the wait queue of the semaphore it is waiting for
+ *   (wtcb->waitsem).  The queue is kept in priority order, so that
+ *   sem_post() can wake up the highest priority waiter without searching.
+ *   Tasks of the same priority are kept in FIFO order.
+ *
+ * Parameters:
+ *   wtcb - The TCB of the waiting task
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sem_addwaiter(FAR struct tcb_s *wtcb)
+{
+  FAR struct tcb_s **link;
+
+  DEBUGASSERT(wtcb->waitsem != NULL);
+
+  for (link = &wtcb->waitsem->waitq;
+       *link && (*link)->sched_priority >= wtcb->sched_priority;
+       link = &(*link)->semflink);
+
+  wtcb->semflink = *link;
+  *link = wtcb;
+}
+
+/****************************************************************************
+ * Name: sem_removewaiter
+ *
+ * Description:
+ *   Remove a task from the wait queue of the semaphore it is waiting for
+ *   (wtcb->waitsem).  This is immediate for the highest priority waiter,
+ *   which is the one sem_post() wakes up; other waiters leave the queue
+ *   on a timeout, a signal or a change of priority.
+ *
+ * Parameters:
+ *   wtcb - The TCB of the waiting task
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sem_removewaiter(FAR struct tcb_s *wtcb)
+{
+  FAR struct tcb_s **link;
+
+  DEBUGASSERT(wtcb->waitsem != NULL);
+
+  for (link = &wtcb->waitsem->waitq; *link && *link != wtcb;
+       link = &(*link)->semflink);
+
+  DEBUGASSERT(*link == wtcb);
+  if (*link)
+    {
+      *link = wtcb->semflink;
+    }
+
+  wtcb->semflink = NULL;
+}
+
+/****************************************************************************
+ * Name: sem_recover
+ *
+ * Description:
+ *   This function is called from task_recover() when a task is deleted or
+ *   restarted.  If the task was waiting for a semaphore, it is removed from
+ *   the wait queue of the semaphore and the count that it took is given
+ *   back.
+ *
+ * Parameters:
+ *   tcb - The TCB of the terminated task or thread
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   This function is called from task deletion logic in a safe context.
+ *
+ ****************************************************************************/
+
+void sem_recover(FAR struct tcb_s *tcb)
+{
+  FAR sem_t *sem;
+  irqstate_t flags;
+
+  flags = irqsave();
+  if (tcb->task_state == TSTATE_WAIT_SEM)
+    {
+      sem = tcb->waitsem;
+      DEBUGASSERT(sem != NULL && sem->semcount < 0);
+
+      /* Restore the priority of the holders, as for a canceled wait */
+
+      sem_canceled(tcb, sem);
+      sem->semcount++;
+
+      sem_removewaiter(tcb);
+      tcb->waitsem = NULL;
+    }
+
+  irqrestore(flags);
+}
@@ -97,6 +97,12 @@ void weak_function sem_initialize(void);
 void sem_waitirq(FAR struct tcb_s *wtcb, int errcode);
 FAR nsem_t *sem_findnamed(const char *name);
 
+/* Per-semaphore queues of waiting tasks */
+
+void sem_addwaiter(FAR struct tcb_s *wtcb);
+void sem_removewaiter(FAR struct tcb_s *wtcb);
+void sem_recover(FAR struct tcb_s *tcb);
+
 /* Special logic needed only by priority inheritance to manage collections of
  * holders of semaphores.
  */
@@ -43,6 +43,7 @@
 #include <nuttx/wdog.h>
 #include <nuttx/sched.h>
 
+#include "semaphore/semaphore.h"
 #include "mqueue/mqueue.h"
 #include "task/task.h"
 
@@ -79,8 +80,8 @@
  *
  * Description:
  *   This function is called when a task is deleted via task_deleted or
- *   via pthread_cancel. I checks if the task was waiting for a message
- *   queue event and adjusts counts appropriately.
+ *   via pthread_cancel. I checks if the task was waiting for a semaphore
+ *   or a message queue event and adjusts counts appropriately.
  *
  * Inputs:
  *   tcb - The TCB of the terminated task or thread
@@ -114,6 +115,10 @@ void task_recover(FAR struct tcb_s *tcb)
 
   irqrestore(flags);
 
+  /* Handle cases where the thread was waiting for a semaphore */
+
+  sem_recover(tcb);
+
   /* Handle cases where the thread was waiting for a message queue event */
 
 #ifndef CONFIG_DISABLE_MQUEUE
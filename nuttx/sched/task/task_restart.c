@@ -160,8 +160,16 @@ int task_restart(pid_t pid)
        */
 
       state = irqsave();
-      dq_rem((FAR dq_entry_t*)tcb,
-             (dq_queue_t*)g_tasklisttable[tcb->cmn.task_state].list);
+      if (tcb->cmn.task_state == TSTATE_TASK_READYTORUN)
+        {
+          sched_rtrremove((FAR struct tcb_s *)tcb);
+        }
+      else
+        {
+          dq_rem((FAR dq_entry_t*)tcb,
+                 (dq_queue_t*)g_tasklisttable[tcb->cmn.task_state].list);
+        }
+
       tcb->cmn.task_state = TSTATE_TASK_INVALID;
       irqrestore(state);
 
@@ -91,8 +91,14 @@
 
 int wd_cancel(WDOG_ID wdog)
 {
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+#ifdef CONFIG_SCHED_TICKLESS
+  unsigned int next;
+#endif
+#else
   FAR struct wdog_s *curr;
   FAR struct wdog_s *prev;
+#endif
   irqstate_t state;
   int ret = ERROR;
 
@@ -108,6 +114,26 @@ int wd_cancel(WDOG_ID wdog)
 
   if (wdog && WDOG_ISACTIVE(wdog))
     {
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+#ifdef CONFIG_SCHED_TICKLESS
+      next = wd_wheel_next();
+#endif
+
+      /* Remove the watchdog from its slot of the timing wheel */
+
+      wd_wheel_remove(wdog);
+
+#ifdef CONFIG_SCHED_TICKLESS
+      /* Reassess the interval timer if the next event of the wheel was
+       * that watchdog.
+       */
+
+      if (wd_wheel_next() != next)
+        {
+          sched_timer_reassess();
+        }
+#endif
+#else
       /* Search the g_wdactivelist for the target FCB.  We can't use sq_rem
        * to do this because there are additional operations that need to be
        * done.
@@ -157,6 +183,7 @@ int wd_cancel(WDOG_ID wdog)
 
           sched_timer_reassess();
         }
+#endif
 
       /* Mark the watchdog inactive */
 
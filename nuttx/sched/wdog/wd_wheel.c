@@ -0,0 +1,404 @@
+/****************************************************************************
+ * sched/wdog/wd_wheel.c
+ *
+ * Copyright (c) 2015 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <nuttx/wdog.h>
+
+#include "wdog/wdog.h"
+
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The wheel is made of WHEEL_LEVELS levels of 32 slots each, except for the
+ * last one that only covers the two most significant bits of the time and
+ * has 4 slots.  Level n slots are 32^n ticks wide.
+ */
+
+#define WHEEL_BITS         5
+#define WHEEL_SLOTS        (1 << WHEEL_BITS)
+#define WHEEL_LEVELS       7
+#define WHEEL_TOP          (WHEEL_LEVELS - 1)
+#define WHEEL_TOP_SLOTS    (1 << (32 - WHEEL_TOP * WHEEL_BITS))
+
+#define WHEEL_NSLOTS(l)    ((l) < WHEEL_TOP ? WHEEL_SLOTS : WHEEL_TOP_SLOTS)
+#define WHEEL_SHIFT(l)     ((l) * WHEEL_BITS)
+#define WHEEL_INDEX(l,t)   (((t) >> WHEEL_SHIFT(l)) & (WHEEL_NSLOTS(l) - 1))
+#define WHEEL_LOWMASK(l)   (((uint32_t)1 << WHEEL_SHIFT(l)) - 1)
+
+/* Watchdogs that have expired but have not been run yet are kept in an
+ * additional slot after the ones of the wheel.
+ */
+
+#define WHEEL_EXPIRED      (WHEEL_TOP * WHEEL_SLOTS + WHEEL_TOP_SLOTS)
+#define WHEEL_NHEADS       (WHEEL_EXPIRED + 1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Each active watchdog is in one slot of the wheel, in a doubly linked list
+ * whose head 'prev' link points to its tail.  The level of the slot is the
+ * one of the most significant bit that differs between the expiration time
+ * and the current time, so the watchdogs of a level all expire before the
+ * level above wraps around, and g_wdmap has one bit set for each slot that
+ * is not empty.
+ *
+ * When the time reaches the start of a slot of a level above 0, the slot is
+ * cascaded: its watchdogs are moved to the lower levels.  When the time
+ * reaches a slot of level 0, its watchdogs expire.
+ */
+
+static FAR struct wdog_s *g_wdwheel[WHEEL_NHEADS];
+static uint32_t g_wdmap[WHEEL_LEVELS];
+
+/* The time of the wheel, in ticks.  It is only advanced by wd_timer(). */
+
+static uint32_t g_wdnow;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_add
+ *
+ * Description:
+ *   Append a watchdog to the slot matching its expiration time, which is in
+ *   its lag field.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_add(FAR struct wdog_s *wdog)
+{
+  FAR struct wdog_s *head;
+  uint32_t expiry = (uint32_t)wdog->lag;
+  uint32_t diff = expiry ^ g_wdnow;
+  int level;
+  int slot;
+
+  if (diff == 0)
+    {
+      slot = WHEEL_EXPIRED;
+    }
+  else
+    {
+      level = (31 - __builtin_clz(diff)) / WHEEL_BITS;
+      slot = level * WHEEL_SLOTS + WHEEL_INDEX(level, expiry);
+      g_wdmap[level] |= (uint32_t)1 << (slot - level * WHEEL_SLOTS);
+    }
+
+  head = g_wdwheel[slot];
+  wdog->next = NULL;
+  wdog->slot = slot;
+
+  if (head)
+    {
+      head->prev->next = wdog;
+      wdog->prev = head->prev;
+      head->prev = wdog;
+    }
+  else
+    {
+      wdog->prev = wdog;
+      g_wdwheel[slot] = wdog;
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_process
+ *
+ * Description:
+ *   Cascade the slot of a level that starts at the current time, or expire
+ *   it for level 0.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_process(int level)
+{
+  FAR struct wdog_s *wdog;
+  FAR struct wdog_s *next;
+  int index = WHEEL_INDEX(level, g_wdnow);
+  int slot = level * WHEEL_SLOTS + index;
+
+  if ((g_wdmap[level] & ((uint32_t)1 << index)) == 0)
+    {
+      return;
+    }
+
+  wdog = g_wdwheel[slot];
+  g_wdwheel[slot] = NULL;
+  g_wdmap[level] &= ~((uint32_t)1 << index);
+
+  for (; wdog; wdog = next)
+    {
+      next = wdog->next;
+      wd_wheel_add(wdog);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_initialize
+ *
+ * Description:
+ *   Initialize the timing wheel.  It is called by wd_initialize().
+ *
+ ****************************************************************************/
+
+void wd_wheel_initialize(void)
+{
+  int i;
+
+  for (i = 0; i < WHEEL_NHEADS; i++)
+    {
+      g_wdwheel[i] = NULL;
+    }
+
+  for (i = 0; i < WHEEL_LEVELS; i++)
+    {
+      g_wdmap[i] = 0;
+    }
+
+  g_wdnow = 0;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_insert
+ *
+ * Description:
+ *   Insert a watchdog in the timing wheel, to expire after 'delay' ticks.
+ *
+ * Assumptions:
+ *   Interrupts are disabled and delay is strictly positive.
+ *
+ ****************************************************************************/
+
+void wd_wheel_insert(FAR struct wdog_s *wdog, int delay)
+{
+  DEBUGASSERT(delay > 0);
+
+  wdog->lag = (int)(g_wdnow + (uint32_t)delay);
+  wd_wheel_add(wdog);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_remove
+ *
+ * Description:
+ *   Remove a watchdog from the timing wheel.
+ *
+ * Assumptions:
+ *   Interrupts are disabled and the watchdog is in the wheel.
+ *
+ ****************************************************************************/
+
+void wd_wheel_remove(FAR struct wdog_s *wdog)
+{
+  FAR struct wdog_s *head = g_wdwheel[wdog->slot];
+  int level = wdog->slot / WHEEL_SLOTS;
+
+  DEBUGASSERT(head != NULL);
+
+  if (wdog == head)
+    {
+      g_wdwheel[wdog->slot] = wdog->next;
+      if (wdog->next)
+        {
+          wdog->next->prev = wdog->prev;
+        }
+      else if (wdog->slot != WHEEL_EXPIRED)
+        {
+          g_wdmap[level] &= ~((uint32_t)1 << (wdog->slot % WHEEL_SLOTS));
+        }
+    }
+  else
+    {
+      wdog->prev->next = wdog->next;
+      if (wdog->next)
+        {
+          wdog->next->prev = wdog->prev;
+        }
+      else
+        {
+          head->prev = wdog->prev;
+        }
+    }
+
+  wdog->next = NULL;
+  wdog->prev = NULL;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_remaining
+ *
+ * Description:
+ *   Return the number of ticks before a watchdog of the wheel expires.
+ *
+ ****************************************************************************/
+
+int wd_wheel_remaining(FAR struct wdog_s *wdog)
+{
+  return (int)((uint32_t)wdog->lag - g_wdnow);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_next
+ *
+ * Description:
+ *   Return the number of ticks until the wheel needs to be advanced, or
+ *   zero if no watchdog is active.  This is the expiration time of the next
+ *   watchdog, unless a slot of the upper levels has to be cascaded before.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+unsigned int wd_wheel_next(void)
+{
+  uint32_t next = 0;
+  uint32_t delay;
+  uint32_t map;
+  int level;
+  int cur;
+  int slot;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+      if (g_wdmap[level] == 0)
+        {
+          continue;
+        }
+
+      /* Find the first slot after the current one.  Only the top level can
+       * wrap around.
+       */
+
+      cur = WHEEL_INDEX(level, g_wdnow);
+      map = g_wdmap[level] & ~(((uint32_t)2 << cur) - 1);
+      slot = __builtin_ctz(map ? map : g_wdmap[level]);
+
+      delay = (((uint32_t)(slot - cur) & (WHEEL_NSLOTS(level) - 1)) <<
+               WHEEL_SHIFT(level)) - (g_wdnow & WHEEL_LOWMASK(level));
+
+      if (next == 0 || delay < next)
+        {
+          next = delay;
+        }
+    }
+
+  return next;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_advance
+ *
+ * Description:
+ *   Advance the time of the wheel by 'ticks', moving the watchdogs that
+ *   expire on the way to the expired list, in order.  Only the slots that
+ *   are not empty are visited, so this does not depend on the number of
+ *   ticks.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void wd_wheel_advance(unsigned int ticks)
+{
+  uint32_t delay;
+  int level;
+
+  while (ticks > 0)
+    {
+      delay = wd_wheel_next();
+      if (delay == 0 || delay > ticks)
+        {
+          g_wdnow += ticks;
+          break;
+        }
+
+      g_wdnow += delay;
+      ticks   -= delay;
+
+      /* Cascade the upper levels first so that the watchdogs that were
+       * started first also run first.
+       */
+
+      for (level = WHEEL_TOP; level >= 0; level--)
+        {
+          if ((g_wdnow & WHEEL_LOWMASK(level)) == 0)
+            {
+              wd_wheel_process(level);
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_expired
+ *
+ * Description:
+ *   Remove and return the first expired watchdog, NULL if there is none.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expired(void)
+{
+  FAR struct wdog_s *wdog = g_wdwheel[WHEEL_EXPIRED];
+
+  if (wdog)
+    {
+      wd_wheel_remove(wdog);
+    }
+
+  return wdog;
+}
+
+#endif /* CONFIG_WDOG_TIMING_WHEEL */
@@ -74,12 +74,14 @@ extern "C"
 
 extern sq_queue_t g_wdfreelist;
 
+#ifndef CONFIG_WDOG_TIMING_WHEEL
 /* The g_wdactivelist data structure is a singly linked list ordered by
  * watchdog expiration time. When watchdog timers expire,the functions on
  * this linked list are removed and the function is called.
  */
 
 extern sq_queue_t g_wdactivelist;
+#endif
 
 /* This is the number of free, pre-allocated watchdog structures in the
  * g_wdfreelist.  This value is used to enforce a reserve for interrupt
@@ -144,6 +146,26 @@ unsigned int wd_timer(int ticks);
 void wd_timer(void);
 #endif
 
+/****************************************************************************
+ * Timing wheel
+ *
+ * With CONFIG_WDOG_TIMING_WHEEL, the active watchdogs are kept in a
+ * hierarchical timing wheel instead of g_wdactivelist, so that starting and
+ * cancelling a watchdog do not depend on the number of active watchdogs.
+ * These functions are all called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMING_WHEEL
+void wd_wheel_initialize(void);
+void wd_wheel_insert(FAR struct wdog_s *wdog, int delay);
+void wd_wheel_remove(FAR struct wdog_s *wdog);
+int wd_wheel_remaining(FAR struct wdog_s *wdog);
+unsigned int wd_wheel_next(void);
+void wd_wheel_advance(unsigned int ticks);
+FAR struct wdog_s *wd_wheel_expired(void);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
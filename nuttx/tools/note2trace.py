@@ -0,0 +1,176 @@
+#!/usr/bin/env python
+############################################################################
+# tools/note2trace.py
+#
+# Copyright (c) 2015 Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+# 3. Neither the name of the copyright holder nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+"""Convert the scheduler notes read from /dev/note to a Chrome trace.
+
+The notes are saved on the target with, e.g.:
+
+    nsh> cp /dev/note /mnt/note.bin
+
+and converted on the host with:
+
+    $ tools/note2trace.py note.bin > trace.json
+
+The result can be opened in chrome://tracing or https://ui.perfetto.dev.
+Each task is a thread, interrupt handlers run on a separate "Interrupts"
+thread, semaphore waits and markers are instant events.
+
+The timestamps are 32-bit counters that wrap around: the notes must not be
+more than one wrap period apart (about 44 seconds at 96 MHz).
+"""
+
+import json
+import struct
+import sys
+
+NOTE_INFO = 0
+NOTE_START = 1
+NOTE_STOP = 2
+NOTE_SWITCH = 3
+NOTE_IRQ_ENTER = 4
+NOTE_IRQ_LEAVE = 5
+NOTE_SEM_WAIT = 6
+NOTE_SEM_WAKE = 7
+NOTE_MARK = 8
+NOTE_TASK = 9
+
+IRQ_TID = 65536
+
+
+class Clock(object):
+    """Extend the 32-bit timestamps and convert them to microseconds"""
+
+    def __init__(self):
+        self.freq = None
+        self.last = None
+        self.base = 0
+
+    def usec(self, time):
+        if self.last is not None and time < self.last:
+            self.base += 1 << 32
+        self.last = time
+        return (self.base + time) * 1000000.0 / (self.freq or 1000000)
+
+
+def parse(data):
+    """Yield (type, pid, time, payload) for each note of data"""
+
+    offset = 0
+    while offset + 8 <= len(data):
+        length, type = struct.unpack_from('<BB', data, offset)
+        if length < 8 or offset + length > len(data):
+            sys.stderr.write('truncated note at offset %d\n' % offset)
+            return
+        pid, time = struct.unpack_from('<HI', data, offset + 2)
+        yield type, pid, time, data[offset + 8:offset + length]
+        offset += length
+
+
+def convert(data):
+    clock = Clock()
+    events = []
+    names = {}
+    running = None
+    irqs = []
+
+    def event(ph, name, tid, ts, **kwargs):
+        e = {'ph': ph, 'name': name, 'pid': 0, 'tid': tid, 'ts': ts}
+        e.update(kwargs)
+        events.append(e)
+
+    for type, pid, time, payload in parse(data):
+        # The NOTE_INFO and NOTE_TASK notes are generated when /dev/note
+        # is opened, so their timestamps are not in sequence.
+
+        if type == NOTE_INFO:
+            clock.freq = struct.unpack('<I', payload[:4])[0]
+            continue
+        if type == NOTE_TASK:
+            names.setdefault(pid, payload[1:].decode('ascii', 'replace'))
+            continue
+
+        ts = clock.usec(time)
+
+        if type == NOTE_START:
+            names[pid] = payload[1:].decode('ascii', 'replace')
+            event('i', 'start (priority %d)' % ord(payload[0:1]), pid, ts,
+                  s='t')
+        elif type == NOTE_STOP:
+            if running == pid:
+                event('E', 'running', pid, ts)
+                running = None
+            event('i', 'stop', pid, ts, s='t')
+        elif type == NOTE_SWITCH:
+            if running is not None:
+                event('E', 'running', running, ts)
+            event('B', 'running', pid, ts)
+            running = pid
+        elif type == NOTE_IRQ_ENTER:
+            irq = struct.unpack('<H', payload[:2])[0]
+            irqs.append(irq)
+            event('B', 'irq %d' % irq, IRQ_TID, ts)
+        elif type == NOTE_IRQ_LEAVE:
+            irq = struct.unpack('<H', payload[:2])[0]
+            if irq in irqs:
+                irqs.remove(irq)
+                event('E', 'irq %d' % irq, IRQ_TID, ts)
+        elif type in (NOTE_SEM_WAIT, NOTE_SEM_WAKE):
+            sem = struct.unpack('<I', payload[:4])[0]
+            what = 'wait' if type == NOTE_SEM_WAIT else 'wake'
+            event('i', 'sem %s 0x%08x' % (what, sem), pid, ts, s='t')
+        elif type == NOTE_MARK:
+            event('i', payload.decode('ascii', 'replace'), pid, ts, s='t')
+        else:
+            sys.stderr.write('unknown note type %d\n' % type)
+
+    for pid, name in names.items():
+        event('M', 'thread_name', pid, 0, args={'name': '%s [%d]' % (name, pid)})
+    event('M', 'thread_name', IRQ_TID, 0, args={'name': 'Interrupts'})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ns'}
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write('usage: %s <note file>\n' % sys.argv[0])
+        return 1
+
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+
+    json.dump(convert(data), sys.stdout, indent=1)
+    sys.stdout.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())